@@ -67,7 +67,7 @@ void CAChannel::connect(bool isConnected)
          Lock lock(requestsMutex);
          channelConnected = isConnected;
     }
-    channelConnectThread->channelConnected(notifyChannelRequester);
+    channelConnectThread->channelConnected(notifyChannelRequester, this);
 }
 
 void CAChannel::notifyClient()
@@ -346,9 +346,8 @@ void CAChannel::addMonitor(CAChannelMonitorPtr const & monitor)
     std::vector<CAChannelMonitorWPtr>::iterator it;
     for(it = monitorlist.begin(); it!=monitorlist.end(); ++it)
     {
-         CAChannelMonitorWPtr mon = *it;
-         if(mon.lock()) continue;
-         mon = monitor;
+         if((*it).lock()) continue;
+         *it = monitor;
          return;
     }
     monitorlist.push_back(monitor);
@@ -433,6 +432,12 @@ void CAChannel::attachContext()
     throw  std::runtime_error(mess);
 }
 
+void CAChannel::requestFlush()
+{
+    CAChannelProviderPtr provider(channelProvider.lock());
+    if(provider) provider->requestFlush();
+}
+
 CAChannelGetPtr CAChannelGet::create(
     CAChannel::shared_pointer const & channel,
     ChannelGetRequester::shared_pointer const & channelGetRequester,
@@ -503,7 +508,7 @@ void CAChannelGet::getDone(struct event_handler_args &args)
     ChannelGetRequester::shared_pointer getRequester(channelGetRequester.lock());
     if(!getRequester) return;
     getStatus = dbdToPv->getFromDBD(pvStructure,bitSet,args);
-    getDoneThread->getDone(notifyGetRequester);
+    getDoneThread->getDone(notifyGetRequester, channel.get());
 }
 
 void CAChannelGet::notifyClient()
@@ -530,7 +535,7 @@ void CAChannelGet::get()
          channel->getChannelID(), ca_get_handler, this);
     if (result == ECA_NORMAL)
     {
-        result = ca_flush_io();
+        channel->requestFlush();
     }
     if (result != ECA_NORMAL)
     {
@@ -663,7 +668,7 @@ void CAChannelPut::putDone(struct event_handler_args &args)
     } else {
         putStatus = Status::Ok;
     }
-    putDoneThread->putDone(notifyPutRequester);
+    putDoneThread->putDone(notifyPutRequester, channel.get());
 }
 
 void CAChannelPut::getDone(struct event_handler_args &args)
@@ -675,7 +680,7 @@ void CAChannelPut::getDone(struct event_handler_args &args)
     ChannelPutRequester::shared_pointer putRequester(channelPutRequester.lock());
     if(!putRequester) return;
     getStatus = dbdToPv->getFromDBD(pvStructure,bitSet,args);
-    putDoneThread->putDone(notifyPutRequester);
+    putDoneThread->putDone(notifyPutRequester, channel.get());
 }
 
 void CAChannelPut::notifyClient()
@@ -709,7 +714,7 @@ void CAChannelPut::get()
          channel->getChannelID(), ca_put_get_handler, this);
     if (result == ECA_NORMAL)
     {
-        result = ca_flush_io();
+        channel->requestFlush();
     }
     if (result != ECA_NORMAL)
     {
@@ -740,8 +745,8 @@ void CAChannelPut::lastRequest()
 
 static void ca_subscription_handler(struct event_handler_args args)
 {
-    CAChannelMonitor *channelMonitor = static_cast<CAChannelMonitor*>(args.usr);
-    channelMonitor->subscriptionEvent(args);
+    CASubscription *subscription = static_cast<CASubscription*>(args.usr);
+    subscription->subscriptionEvent(args);
 }
 
 class CACMonitorQueue :
@@ -833,7 +838,6 @@ CAChannelMonitor::CAChannelMonitor(
     pvRequest(pvRequest),
     isStarted(false),
     monitorEventThread(MonitorEventThread::get()),
-    pevid(NULL),
     eventMask(DBE_VALUE | DBE_ALARM)
 {}
 
@@ -889,7 +893,9 @@ void CAChannelMonitor::activate()
 
 std::string CAChannelMonitor::getRequesterName() { return "CAChannelMonitor";}
 
-void CAChannelMonitor::subscriptionEvent(struct event_handler_args &args)
+void CAChannelMonitor::subscriptionEvent(
+    PVStructurePtr const & pvStructure,
+    BitSet const & changed)
 {
     if(DEBUG_LEVEL>1) {
         std::cout << "CAChannelMonitor::subscriptionEvent "
@@ -901,24 +907,14 @@ void CAChannelMonitor::subscriptionEvent(struct event_handler_args &args)
     }
     MonitorRequester::shared_pointer requester(monitorRequester.lock());
     if(!requester) return;
-    Status status = dbdToPv->getFromDBD(pvStructure,activeElement->changedBitSet,args);
-    if(status.isOK())
-    {
-        if(monitorQueue->event(pvStructure,activeElement)) {
-             activeElement->changedBitSet->clear();
-             activeElement->overrunBitSet->clear();
-        } else {
-            *(activeElement->overrunBitSet) |= *(activeElement->changedBitSet);
-        }
-        monitorEventThread->event(notifyMonitorRequester);
-    }
-    else
-    {
-        string mess("CAChannelMonitor::subscriptionEvent ");
-        mess += channel->getChannelName();
-        mess += ca_message(args.status);
-        throw  std::runtime_error(mess);
+    *(activeElement->changedBitSet) |= changed;
+    if(monitorQueue->event(pvStructure,activeElement)) {
+         activeElement->changedBitSet->clear();
+         activeElement->overrunBitSet->clear();
+    } else {
+        *(activeElement->overrunBitSet) |= *(activeElement->changedBitSet);
     }
+    monitorEventThread->event(notifyMonitorRequester, channel.get());
 }
 
 
@@ -948,20 +944,11 @@ Status CAChannelMonitor::start()
         isStarted = true;
         monitorQueue->start();
     }
-    channel->attachContext();
-    int result = ca_create_subscription(dbdToPv->getRequestType(),
-         0,
-         channel->getChannelID(), eventMask,
-         ca_subscription_handler, this,
-         &pevid);
-    if (result == ECA_NORMAL)
-    {
-        result = ca_flush_io();
-    }
-    if (result == ECA_NORMAL) return status;
+    status = CASubscription::subscribe(channel, shared_from_this(), dbdToPv, eventMask, subscription);
+    if (status.isOK()) return status;
+    Lock lock(mutex);
     isStarted = false;
-    string message(ca_message(result));
-    return Status(Status::STATUSTYPE_ERROR,message);
+    return status;
 }
 
 Status CAChannelMonitor::stop()
@@ -978,9 +965,10 @@ Status CAChannelMonitor::stop()
          isStarted = false;
     }
     monitorQueue->stop();
-    int result = ca_clear_subscription(pevid);
-    if(result==ECA_NORMAL) return Status::Ok;
-    return Status(Status::STATUSTYPE_ERROR,string(ca_message(result)));
+    CASubscriptionPtr sub;
+    sub.swap(subscription);
+    if(!sub) return Status::Ok;
+    return sub->unsubscribe(this);
 }
 
 
@@ -1013,4 +1001,176 @@ void CAChannelMonitor::cancel()
 }
 
 
+/* --------------- CASubscription --------------- */
+
+CASubscription::CASubscription(
+    CAChannelProviderPtr const & provider,
+    std::string const & channelName,
+    DbdToPvPtr const & dbdToPv,
+    unsigned long eventMask)
+:
+    provider(provider),
+    channelName(channelName),
+    dbdToPv(dbdToPv),
+    eventMask(eventMask),
+    pvStructure(dbdToPv->createPVStructure()),
+    changed(new BitSet()),
+    hasValue(false),
+    pevid(NULL)
+{}
+
+bool CASubscription::matches(
+    std::string const & channelName,
+    DbdToPvPtr const & dbdToPv,
+    unsigned long eventMask) const
+{
+    return this->channelName==channelName
+        && this->eventMask==eventMask
+        && this->dbdToPv->getRequestType()==dbdToPv->getRequestType()
+        && *pvStructure->getStructure()==*dbdToPv->getStructure();
+}
+
+Status CASubscription::subscribe(
+    CAChannelPtr const & channel,
+    CAChannelMonitorPtr const & monitor,
+    DbdToPvPtr const & dbdToPv,
+    unsigned long eventMask,
+    CASubscriptionPtr & subscription)
+{
+    CAChannelProviderPtr provider(std::tr1::static_pointer_cast<CAChannelProvider>(channel->getProvider()));
+    if(!provider) return Status(Status::STATUSTYPE_ERROR, "provider destroyed");
+
+    Lock registry(provider->subscriptionsMutex);
+    std::vector<CASubscriptionWPtr>& subscriptions(provider->subscriptions);
+    CASubscriptionPtr sub;
+    for(size_t i=0; i<subscriptions.size() && !sub; ) {
+        CASubscriptionPtr other(subscriptions[i].lock());
+        if(!other) {
+            subscriptions.erase(subscriptions.begin()+i);
+            continue;
+        }
+        if(other->matches(channel->getChannelName(), dbdToPv, eventMask)) sub = other;
+        i++;
+    }
+    if(!sub) {
+        sub.reset(new CASubscription(provider, channel->getChannelName(), dbdToPv, eventMask));
+        channel->attachContext();
+        int result = ca_create_subscription(dbdToPv->getRequestType(),
+             0,
+             channel->getChannelID(), eventMask,
+             ca_subscription_handler, sub.get(),
+             &sub->pevid);
+        if (result == ECA_NORMAL)
+        {
+            channel->requestFlush();
+        }
+        if (result != ECA_NORMAL) return Status(Status::STATUSTYPE_ERROR,string(ca_message(result)));
+        sub->owner = channel;
+        subscriptions.push_back(sub);
+    }
+    {
+        Lock lock(sub->mutex);
+        Member member;
+        member.monitor = monitor.get();
+        member.weak = monitor;
+        member.channel = channel;
+        sub->members.push_back(member);
+        if(sub->hasValue) {
+            // CA sends nothing new to a late joiner
+            BitSet all;
+            all.set(0);
+            monitor->subscriptionEvent(sub->pvStructure, all);
+        }
+    }
+    subscription = sub;
+    return Status::Ok;
+}
+
+Status CASubscription::unsubscribe(CAChannelMonitor *monitor)
+{
+    CAChannelProviderPtr provider(this->provider.lock());
+    // the provider destroys the CA context, and with it all subscriptions
+    if(!provider) return Status::Ok;
+
+    Lock registry(provider->subscriptionsMutex);
+    CAChannelPtr newOwner;
+    bool last = false;
+    {
+        Lock lock(mutex);
+        for(size_t i=0; i<members.size(); i++) {
+            if(members[i].monitor!=monitor) continue;
+            members.erase(members.begin()+i);
+            break;
+        }
+        last = members.empty();
+        if(!last) {
+            // the channel of the CA subscription is only kept while one of its monitors remains.
+            bool ownerRemains = false;
+            for(size_t i=0; i<members.size() && !ownerRemains; i++)
+                ownerRemains = members[i].channel==owner;
+            if(!ownerRemains) newOwner = members.front().channel;
+        }
+    }
+    evid clear = NULL;
+    int result = ECA_NORMAL;
+    if(last) {
+        std::vector<CASubscriptionWPtr>& subscriptions(provider->subscriptions);
+        for(size_t i=0; i<subscriptions.size(); i++) {
+            if(subscriptions[i].lock().get()!=this) continue;
+            subscriptions.erase(subscriptions.begin()+i);
+            break;
+        }
+        clear = pevid;
+        pevid = NULL;
+    } else if(newOwner) {
+        // move to a channel which remains.  CA sends its current value again.
+        evid next = NULL;
+        newOwner->attachContext();
+        result = ca_create_subscription(dbdToPv->getRequestType(),
+             0,
+             newOwner->getChannelID(), eventMask,
+             ca_subscription_handler, this,
+             &next);
+        if (result == ECA_NORMAL)
+        {
+            clear = pevid;
+            pevid = next;
+            newOwner->requestFlush();
+        } else {
+            newOwner.reset();
+        }
+    }
+    if(clear) {
+        owner->attachContext();
+        int cleared = ca_clear_subscription(clear);
+        if(result==ECA_NORMAL) result = cleared;
+    }
+    if(last) owner.reset();
+    else if(newOwner) owner = newOwner;
+    if(result==ECA_NORMAL) return Status::Ok;
+    return Status(Status::STATUSTYPE_ERROR,string(ca_message(result)));
+}
+
+void CASubscription::subscriptionEvent(struct event_handler_args &args)
+{
+    if(DEBUG_LEVEL>1) {
+        std::cout << "CASubscription::subscriptionEvent " << channelName << endl;
+    }
+    Lock lock(mutex);
+    changed->clear();
+    Status status = dbdToPv->getFromDBD(pvStructure,changed,args);
+    if(!status.isOK())
+    {
+        string mess("CAChannelMonitor::subscriptionEvent ");
+        mess += channelName;
+        mess += ca_message(args.status);
+        throw  std::runtime_error(mess);
+    }
+    hasValue = true;
+    for(size_t i=0; i<members.size(); i++) {
+        CAChannelMonitorPtr monitor(members[i].weak.lock());
+        if(monitor) monitor->subscriptionEvent(pvStructure, *changed);
+    }
+}
+
 }}}
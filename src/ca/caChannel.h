@@ -66,6 +66,8 @@ typedef std::tr1::weak_ptr<CAChannelGet> CAChannelGetWPtr;
 class CAChannelMonitor;
 typedef std::tr1::shared_ptr<CAChannelMonitor> CAChannelMonitorPtr;
 typedef std::tr1::weak_ptr<CAChannelMonitor> CAChannelMonitorWPtr;
+class CASubscription;
+typedef std::tr1::shared_ptr<CASubscription> CASubscriptionPtr;
 
 class CAChannelGetField :
     public std::tr1::enable_shared_from_this<CAChannelGetField>
@@ -118,6 +120,8 @@ public:
     virtual void printInfo(std::ostream& out);
 
     void attachContext();
+    //! Flush CA requests soon.  See CAChannelProvider::requestFlush()
+    void requestFlush();
     void disconnectChannel();
     void connect(bool isConnected);
     void notifyClient();
@@ -243,7 +247,9 @@ public:
             MonitorRequester::shared_pointer const & monitorRequester,
             epics::pvData::PVStructurePtr const & pvRequest);
     virtual ~CAChannelMonitor();
-    void subscriptionEvent(struct event_handler_args &args);
+    void subscriptionEvent(
+        epics::pvData::PVStructurePtr const & pvStructure,
+        epics::pvData::BitSet const & changed);
 
     virtual epics::pvData::Status start();
     virtual epics::pvData::Status stop();
@@ -263,7 +269,7 @@ private:
     const epics::pvData::PVStructure::shared_pointer pvRequest;
     bool isStarted;
     MonitorEventThreadPtr monitorEventThread;
-    evid pevid;
+    CASubscriptionPtr subscription;
     unsigned long eventMask;
     NotifyMonitorRequesterPtr notifyMonitorRequester;
 
@@ -275,6 +281,62 @@ private:
     CACMonitorQueuePtr monitorQueue;
 };
 
+/**
+ * One CA subscription, shared by the started CAChannelMonitors of a CAChannelProvider
+ * which monitor the same PV with the same DBR type, event mask, and PVStructure type.
+ * Each update is converted once, then queued to each monitor.
+ * A monitor which joins after the first update is sent the current value.
+ */
+class CASubscription
+{
+public:
+    POINTER_DEFINITIONS(CASubscription);
+    /**
+     * Join, or create, the subscription matching a monitor.
+     * @param subscription Set on success.  Pass to unsubscribe() when the monitor stops.
+     */
+    static epics::pvData::Status subscribe(
+        CAChannelPtr const & channel,
+        CAChannelMonitorPtr const & monitor,
+        DbdToPvPtr const & dbdToPv,
+        unsigned long eventMask,
+        CASubscriptionPtr & subscription);
+    epics::pvData::Status unsubscribe(CAChannelMonitor *monitor);
+    void subscriptionEvent(struct event_handler_args &args);
+private:
+    CASubscription(
+        CAChannelProviderPtr const & provider,
+        std::string const & channelName,
+        DbdToPvPtr const & dbdToPv,
+        unsigned long eventMask);
+    bool matches(
+        std::string const & channelName,
+        DbdToPvPtr const & dbdToPv,
+        unsigned long eventMask) const;
+
+    const CAChannelProviderWPtr provider;
+    const std::string channelName;
+    const DbdToPvPtr dbdToPv;
+    const unsigned long eventMask;
+    const epics::pvData::PVStructurePtr pvStructure;
+    const epics::pvData::BitSetPtr changed;
+
+    struct Member {
+        CAChannelMonitor *monitor; // identity only
+        CAChannelMonitorWPtr weak;
+        CAChannelPtr channel;
+    };
+
+    // guarded by mutex
+    epics::pvData::Mutex mutex;
+    bool hasValue;
+    std::vector<Member> members;
+
+    // guarded by CAChannelProvider::subscriptionsMutex
+    CAChannelPtr owner; // channel of the CA subscription.  One of the members.
+    evid pevid;
+};
+
 }}}
 
 #endif  /* CACHANNEL_H */
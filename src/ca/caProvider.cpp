@@ -33,17 +33,37 @@ using namespace epics::pvData;
                 catch (...) { LOG(logLevelError, "Unhandled exception caught from client code at %s:%d.", __FILE__, __LINE__); }
 
 CAChannelProvider::CAChannelProvider()
-    : current_context(0)
+    : current_context(0),
+      flusher(new Flusher(this, 0.0))
 {
     initialize();
 }
 
-CAChannelProvider::CAChannelProvider(const std::tr1::shared_ptr<Configuration>&)
+namespace {
+// Number of threads for each kind of notification.  Taken from the first provider created.
+size_t notifyThreads(const std::tr1::shared_ptr<Configuration>& conf)
+{
+    if(!conf) return 0u;
+    int nthreads = conf->getPropertyAsInteger("EPICS_PVA_CA_NOTIFY_THREADS", 0);
+    return nthreads>0 ? size_t(nthreads) : 0u;
+}
+
+// Seconds to wait for more requests before flushing.
+double flushDelay(const std::tr1::shared_ptr<Configuration>& conf)
+{
+    if(!conf) return 0.0;
+    double delay = conf->getPropertyAsDouble("EPICS_PVA_CA_FLUSH_DELAY", 0.0);
+    return delay>0.0 ? delay : 0.0;
+}
+} // namespace
+
+CAChannelProvider::CAChannelProvider(const std::tr1::shared_ptr<Configuration>& conf)
     :  current_context(0),
-       channelConnectThread(ChannelConnectThread::get()),
-       monitorEventThread(MonitorEventThread::get()),
-       getDoneThread(GetDoneThread::get()),
-       putDoneThread(PutDoneThread::get())
+       channelConnectThread(ChannelConnectThread::get(notifyThreads(conf))),
+       monitorEventThread(MonitorEventThread::get(notifyThreads(conf))),
+       getDoneThread(GetDoneThread::get(notifyThreads(conf))),
+       putDoneThread(PutDoneThread::get(notifyThreads(conf))),
+       flusher(new Flusher(this, flushDelay(conf)))
 {
     if(DEBUG_LEVEL>0) {
           std::cout<< "CAChannelProvider::CAChannelProvider\n";
@@ -77,6 +97,7 @@ CAChannelProvider::~CAChannelProvider()
        channelQ.front()->disconnectChannel();
        channelQ.pop();
     }
+    flusher->stop();
     putDoneThread->stop();
     getDoneThread->stop();
     monitorEventThread->stop();
@@ -167,6 +188,64 @@ void CAChannelProvider::configure(epics::pvData::PVStructure::shared_pointer /*c
 
 void CAChannelProvider::flush()
 {
+    {
+        Lock lock(flusher->mutex);
+        if(!flusher->pending) return;
+        flusher->pending = false;
+    }
+    attachContext();
+    ca_flush_io();
+}
+
+void CAChannelProvider::requestFlush()
+{
+    {
+        Lock lock(flusher->mutex);
+        if(flusher->pending) return;
+        flusher->pending = true;
+    }
+    flusher->wakeup.signal();
+}
+
+CAChannelProvider::Flusher::Flusher(CAChannelProvider *provider, double delay)
+    : provider(provider),
+      delay(delay),
+      pending(false),
+      isStop(false)
+{}
+
+void CAChannelProvider::Flusher::stop()
+{
+    {
+        Lock lock(mutex);
+        isStop = true;
+    }
+    wakeup.signal();
+    if(thread) thread->exitWait();
+}
+
+void CAChannelProvider::Flusher::run()
+{
+    while(true)
+    {
+        wakeup.wait();
+        if(delay>0.0) epicsThreadSleep(delay);
+        {
+            Lock lock(mutex);
+            if(isStop) break;
+            if(!pending) continue;
+            pending = false;
+        }
+        try {
+            provider->attachContext();
+            int result = ca_flush_io();
+            if(result != ECA_NORMAL) {
+                LOG(logLevelError, "CAChannelProvider flush error: %s", ca_message(result));
+            }
+        } catch (std::exception &e) {
+            LOG(logLevelError, "CAChannelProvider flush error: %s", e.what());
+        }
+    }
 }
 
 void CAChannelProvider::poll()
@@ -196,6 +275,17 @@ void CAChannelProvider::initialize()
         throw std::runtime_error(mess);
     }
     current_context = ca_current_context();
+    // requests wait on this thread to be sent, so it must not be starved by the
+    // threads making them.  Run no lower than the creating thread.
+    unsigned int priority = epicsThreadGetPrioritySelf();
+    if(priority < epicsThreadPriorityCAServerLow)
+        priority = epicsThreadPriorityCAServerLow;
+    flusher->thread = std::tr1::shared_ptr<epicsThread>(new epicsThread(
+        *flusher,
+        "caProviderFlush",
+        epicsThreadGetStackSize(epicsThreadStackSmall),
+        priority));
+    flusher->thread->start();
 }
 
 void CAClientFactory::start()
@@ -13,7 +13,10 @@
 #define CAPROVIDERPVT_H
 
 #include <cadef.h>
+#include <epicsThread.h>
 
+#include <pv/event.h>
+#include <pv/lock.h>
 #include <pv/caProvider.h>
 #include <pv/pvAccess.h>
 
@@ -40,6 +43,16 @@ class CAChannel;
 typedef std::tr1::shared_ptr<CAChannel> CAChannelPtr;
 typedef std::tr1::weak_ptr<CAChannel> CAChannelWPtr;
 
+// Select the notification thread for a channel, so that its notifications stay in order
+inline size_t shardIndex(const void *channel, size_t nshards)
+{
+    // low bits of a heap address carry no information
+    return (size_t(channel)>>4u) % nshards;
+}
+
+class CASubscription;
+typedef std::tr1::weak_ptr<CASubscription> CASubscriptionWPtr;
+
 class CAChannelProvider;
 typedef std::tr1::shared_ptr<CAChannelProvider> CAChannelProviderPtr;
 typedef std::tr1::weak_ptr<CAChannelProvider> CAChannelProviderWPtr;
@@ -81,6 +94,12 @@ public:
     virtual void poll();
 
     void attachContext();
+    /**
+     * Flush CA requests soon, from the flush thread.
+     * Requests made before the flush thread wakes are sent together.
+     * flush() sends them immediately.
+     */
+    void requestFlush();
     void addChannel(const CAChannelPtr & channel);
 private:
     
@@ -93,6 +112,27 @@ private:
     MonitorEventThreadPtr monitorEventThread;
     GetDoneThreadPtr getDoneThread;
     PutDoneThreadPtr putDoneThread;
+
+    // Coalesces the flushes of requestFlush()
+    struct Flusher : public epicsThreadRunable
+    {
+        CAChannelProvider * const provider;
+        const double delay;
+        epics::pvData::Mutex mutex;
+        epics::pvData::Event wakeup;
+        bool pending;
+        bool isStop;
+        std::tr1::shared_ptr<epicsThread> thread;
+        Flusher(CAChannelProvider *provider, double delay);
+        void stop();
+        virtual void run();
+    };
+    std::tr1::shared_ptr<Flusher> flusher;
+
+    friend class CASubscription;
+    // CA subscriptions shared by monitors.  Also serializes changes to their membership.
+    epics::pvData::Mutex subscriptionsMutex;
+    std::vector<CASubscriptionWPtr> subscriptions;
 };
 
 }}}
@@ -10,6 +10,7 @@
 
 #include "caChannel.h"
 #include <epicsExit.h>
+#include <epicsStdio.h>
 #define epicsExportSharedSymbols
 #include "channelConnectThread.h"
 
@@ -20,21 +21,23 @@ namespace epics {
 namespace pvAccess {
 namespace ca {
 
-ChannelConnectThreadPtr ChannelConnectThread::get()
+ChannelConnectThreadPtr ChannelConnectThread::get(size_t nthreads)
 {
     static  ChannelConnectThreadPtr master;
     static Mutex mutex;
     Lock xx(mutex);
     if(!master) {
-        master = ChannelConnectThreadPtr(new ChannelConnectThread());
+        master = ChannelConnectThreadPtr(new ChannelConnectThread(nthreads ? nthreads : 1u));
         master->start();
     }
     return master;
 }
 
-ChannelConnectThread::ChannelConnectThread()
-: isStop(false)
+ChannelConnectThread::ChannelConnectThread(size_t nthreads)
+: shards(nthreads)
 {
+    for(size_t i=0; i<shards.size(); i++)
+        shards[i].reset(new Shard());
 }
 
 ChannelConnectThread::~ChannelConnectThread()
@@ -45,38 +48,47 @@ ChannelConnectThread::~ChannelConnectThread()
 
 void ChannelConnectThread::start()
 {
-    thread =  std::tr1::shared_ptr<epicsThread>(new epicsThread(
-        *this,
-        "channelConnectThread",
-        epicsThreadGetStackSize(epicsThreadStackSmall),
-        epicsThreadPriorityLow));
-    thread->start();
+    for(size_t i=0; i<shards.size(); i++) {
+        char name[32];
+        if(shards.size()==1u)
+            epicsSnprintf(name, sizeof(name), "channelConnectThread");
+        else
+            epicsSnprintf(name, sizeof(name), "channelConnectThread%u", unsigned(i));
+        shards[i]->thread =  std::tr1::shared_ptr<epicsThread>(new epicsThread(
+            *shards[i],
+            name,
+            epicsThreadGetStackSize(epicsThreadStackSmall),
+            epicsThreadPriorityLow));
+        shards[i]->thread->start();
+    }
 }
 
-
 void ChannelConnectThread::stop()
 {
-    {
-        Lock xx(mutex);
-        isStop = true;
+    for(size_t i=0; i<shards.size(); i++) {
+        {
+            Lock xx(shards[i]->mutex);
+            shards[i]->isStop = true;
+        }
+        shards[i]->waitForCommand.signal();
     }
-    waitForCommand.signal();
-    waitForStop.wait();
+    for(size_t i=0; i<shards.size(); i++)
+        shards[i]->waitForStop.wait();
 }
 
-void ChannelConnectThread::channelConnected(
-    NotifyChannelRequesterPtr const &notifyChannelRequester)
+void ChannelConnectThread::channelConnected(NotifyChannelRequesterPtr const &notifyChannelRequester, const void *channel)
 {
+    Shard& shard(*shards[shardIndex(channel, shards.size())]);
     {
-        Lock lock(mutex);
+        Lock lock(shard.mutex);
         if(notifyChannelRequester->isOnQueue) return;
         notifyChannelRequester->isOnQueue = true;
-        notifyChannelQueue.push(notifyChannelRequester);
+        shard.notifyChannelQueue.push(notifyChannelRequester);
     }
-    waitForCommand.signal();
+    shard.waitForCommand.signal();
 }
 
-void ChannelConnectThread::run()
+void ChannelConnectThread::Shard::run()
 {
     while(true)
     {
@@ -10,6 +10,7 @@
 #ifndef ChannelConnectThread_H
 #define ChannelConnectThread_H
 #include <queue>
+#include <vector>
 #include <cadef.h>
 #include <shareLib.h>
 #include <epicsThread.h>
@@ -44,25 +45,39 @@ public:
 };
 
 
-class ChannelConnectThread :
-     public epicsThreadRunable
+/**
+ * Calls CAChannel::notifyClient(), on connect or disconnect, from one, or several, threads.
+ * Each channel is assigned to one thread, so notifications of a channel are delivered in order.
+ */
+class ChannelConnectThread
 {
 public:
-    static ChannelConnectThreadPtr get();
+    /**
+     * @param nthreads Number of threads.  Used only by the first call, 0 for the default of 1.
+     */
+    static ChannelConnectThreadPtr get(size_t nthreads = 0u);
     ~ChannelConnectThread();
-    virtual void run();
-    void start();
     void stop();
-    void channelConnected(NotifyChannelRequesterPtr const &notifyChannelRequester);
+    /**
+     * @param channel Identifies the channel, to select a thread.
+     */
+    void channelConnected(NotifyChannelRequesterPtr const &notifyChannelRequester, const void *channel);
 private:
-    ChannelConnectThread();
+    explicit ChannelConnectThread(size_t nthreads);
+    void start();
 
-    bool isStop;
-    std::tr1::shared_ptr<epicsThread> thread;
-    epics::pvData::Mutex mutex;
-    epics::pvData::Event waitForCommand;
-    epics::pvData::Event waitForStop;
-    std::queue<NotifyChannelRequesterWPtr> notifyChannelQueue;
+    struct Shard : public epicsThreadRunable
+    {
+        bool isStop;
+        std::tr1::shared_ptr<epicsThread> thread;
+        epics::pvData::Mutex mutex;
+        epics::pvData::Event waitForCommand;
+        epics::pvData::Event waitForStop;
+        std::queue<NotifyChannelRequesterWPtr> notifyChannelQueue;
+        Shard() : isStop(false) {}
+        virtual void run();
+    };
+    std::vector<std::tr1::shared_ptr<Shard> > shards;
 };
 
 
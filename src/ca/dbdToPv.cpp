@@ -380,23 +380,40 @@ PVStructurePtr DbdToPv::createPVStructure()
 }
 
 template<typename dbrT, typename pvT>
-void copy_DBRScalar(const void * dbr, PVScalar::shared_pointer const & pvScalar)
+void copy_DBRScalar(const void * dbr, PVScalar & pvScalar)
 {
-    std::tr1::shared_ptr<pvT> value = std::tr1::static_pointer_cast<pvT>(pvScalar);
-    value->put(static_cast<const dbrT*>(dbr)[0]);
+    static_cast<pvT&>(pvScalar).put(static_cast<const dbrT*>(dbr)[0]);
+}
+
+/* Storage for count elements, to replace the current value of pvArray.
+ * The current array is re-used when no one else (eg. a monitor queue) holds a reference.
+ * Otherwise new storage is allocated, without copying the old elements as reuse() would.
+ */
+template<typename pvT>
+typename pvT::svector arrayStorage(pvT & pvArray, size_t count)
+{
+    typename pvT::svector ret;
+    {
+        typename pvT::const_svector prev;
+        pvArray.swap(prev);
+        if(prev.unique())
+            ret = thaw(prev);
+    }
+    ret.resize(count);
+    return ret;
 }
 
 template<typename dbrT, typename pvT>
-void copy_DBRScalarArray(const void * dbr, unsigned count, PVScalarArray::shared_pointer const & pvArray)
+void copy_DBRScalarArray(const void * dbr, unsigned count, PVScalarArray & pvArray)
 {
-    std::tr1::shared_ptr<pvT> value = std::tr1::static_pointer_cast<pvT>(pvArray);
-    typename pvT::svector temp(value->reuse());
-    temp.resize(count);
-    std::copy(
-        static_cast<const dbrT*>(dbr),
-        static_cast<const dbrT*>(dbr) + count,
-        temp.begin());
-    value->replace(freeze(temp));
+    pvT& value = static_cast<pvT&>(pvArray);
+    typename pvT::svector temp(arrayStorage(value, count));
+    // a plain element-wise conversion, which compilers vectorize
+    const dbrT *src = static_cast<const dbrT*>(dbr);
+    typename pvT::value_type *dst = temp.data();
+    for(unsigned i=0; i<count; i++)
+        dst[i] = static_cast<typename pvT::value_type>(src[i]);
+    value.replace(freeze(temp));
 }
 
 template<typename dbrT>
@@ -427,6 +444,31 @@ void get_DBRValueAlarm(
     *lower_alarm_limit =  static_cast<const dbrT*>(dbr)->lower_alarm_limit;
 }
 
+void DbdToPv::resolve(PVStructurePtr const & pvStructure)
+{
+    GetPlan next;
+    next.root = pvStructure;
+    if(valueRequested) {
+        next.value = pvStructure->getSubFieldT<PVField>("value");
+        if(caValueType==DBR_ENUM && !isArray) {
+            next.index = pvStructure->getSubFieldT<PVInt>("value.index");
+            next.choices = pvStructure->getSubFieldT<PVStringArray>("value.choices");
+        }
+    }
+    if(alarmRequested) {
+        next.alarm = pvStructure->getSubFieldT<PVStructure>("alarm");
+        next.severity = next.alarm->getSubFieldT<PVInt>("severity");
+        next.status = next.alarm->getSubFieldT<PVInt>("status");
+        next.message = next.alarm->getSubFieldT<PVString>("message");
+    }
+    if(timeStampRequested) {
+        PVStructurePtr pvTimeStamp(pvStructure->getSubFieldT<PVStructure>("timeStamp"));
+        next.seconds = pvTimeStamp->getSubFieldT<PVLong>("secondsPastEpoch");
+        next.nanoseconds = pvTimeStamp->getSubFieldT<PVInt>("nanoseconds");
+    }
+    plan = next;
+}
+
 Status DbdToPv::getFromDBD(
      PVStructurePtr const & pvStructure,
      BitSet::shared_pointer const & bitSet,
@@ -437,70 +479,70 @@ Status DbdToPv::getFromDBD(
      Status errorStatus(Status::STATUSTYPE_ERROR, string(ca_message(args.status)));
      return errorStatus;
    }
+   if(plan.root!=pvStructure)
+       resolve(pvStructure);
    if(valueRequested)
    {
        void * value = dbr_value_ptr(args.dbr,caRequestType);
        if(isArray) {
            long count = args.count;
-           PVScalarArrayPtr pvValue = pvStructure->getSubField<PVScalarArray>("value");
+           // a PVString when charArrayIsString
+           PVScalarArray* pvArray = charArrayIsString ? NULL : static_cast<PVScalarArray*>(plan.value.get());
            switch(caValueType) {
            case DBR_STRING:
            {
                 const dbr_string_t *dbrval = static_cast<const dbr_string_t *>(value);
-                PVStringArrayPtr pvValue = pvStructure->getSubField<PVStringArray>("value");
-                PVStringArray::svector arr(pvValue->reuse());
-                arr.resize(count);
+                PVStringArray& pvValue = static_cast<PVStringArray&>(*plan.value);
+                PVStringArray::svector arr(arrayStorage(pvValue, count));
                 std::copy(dbrval, dbrval + count, arr.begin());
-                pvValue->replace(freeze(arr));
+                pvValue.replace(freeze(arr));
                 break;
            }
            case DBR_CHAR:
                if(charArrayIsString)
                {
                    const char * pchar = static_cast<const char *>(value);
-                   std::string str(pchar);
-                   PVStringPtr pvValue(pvStructure->getSubField<PVString>("value"));
-                   pvValue->put(str);
+                   static_cast<PVString&>(*plan.value).put(pchar);
                    break;
                }
                if(dbfIsUCHAR)
                {
-                   copy_DBRScalarArray<dbr_char_t,PVUByteArray>(value,count,pvValue);
+                   copy_DBRScalarArray<dbr_char_t,PVUByteArray>(value,count,*pvArray);
                    break;
                }
-               copy_DBRScalarArray<dbr_char_t,PVByteArray>(value,count,pvValue);
+               copy_DBRScalarArray<dbr_char_t,PVByteArray>(value,count,*pvArray);
                break;
            case DBR_SHORT:
                if(dbfIsUSHORT)
                {
-                   copy_DBRScalarArray<dbr_short_t,PVUShortArray>(value,count,pvValue);
+                   copy_DBRScalarArray<dbr_short_t,PVUShortArray>(value,count,*pvArray);
                    break;
                }
-               copy_DBRScalarArray<dbr_short_t,PVShortArray>(value,count,pvValue);
+               copy_DBRScalarArray<dbr_short_t,PVShortArray>(value,count,*pvArray);
                break;
            case DBR_LONG:
                if(dbfIsULONG)
                {
-                   copy_DBRScalarArray<dbr_long_t,PVUIntArray>(value,count,pvValue);
+                   copy_DBRScalarArray<dbr_long_t,PVUIntArray>(value,count,*pvArray);
                    break;
                }
-               copy_DBRScalarArray<dbr_long_t,PVIntArray>(value,count,pvValue);
+               copy_DBRScalarArray<dbr_long_t,PVIntArray>(value,count,*pvArray);
                break;
            case DBR_FLOAT:
-               copy_DBRScalarArray<dbr_float_t,PVFloatArray>(value,count,pvValue);
+               copy_DBRScalarArray<dbr_float_t,PVFloatArray>(value,count,*pvArray);
                break;
            case DBR_DOUBLE:
                if(dbfIsINT64)
                {
-                   copy_DBRScalarArray<dbr_double_t,PVLongArray>(value,count,pvValue);
+                   copy_DBRScalarArray<dbr_double_t,PVLongArray>(value,count,*pvArray);
                    break;
                }
                if(dbfIsUINT64)
                {
-                   copy_DBRScalarArray<dbr_double_t,PVULongArray>(value,count,pvValue);
+                   copy_DBRScalarArray<dbr_double_t,PVULongArray>(value,count,*pvArray);
                    break;
                }
-               copy_DBRScalarArray<dbr_double_t,PVDoubleArray>(value,count,pvValue);
+               copy_DBRScalarArray<dbr_double_t,PVDoubleArray>(value,count,*pvArray);
                break;
            default:
                 Status errorStatus(
@@ -508,62 +550,60 @@ Status DbdToPv::getFromDBD(
                 return errorStatus;
            }
        } else {
-           PVScalarPtr pvValue = pvStructure->getSubField<PVScalar>("value");
+           // a PVStructure for DBR_ENUM
+           PVScalar* pvScalar = caValueType==DBR_ENUM ? NULL : static_cast<PVScalar*>(plan.value.get());
            switch(caValueType) {
            case DBR_ENUM:
            {
                 const dbr_enum_t *dbrval = static_cast<const dbr_enum_t *>(value);
-                PVIntPtr value = pvStructure->getSubField<PVInt>("value.index");
-                value->put(*dbrval);
-                PVStringArrayPtr pvChoices
-                     = pvStructure->getSubField<PVStringArray>("value.choices");
-                if(pvChoices->getLength()==0)
+                plan.index->put(*dbrval);
+                if(plan.choices->getLength()==0)
                 {
                      ConvertPtr convert = getConvert();
                      size_t n = choices.size();
-                     pvChoices->setLength(n);
-                     convert->fromStringArray(pvChoices,0,n,choices,0);
-                     bitSet->set(pvStructure->getSubField("value")->getFieldOffset());
+                     plan.choices->setLength(n);
+                     convert->fromStringArray(plan.choices,0,n,choices,0);
+                     bitSet->set(plan.value->getFieldOffset());
                 } else {
-                     bitSet->set(value->getFieldOffset());
+                     bitSet->set(plan.index->getFieldOffset());
                 }
                 break;
            }
-           case DBR_STRING: copy_DBRScalar<dbr_string_t,PVString>(value,pvValue); break;
+           case DBR_STRING: copy_DBRScalar<dbr_string_t,PVString>(value,*pvScalar); break;
            case DBR_CHAR:
                 if(dbfIsUCHAR)
                 {
-                   copy_DBRScalar<dbr_char_t,PVUByte>(value,pvValue);
+                   copy_DBRScalar<dbr_char_t,PVUByte>(value,*pvScalar);
                    break;
                 }
-                copy_DBRScalar<dbr_char_t,PVByte>(value,pvValue); break;
+                copy_DBRScalar<dbr_char_t,PVByte>(value,*pvScalar); break;
            case DBR_SHORT:
                 if(dbfIsUSHORT)
                 {
-                   copy_DBRScalar<dbr_short_t,PVUShort>(value,pvValue);
+                   copy_DBRScalar<dbr_short_t,PVUShort>(value,*pvScalar);
                    break;
                 }
-                copy_DBRScalar<dbr_short_t,PVShort>(value,pvValue); break;
+                copy_DBRScalar<dbr_short_t,PVShort>(value,*pvScalar); break;
            case DBR_LONG:
                 if(dbfIsULONG)
                 {
-                   copy_DBRScalar<dbr_long_t,PVUInt>(value,pvValue);
+                   copy_DBRScalar<dbr_long_t,PVUInt>(value,*pvScalar);
                    break;
                 }
-                copy_DBRScalar<dbr_long_t,PVInt>(value,pvValue); break;
-           case DBR_FLOAT: copy_DBRScalar<dbr_float_t,PVFloat>(value,pvValue); break;
+                copy_DBRScalar<dbr_long_t,PVInt>(value,*pvScalar); break;
+           case DBR_FLOAT: copy_DBRScalar<dbr_float_t,PVFloat>(value,*pvScalar); break;
            case DBR_DOUBLE:
                 if(dbfIsINT64)
                 {
-                   copy_DBRScalar<dbr_double_t,PVLong>(value,pvValue);
+                   copy_DBRScalar<dbr_double_t,PVLong>(value,*pvScalar);
                    break;
                 }
                 if(dbfIsUINT64)
                 {
-                   copy_DBRScalar<dbr_double_t,PVULong>(value,pvValue);
+                   copy_DBRScalar<dbr_double_t,PVULong>(value,*pvScalar);
                    break;
                 }
-                copy_DBRScalar<dbr_double_t,PVDouble>(value,pvValue); break;
+                copy_DBRScalar<dbr_double_t,PVDouble>(value,*pvScalar); break;
            default:
                 Status errorStatus(
                     Status::STATUSTYPE_ERROR, string("DbdToPv::getFromDBD logic error"));
@@ -571,7 +611,7 @@ Status DbdToPv::getFromDBD(
            }
        }
        if(caValueType!=DBR_ENUM) {
-            bitSet->set(pvStructure->getSubField("value")->getFieldOffset());
+            bitSet->set(plan.value->getFieldOffset());
        }
     }
     if(alarmRequested) {
@@ -581,48 +621,41 @@ Status DbdToPv::getFromDBD(
         dbr_short_t severity = data->severity;
         bool statusChanged = false;
         bool severityChanged = false;
-        PVStructurePtr pvAlarm(pvStructure->getSubField<PVStructure>("alarm"));
-        PVIntPtr pvSeverity(pvAlarm->getSubField<PVInt>("severity"));
         if(caAlarm.severity!=severity) {
             caAlarm.severity = severity;
-            pvSeverity->put(severity);
+            plan.severity->put(severity);
             severityChanged = true;
         }
-        PVStringPtr pvMessage(pvAlarm->getSubField<PVString>("message"));
-        PVIntPtr pvStatus(pvAlarm->getSubField<PVInt>("status"));
         if(caAlarm.status!=status) {
             caAlarm.status = status;
-            pvStatus->put(convertDBstatus(status));
+            plan.status->put(convertDBstatus(status));
             string message("UNKNOWN STATUS");
             if(status<=ALARM_NSTATUS) message = string(epicsAlarmConditionStrings[status]);
-            pvMessage->put(message);
+            plan.message->put(message);
             statusChanged = true;
         }
         if(statusChanged&&severityChanged) {
-            bitSet->set(pvAlarm->getFieldOffset());
+            bitSet->set(plan.alarm->getFieldOffset());
         } else if(severityChanged) {
-            bitSet->set(pvSeverity->getFieldOffset());
+            bitSet->set(plan.severity->getFieldOffset());
         } else if(statusChanged) {
-            bitSet->set(pvStatus->getFieldOffset());
-            bitSet->set(pvMessage->getFieldOffset());
+            bitSet->set(plan.status->getFieldOffset());
+            bitSet->set(plan.message->getFieldOffset());
         }
     }
     if(timeStampRequested) {
         // Note that epicsTimeStamp always follows status and severity
         const dbr_time_string *data = static_cast<const dbr_time_string *>(args.dbr);
         epicsTimeStamp stamp = data->stamp;
-        PVStructurePtr pvTimeStamp(pvStructure->getSubField<PVStructure>("timeStamp"));
         if(caTimeStamp.secPastEpoch!=stamp.secPastEpoch) {
             caTimeStamp.secPastEpoch = stamp.secPastEpoch;
-            PVLongPtr pvSeconds(pvTimeStamp->getSubField<PVLong>("secondsPastEpoch"));
-            pvSeconds->put(stamp.secPastEpoch+posixEpochAtEpicsEpoch);
-            bitSet->set(pvSeconds->getFieldOffset());
+            plan.seconds->put(stamp.secPastEpoch+posixEpochAtEpicsEpoch);
+            bitSet->set(plan.seconds->getFieldOffset());
         }
         if(caTimeStamp.nsec!=stamp.nsec) {
             caTimeStamp.nsec = stamp.nsec;
-            PVIntPtr pvNano(pvTimeStamp->getSubField<PVInt>("nanoseconds"));
-            pvNano->put(stamp.nsec);
-            bitSet->set(pvNano->getFieldOffset());
+            plan.nanoseconds->put(stamp.nsec);
+            bitSet->set(plan.nanoseconds->getFieldOffset());
         }
     }
     if(controlRequested)
@@ -822,7 +855,6 @@ Status DbdToPv::putToDBD(
     chid channelID = caChannel->getChannelID();
     const void *pValue = NULL;
     unsigned long count = 1;
-    char *ca_stringBuffer(0);
     dbr_char_t   bvalue(0);
     dbr_short_t  svalue(0);
     dbr_long_t   lvalue(0);
@@ -837,14 +869,12 @@ Status DbdToPv::putToDBD(
                count = pvValue->getLength();
                if(count<1) break;
                if(count>maxElements) count = maxElements;
-               int nbytes = count*MAX_STRING_SIZE;
-               ca_stringBuffer = new char[nbytes];
-               memset(ca_stringBuffer, 0, nbytes);
-               pValue = ca_stringBuffer;
+               putStrings.assign(count*MAX_STRING_SIZE, 0);
+               pValue = &putStrings[0];
                PVStringArray::const_svector stringArray(pvValue->view());
-               char  *pnext = ca_stringBuffer;
+               char  *pnext = &putStrings[0];
                for(size_t i=0; i<count; ++i) {
-                   string value = stringArray[i];
+                   const string& value = stringArray[i];
                    size_t len = value.length();
                    if (len >= MAX_STRING_SIZE) len = MAX_STRING_SIZE - 1;
                    memcpy(pnext, value.c_str(), len);
@@ -892,22 +922,18 @@ Status DbdToPv::putToDBD(
                {
                    PVLongArrayPtr pvValue(pvStructure->getSubField<PVLongArray>("value"));
                    PVLongArray::const_svector sv(pvValue->view());
-                   pvDoubleArray = PVDoubleArrayPtr(getPVDataCreate()->createPVScalarArray<PVDoubleArray>());
-                   pvDoubleArray->putFrom(sv);
-                   const double * pdouble = pvDoubleArray->view().data();
-                   count = pvValue->getLength();
-                   pValue = pdouble;
+                   putDoubles.assign(sv.begin(), sv.end());
+                   count = sv.size();
+                   pValue = putDoubles.empty() ? NULL : &putDoubles[0];
                    break;
                }
                if(dbfIsUINT64)
                {
                    PVULongArrayPtr pvValue(pvStructure->getSubField<PVULongArray>("value"));
                    PVULongArray::const_svector sv(pvValue->view());
-                   pvDoubleArray = PVDoubleArrayPtr(getPVDataCreate()->createPVScalarArray<PVDoubleArray>());
-                   pvDoubleArray->putFrom(sv);
-                   const double * pdouble = pvDoubleArray->view().data();
-                   count = pvValue->getLength();
-                   pValue = pdouble;
+                   putDoubles.assign(sv.begin(), sv.end());
+                   count = sv.size();
+                   pValue = putDoubles.empty() ? NULL : &putDoubles[0];
                    break;
                }
                pValue = put_DBRScalarArray<dbr_double_t,PVDoubleArray>(&count,pvValue);
@@ -976,11 +1002,10 @@ Status DbdToPv::putToDBD(
         result = ca_array_put(caValueType,count,channelID,pValue);
     }
     if(result==ECA_NORMAL) {
-         ca_flush_io();
+         caChannel->requestFlush();
     } else {
          status = Status(Status::STATUSTYPE_ERROR, string(ca_message(result)));
     }
-    if(ca_stringBuffer!=NULL) delete[] ca_stringBuffer;
     return status;
 }
 
@@ -112,6 +112,7 @@ private:
         CAChannelPtr const & caChannel,
         epics::pvData::PVStructurePtr const & pvRequest
     );
+    void resolve(epics::pvData::PVStructurePtr const & pvStructure);
     IOType ioType;
     bool dbfIsUCHAR;
     bool dbfIsUSHORT;
@@ -138,7 +139,24 @@ private:
     CaValueAlarm caValueAlarm;
     epics::pvData::Structure::const_shared_pointer structure;
     std::vector<std::string> choices;
-    epics::pvData::PVDoubleArrayPtr pvDoubleArray; //for dbfIsINT64 and dbfIsUINT64
+    // re-used by putToDBD()
+    std::vector<char> putStrings;    // for DBR_STRING arrays
+    std::vector<double> putDoubles;  // for dbfIsINT64 and dbfIsUINT64 arrays
+    /* Fields updated by getFromDBD(), found once for each PVStructure
+     * instead of by name on each update.  cf. resolve()
+     */
+    struct GetPlan {
+        epics::pvData::PVStructurePtr root;
+        epics::pvData::PVFieldPtr value;
+        epics::pvData::PVIntPtr index;               // DBR_ENUM only
+        epics::pvData::PVStringArrayPtr choices;     // DBR_ENUM only
+        epics::pvData::PVStructurePtr alarm;
+        epics::pvData::PVIntPtr severity;
+        epics::pvData::PVIntPtr status;
+        epics::pvData::PVStringPtr message;
+        epics::pvData::PVLongPtr seconds;
+        epics::pvData::PVIntPtr nanoseconds;
+    } plan;
 };
 
 }
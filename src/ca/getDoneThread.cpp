@@ -10,6 +10,7 @@
 
 #include "caChannel.h"
 #include <epicsExit.h>
+#include <epicsStdio.h>
 #define epicsExportSharedSymbols
 #include "getDoneThread.h"
 
@@ -20,21 +21,23 @@ namespace epics {
 namespace pvAccess {
 namespace ca {
 
-GetDoneThreadPtr GetDoneThread::get()
+GetDoneThreadPtr GetDoneThread::get(size_t nthreads)
 {
     static  GetDoneThreadPtr master;
     static Mutex mutex;
     Lock xx(mutex);
     if(!master) {
-        master = GetDoneThreadPtr(new GetDoneThread());
+        master = GetDoneThreadPtr(new GetDoneThread(nthreads ? nthreads : 1u));
         master->start();
     }
     return master;
 }
 
-GetDoneThread::GetDoneThread()
-: isStop(false)
+GetDoneThread::GetDoneThread(size_t nthreads)
+: shards(nthreads)
 {
+    for(size_t i=0; i<shards.size(); i++)
+        shards[i].reset(new Shard());
 }
 
 GetDoneThread::~GetDoneThread()
@@ -45,37 +48,47 @@ GetDoneThread::~GetDoneThread()
 
 void GetDoneThread::start()
 {
-    thread =  std::tr1::shared_ptr<epicsThread>(new epicsThread(
-        *this,
-        "getDoneThread",
-        epicsThreadGetStackSize(epicsThreadStackBig),
-        epicsThreadPriorityLow));
-    thread->start();
+    for(size_t i=0; i<shards.size(); i++) {
+        char name[32];
+        if(shards.size()==1u)
+            epicsSnprintf(name, sizeof(name), "getDoneThread");
+        else
+            epicsSnprintf(name, sizeof(name), "getDoneThread%u", unsigned(i));
+        shards[i]->thread =  std::tr1::shared_ptr<epicsThread>(new epicsThread(
+            *shards[i],
+            name,
+            epicsThreadGetStackSize(epicsThreadStackBig),
+            epicsThreadPriorityLow));
+        shards[i]->thread->start();
+    }
 }
 
-
 void GetDoneThread::stop()
 {
-    {
-        Lock xx(mutex);
-        isStop = true;
+    for(size_t i=0; i<shards.size(); i++) {
+        {
+            Lock xx(shards[i]->mutex);
+            shards[i]->isStop = true;
+        }
+        shards[i]->waitForCommand.signal();
     }
-    waitForCommand.signal();
-    waitForStop.wait();
+    for(size_t i=0; i<shards.size(); i++)
+        shards[i]->waitForStop.wait();
 }
 
-void GetDoneThread::getDone(NotifyGetRequesterPtr const &notifyGetRequester)
+void GetDoneThread::getDone(NotifyGetRequesterPtr const &notifyGetRequester, const void *channel)
 {
+    Shard& shard(*shards[shardIndex(channel, shards.size())]);
     {
-        Lock lock(mutex);
+        Lock lock(shard.mutex);
         if(notifyGetRequester->isOnQueue) return;
         notifyGetRequester->isOnQueue = true;
-        notifyGetQueue.push(notifyGetRequester);
+        shard.notifyGetQueue.push(notifyGetRequester);
     }
-    waitForCommand.signal();
+    shard.waitForCommand.signal();
 }
 
-void GetDoneThread::run()
+void GetDoneThread::Shard::run()
 {
     while(true)
     {
@@ -10,6 +10,7 @@
 #ifndef GetDoneThread_H
 #define GetDoneThread_H
 #include <queue>
+#include <vector>
 #include <cadef.h>
 #include <shareLib.h>
 #include <epicsThread.h>
@@ -44,25 +45,39 @@ public:
 };
 
 
-class GetDoneThread :
-     public epicsThreadRunable
+/**
+ * Calls CAChannelGet::notifyClient(), on completion of a get, from one, or several, threads.
+ * Each channel is assigned to one thread, so notifications of a channel are delivered in order.
+ */
+class GetDoneThread
 {
 public:
-    static GetDoneThreadPtr get();
+    /**
+     * @param nthreads Number of threads.  Used only by the first call, 0 for the default of 1.
+     */
+    static GetDoneThreadPtr get(size_t nthreads = 0u);
     ~GetDoneThread();
-    virtual void run();
-    void start();
     void stop();
-    void getDone(NotifyGetRequesterPtr const &notifyGetRequester);
+    /**
+     * @param channel Identifies the channel, to select a thread.
+     */
+    void getDone(NotifyGetRequesterPtr const &notifyGetRequester, const void *channel);
 private:
-    GetDoneThread();
+    explicit GetDoneThread(size_t nthreads);
+    void start();
 
-    bool isStop;
-    std::tr1::shared_ptr<epicsThread> thread;
-    epics::pvData::Mutex mutex;
-    epics::pvData::Event waitForCommand;
-    epics::pvData::Event waitForStop;
-    std::queue<NotifyGetRequesterWPtr> notifyGetQueue;
+    struct Shard : public epicsThreadRunable
+    {
+        bool isStop;
+        std::tr1::shared_ptr<epicsThread> thread;
+        epics::pvData::Mutex mutex;
+        epics::pvData::Event waitForCommand;
+        epics::pvData::Event waitForStop;
+        std::queue<NotifyGetRequesterWPtr> notifyGetQueue;
+        Shard() : isStop(false) {}
+        virtual void run();
+    };
+    std::vector<std::tr1::shared_ptr<Shard> > shards;
 };
 
 
@@ -10,6 +10,7 @@
 
 #include "caChannel.h"
 #include <epicsExit.h>
+#include <epicsStdio.h>
 #define epicsExportSharedSymbols
 #include "monitorEventThread.h"
 
@@ -20,21 +21,23 @@ namespace epics {
 namespace pvAccess {
 namespace ca {
 
-MonitorEventThreadPtr MonitorEventThread::get()
+MonitorEventThreadPtr MonitorEventThread::get(size_t nthreads)
 {
     static  MonitorEventThreadPtr master;
     static Mutex mutex;
     Lock xx(mutex);
     if(!master) {
-        master = MonitorEventThreadPtr(new MonitorEventThread());
+        master = MonitorEventThreadPtr(new MonitorEventThread(nthreads ? nthreads : 1u));
         master->start();
     }
     return master;
 }
 
-MonitorEventThread::MonitorEventThread()
-: isStop(false)
+MonitorEventThread::MonitorEventThread(size_t nthreads)
+: shards(nthreads)
 {
+    for(size_t i=0; i<shards.size(); i++)
+        shards[i].reset(new Shard());
 }
 
 MonitorEventThread::~MonitorEventThread()
@@ -44,37 +47,47 @@ MonitorEventThread::~MonitorEventThread()
 
 void MonitorEventThread::start()
 {
-    thread =  std::tr1::shared_ptr<epicsThread>(new epicsThread(
-        *this,
-        "monitorEventThread",
-        epicsThreadGetStackSize(epicsThreadStackBig),
-        epicsThreadPriorityLow));
-    thread->start();
+    for(size_t i=0; i<shards.size(); i++) {
+        char name[32];
+        if(shards.size()==1u)
+            epicsSnprintf(name, sizeof(name), "monitorEventThread");
+        else
+            epicsSnprintf(name, sizeof(name), "monitorEventThread%u", unsigned(i));
+        shards[i]->thread =  std::tr1::shared_ptr<epicsThread>(new epicsThread(
+            *shards[i],
+            name,
+            epicsThreadGetStackSize(epicsThreadStackBig),
+            epicsThreadPriorityLow));
+        shards[i]->thread->start();
+    }
 }
 
 void MonitorEventThread::stop()
 {
-    {
-        Lock xx(mutex);
-        isStop = true;
+    for(size_t i=0; i<shards.size(); i++) {
+        {
+            Lock xx(shards[i]->mutex);
+            shards[i]->isStop = true;
+        }
+        shards[i]->waitForCommand.signal();
     }
-    waitForCommand.signal();
-    waitForStop.wait();
+    for(size_t i=0; i<shards.size(); i++)
+        shards[i]->waitForStop.wait();
 }
 
-
-void MonitorEventThread::event(NotifyMonitorRequesterPtr const &notifyMonitorRequester)
+void MonitorEventThread::event(NotifyMonitorRequesterPtr const &notifyMonitorRequester, const void *channel)
 {
+    Shard& shard(*shards[shardIndex(channel, shards.size())]);
     {
-        Lock lock(mutex);
+        Lock lock(shard.mutex);
         if(notifyMonitorRequester->isOnQueue) return;
         notifyMonitorRequester->isOnQueue = true;
-        notifyMonitorQueue.push(notifyMonitorRequester);
+        shard.notifyMonitorQueue.push(notifyMonitorRequester);
     }
-    waitForCommand.signal();
+    shard.waitForCommand.signal();
 }
 
-void MonitorEventThread::run()
+void MonitorEventThread::Shard::run()
 {
     while(true)
     {
@@ -10,6 +10,7 @@
 #ifndef MonitorEventThread_H
 #define MonitorEventThread_H
 #include <queue>
+#include <vector>
 #include <cadef.h>
 #include <shareLib.h>
 #include <epicsThread.h>
@@ -44,25 +45,39 @@ public:
 };
 
 
-class MonitorEventThread :
-     public epicsThreadRunable
+/**
+ * Calls CAChannelMonitor::notifyClient(), when a monitor event is queued, from one, or several, threads.
+ * Each channel is assigned to one thread, so notifications of a channel are delivered in order.
+ */
+class MonitorEventThread
 {
 public:
-    static MonitorEventThreadPtr get();
+    /**
+     * @param nthreads Number of threads.  Used only by the first call, 0 for the default of 1.
+     */
+    static MonitorEventThreadPtr get(size_t nthreads = 0u);
     ~MonitorEventThread();
-    virtual void run();
-    void start();
     void stop();
-    void event(NotifyMonitorRequesterPtr const &notifyMonitorRequester);
+    /**
+     * @param channel Identifies the channel, to select a thread.
+     */
+    void event(NotifyMonitorRequesterPtr const &notifyMonitorRequester, const void *channel);
 private:
-    MonitorEventThread();
+    explicit MonitorEventThread(size_t nthreads);
+    void start();
 
-    bool isStop;
-    std::tr1::shared_ptr<epicsThread> thread;
-    epics::pvData::Mutex mutex;
-    epics::pvData::Event waitForCommand;
-    epics::pvData::Event waitForStop;
-    std::queue<NotifyMonitorRequesterWPtr> notifyMonitorQueue;
+    struct Shard : public epicsThreadRunable
+    {
+        bool isStop;
+        std::tr1::shared_ptr<epicsThread> thread;
+        epics::pvData::Mutex mutex;
+        epics::pvData::Event waitForCommand;
+        epics::pvData::Event waitForStop;
+        std::queue<NotifyMonitorRequesterWPtr> notifyMonitorQueue;
+        Shard() : isStop(false) {}
+        virtual void run();
+    };
+    std::vector<std::tr1::shared_ptr<Shard> > shards;
 };
 
 
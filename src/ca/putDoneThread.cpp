@@ -10,6 +10,7 @@
 
 #include "caChannel.h"
 #include <epicsExit.h>
+#include <epicsStdio.h>
 #define epicsExportSharedSymbols
 #include "putDoneThread.h"
 
@@ -20,21 +21,23 @@ namespace epics {
 namespace pvAccess {
 namespace ca {
 
-PutDoneThreadPtr PutDoneThread::get()
+PutDoneThreadPtr PutDoneThread::get(size_t nthreads)
 {
     static  PutDoneThreadPtr master;
     static Mutex mutex;
     Lock xx(mutex);
     if(!master) {
-        master = PutDoneThreadPtr(new PutDoneThread());
+        master = PutDoneThreadPtr(new PutDoneThread(nthreads ? nthreads : 1u));
         master->start();
     }
     return master;
 }
 
-PutDoneThread::PutDoneThread()
-: isStop(false)
+PutDoneThread::PutDoneThread(size_t nthreads)
+: shards(nthreads)
 {
+    for(size_t i=0; i<shards.size(); i++)
+        shards[i].reset(new Shard());
 }
 
 PutDoneThread::~PutDoneThread()
@@ -45,37 +48,47 @@ PutDoneThread::~PutDoneThread()
 
 void PutDoneThread::start()
 {
-    thread =  std::tr1::shared_ptr<epicsThread>(new epicsThread(
-        *this,
-        "putDoneThread",
-        epicsThreadGetStackSize(epicsThreadStackBig),
-        epicsThreadPriorityLow));
-    thread->start();
+    for(size_t i=0; i<shards.size(); i++) {
+        char name[32];
+        if(shards.size()==1u)
+            epicsSnprintf(name, sizeof(name), "putDoneThread");
+        else
+            epicsSnprintf(name, sizeof(name), "putDoneThread%u", unsigned(i));
+        shards[i]->thread =  std::tr1::shared_ptr<epicsThread>(new epicsThread(
+            *shards[i],
+            name,
+            epicsThreadGetStackSize(epicsThreadStackBig),
+            epicsThreadPriorityLow));
+        shards[i]->thread->start();
+    }
 }
 
-
 void PutDoneThread::stop()
 {
-    {
-        Lock xx(mutex);
-        isStop = true;
+    for(size_t i=0; i<shards.size(); i++) {
+        {
+            Lock xx(shards[i]->mutex);
+            shards[i]->isStop = true;
+        }
+        shards[i]->waitForCommand.signal();
     }
-    waitForCommand.signal();
-    waitForStop.wait();
+    for(size_t i=0; i<shards.size(); i++)
+        shards[i]->waitForStop.wait();
 }
 
-void PutDoneThread::putDone(NotifyPutRequesterPtr const &notifyPutRequester)
+void PutDoneThread::putDone(NotifyPutRequesterPtr const &notifyPutRequester, const void *channel)
 {
+    Shard& shard(*shards[shardIndex(channel, shards.size())]);
     {
-        Lock lock(mutex);
+        Lock lock(shard.mutex);
         if(notifyPutRequester->isOnQueue) return;
         notifyPutRequester->isOnQueue = true;
-        notifyPutQueue.push(notifyPutRequester);
+        shard.notifyPutQueue.push(notifyPutRequester);
     }
-    waitForCommand.signal();
+    shard.waitForCommand.signal();
 }
 
-void PutDoneThread::run()
+void PutDoneThread::Shard::run()
 {
     while(true)
     {
@@ -10,6 +10,7 @@
 #ifndef PutDoneThread_H
 #define PutDoneThread_H
 #include <queue>
+#include <vector>
 #include <cadef.h>
 #include <shareLib.h>
 #include <epicsThread.h>
@@ -44,24 +45,39 @@ public:
 };
 
 
-class PutDoneThread :
-     public epicsThreadRunable
+/**
+ * Calls CAChannelPut::notifyClient(), on completion of a put or get, from one, or several, threads.
+ * Each channel is assigned to one thread, so notifications of a channel are delivered in order.
+ */
+class PutDoneThread
 {
 public:
-    static PutDoneThreadPtr get();
+    /**
+     * @param nthreads Number of threads.  Used only by the first call, 0 for the default of 1.
+     */
+    static PutDoneThreadPtr get(size_t nthreads = 0u);
     ~PutDoneThread();
-    virtual void run();
-    void start();
     void stop();
-    void putDone(NotifyPutRequesterPtr const &notifyPutRequester);
+    /**
+     * @param channel Identifies the channel, to select a thread.
+     */
+    void putDone(NotifyPutRequesterPtr const &notifyPutRequester, const void *channel);
 private:
-    PutDoneThread();
-    bool isStop;
-    std::tr1::shared_ptr<epicsThread> thread;
-    epics::pvData::Mutex mutex;
-    epics::pvData::Event waitForCommand;
-    epics::pvData::Event waitForStop;
-    std::queue<NotifyPutRequesterWPtr> notifyPutQueue;
+    explicit PutDoneThread(size_t nthreads);
+    void start();
+
+    struct Shard : public epicsThreadRunable
+    {
+        bool isStop;
+        std::tr1::shared_ptr<epicsThread> thread;
+        epics::pvData::Mutex mutex;
+        epics::pvData::Event waitForCommand;
+        epics::pvData::Event waitForStop;
+        std::queue<NotifyPutRequesterWPtr> notifyPutQueue;
+        Shard() : isStop(false) {}
+        virtual void run();
+    };
+    std::vector<std::tr1::shared_ptr<Shard> > shards;
 };
 
 
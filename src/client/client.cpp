@@ -38,6 +38,8 @@ struct ClientChannel::Impl : public pva::ChannelRequester,
 {
     epicsMutex mutex;
     pva::Channel::shared_pointer channel;
+    // const after ctor
+    pva::ArrayAllocator::shared_pointer allocator;
     // assume few listeners per channel, store in vector
     typedef std::vector<ClientChannel::ConnectCallback*> listeners_t;
     listeners_t listeners;
@@ -119,7 +121,9 @@ ClientChannel::Options::Options()
 
 bool ClientChannel::Options::operator<(const Options& O) const
 {
-    return priority<O.priority || (priority==O.priority && address<O.address);
+    return priority<O.priority
+            || (priority==O.priority && address<O.address)
+            || (priority==O.priority && address==O.address && allocator<O.allocator);
 }
 
 Operation::Operation(const std::tr1::shared_ptr<Impl>& i)
@@ -147,6 +151,7 @@ ClientChannel::ClientChannel(const std::tr1::shared_ptr<pva::ChannelProvider>& p
         THROW_EXCEPTION2(std::logic_error, "empty channel name not allowed");
     if(!provider)
         THROW_EXCEPTION2(std::logic_error, "NULL ChannelProvider");
+    impl->allocator = opt.allocator;
     impl->channel = provider->createChannel(name, impl->internal_shared_from_this(),
                                             opt.priority, opt.address);
     if(!impl->channel)
@@ -232,6 +237,10 @@ std::tr1::shared_ptr<epics::pvAccess::Channel>
 ClientChannel::getChannel()
 { return impl->channel; }
 
+std::tr1::shared_ptr<epics::pvAccess::ArrayAllocator>
+ClientChannel::getAllocator()
+{ return impl->allocator; }
+
 struct ClientProvider::Impl
 {
     static size_t num_instances;
@@ -24,6 +24,7 @@ using pvac::detail::CallbackUse;
 
 struct Getter : public pvac::detail::CallbackStorage,
                 public pva::ChannelGetRequester,
+                public pva::ArrayAllocator,
                 public pvac::Operation::Impl,
                 public pvac::detail::wrapped_shared_from_this<Getter>
 {
@@ -32,6 +33,9 @@ struct Getter : public pvac::detail::CallbackStorage,
     pvac::ClientChannel::GetCallback *cb;
     pvac::GetEvent event;
 
+    // const after ClientChannel::get()
+    pva::ArrayAllocator::shared_pointer allocator;
+
     static size_t num_instances;
 
     explicit Getter(pvac::ClientChannel::GetCallback* cb) :cb(cb)
@@ -81,6 +85,11 @@ struct Getter : public pvac::detail::CallbackStorage,
         return op ? op->getChannel()->getRequesterName() : "<dead>";
     }
 
+    virtual pvd::shared_vector<void> allocate(pvd::ScalarType type, size_t count) OVERRIDE FINAL
+    {
+        return allocator ? allocator->allocate(type, count) : pvd::shared_vector<void>();
+    }
+
     virtual void channelGetConnect(
         const epics::pvData::Status& status,
         pva::ChannelGet::shared_pointer const & channelGet,
@@ -156,6 +165,7 @@ ClientChannel::get(ClientChannel::GetCallback* cb,
         pvRequest = pvd::createRequest("field()");
 
     std::tr1::shared_ptr<Getter> ret(Getter::build(cb));
+    ret->allocator = getAllocator();
 
     {
         Guard G(ret->mutex);
@@ -24,6 +24,7 @@ using pvac::detail::CallbackUse;
 
 struct Monitor::Impl : public pvac::detail::CallbackStorage,
                        public pva::MonitorRequester,
+                       public pva::ArrayAllocator,
                        public pvac::detail::wrapped_shared_from_this<Monitor::Impl>
 {
     pva::Channel::shared_pointer chan;
@@ -35,6 +36,9 @@ struct Monitor::Impl : public pvac::detail::CallbackStorage,
 
     pva::MonitorElement::Ref last;
 
+    // const after ClientChannel::monitor()
+    pva::ArrayAllocator::shared_pointer allocator;
+
     static size_t num_instances;
 
     Impl(ClientChannel::MonitorCallback* cb)
@@ -114,6 +118,11 @@ struct Monitor::Impl : public pvac::detail::CallbackStorage,
         return chan ? chan->getRequesterName() : "<dead>";
     }
 
+    virtual pvd::shared_vector<void> allocate(pvd::ScalarType type, size_t count) OVERRIDE FINAL
+    {
+        return allocator ? allocator->allocate(type, count) : pvd::shared_vector<void>();
+    }
+
 
     virtual void monitorConnect(pvd::Status const & status,
                                 pva::MonitorPtr const & operation,
@@ -208,6 +217,7 @@ bool Monitor::poll()
         const epics::pvData::PVStructurePtr& ptr = impl->last->pvStructurePtr;
         changed = *impl->last->changedBitSet;
         overrun = *impl->last->overrunBitSet;
+        trace = impl->last->trace;
 
         /* copy the exposed PVStructure for two reasons.
          * 1. Prevent accidental use of shared container after release()
@@ -225,11 +235,25 @@ bool Monitor::poll()
     } else {
         changed.clear();
         overrun.clear();
+        trace = pva::MonitorElement::Trace();
         impl->seenEmpty = true;
     }
     return !impl->seenEmpty;
 }
 
+void Monitor::stats(pva::Monitor::Stats& s) const
+{
+    pva::Monitor::shared_pointer op;
+    if(impl) {
+        Guard G(impl->mutex);
+        op = impl->op;
+    }
+    if(op)
+        op->getStats(s);
+    else
+        s = pva::Monitor::Stats();
+}
+
 bool Monitor::complete() const
 {
     if(!impl) return true;
@@ -247,6 +271,7 @@ ClientChannel::monitor(MonitorCallback *cb,
 
     std::tr1::shared_ptr<Monitor::Impl> ret(Monitor::Impl::build(cb));
     ret->chan = getChannel();
+    ret->allocator = getAllocator();
 
     {
         Guard G(ret->mutex);
@@ -7,6 +7,7 @@
 #include <stdexcept>
 
 #include <epicsGuard.h>
+#include <epicsAtomic.h>
 #include <epicsMath.h>
 #include <pv/reftrack.h>
 
@@ -14,14 +15,62 @@
 #include <pv/monitor.h>
 #include <pv/pvAccess.h>
 #include <pv/createRequest.h>
+#include <pv/pvAccessMB.h>
 
 namespace pvd = epics::pvData;
 
 typedef epicsGuard<epicsMutex> Guard;
 typedef epicsGuardRelease<epicsMutex> UnGuard;
 
+namespace {
+/* Drop references to array (and union) storage held by an element
+ * which is no longer queued.  Only fields marked changed are ever sent,
+ * and post() replaces them, so the element need not keep old values.
+ * This lets buffers shared by reference (eg. pvas::wrapBuffer()) be released
+ * once sent, instead of when the element is next reused.
+ * Fixed size and immutable arrays are left alone as they can't be emptied.
+ */
+void dropArrays(pvd::PVStructure& root)
+{
+    const pvd::PVFieldPtrArray& fields = root.getPVFields();
+    for(size_t i=0, N=fields.size(); i<N; i++) {
+        pvd::PVField *fld = fields[i].get();
+        switch(fld->getField()->getType()) {
+        case pvd::structure:
+            dropArrays(static_cast<pvd::PVStructure&>(*fld));
+            break;
+        case pvd::scalarArray: {
+            pvd::PVScalarArray *arr = static_cast<pvd::PVScalarArray*>(fld);
+            if(arr->getLength()!=0u && !arr->isImmutable()
+                    && arr->getArray()->getArraySizeType()!=pvd::Array::fixed)
+                arr->putFrom(pvd::shared_vector<const pvd::int8>());
+        }
+            break;
+        case pvd::union_: {
+            pvd::PVUnion *un = static_cast<pvd::PVUnion*>(fld);
+            if(un->get() && !un->isImmutable())
+                un->set(pvd::PVUnion::UNDEFINED_INDEX, pvd::PVFieldPtr());
+        }
+            break;
+        default:
+            break;
+        }
+    }
+}
+} // namespace
+
 namespace epics {namespace pvAccess {
 
+namespace detail {
+namespace {
+size_t wrappedBuffers;
+}
+
+void wrappedBufferAdd() { epics::atomic::increment(wrappedBuffers); }
+void wrappedBufferRemove() { epics::atomic::decrement(wrappedBuffers); }
+bool haveWrappedBuffers() { return epics::atomic::get(wrappedBuffers)!=0u; }
+} // namespace detail
+
 MonitorFIFO::Config::Config()
     :maxCount(4)
     ,defCount(4)
@@ -43,6 +92,7 @@ MonitorFIFO::MonitorFIFO(const std::tr1::shared_ptr<MonitorRequester> &requester
     ,upstream(source)
     ,state(Closed)
     ,pipeline(false)
+    ,trace(false)
     ,running(false)
     ,finished(false)
     ,needConnected(false)
@@ -51,6 +101,7 @@ MonitorFIFO::MonitorFIFO(const std::tr1::shared_ptr<MonitorRequester> &requester
     ,needClosed(false)
     ,freeHighLevel(0u)
     ,flowCount(0)
+    ,noverrun(0u)
 {
     REFTRACE_INCREMENT(num_instances);
 
@@ -88,6 +139,17 @@ MonitorFIFO::MonitorFIFO(const std::tr1::shared_ptr<MonitorRequester> &requester
         }
     }
 
+    O = pvRequest->getSubField<pvd::PVScalar>("record._options.trace");
+    if(O) {
+        try {
+            trace = O->getAs<pvd::boolean>();
+        } catch(std::exception& e) {
+            std::ostringstream strm;
+            strm<<"invalid trace : "<<e.what();
+            requester->message(strm.str());
+        }
+    }
+
     setFreeHighMark(0.00);
 
     if(inconf)
@@ -106,6 +168,7 @@ void MonitorFIFO::show(std::ostream& strm) const
     // const (after ctor) bits
     strm<<"MonitorFIFO"
           " pipeline="<<pipeline
+        <<" trace="<<trace
         <<" size="<<conf.actualCount
         <<" freeHighLevel="<<freeHighLevel
         <<"\n";
@@ -119,7 +182,7 @@ void MonitorFIFO::show(std::ostream& strm) const
     }
 
     strm<<" running="<<running<<" finished="<<finished<<"\n";
-    strm<<"  #empty="<<empty.size()<<" #returned="<<returned.size()<<" #inuse="<<inuse.size()<<" flowCount="<<flowCount<<"\n";
+    strm<<"  #empty="<<empty.size()<<" #returned="<<returned.size()<<" #inuse="<<inuse.size()<<" flowCount="<<flowCount<<" #overrun="<<noverrun<<"\n";
     strm<<"  events "<<(needConnected?'C':'_')<<(needEvent?'E':'_')<<(needUnlisten?'U':'_')<<(needClosed?'X':'_')
         <<"\n";
 }
@@ -238,6 +301,7 @@ bool MonitorFIFO::tryPost(const pvData::PVStructure& value,
                                        *elem->pvStructurePtr, *elem->changedBitSet);
             elem->overrunBitSet->clear();
             mapper.maskBaseToRequested(overrun, *elem->overrunBitSet);
+            elem->trace = MonitorElement::Trace();
 
             if(inuse.empty() && running)
                 needEvent = true;
@@ -259,6 +323,22 @@ bool MonitorFIFO::tryPost(const pvData::PVStructure& value,
 void MonitorFIFO::post(const pvData::PVStructure& value,
                        const pvd::BitSet& changed,
                        const pvd::BitSet& overrun)
+{
+    _post(value, changed, overrun, 0);
+}
+
+void MonitorFIFO::post(const pvData::PVStructure& value,
+                       const pvd::BitSet& changed,
+                       const pvd::BitSet& overrun,
+                       const MonitorElement::Trace& trace)
+{
+    _post(value, changed, overrun, &trace);
+}
+
+void MonitorFIFO::_post(const pvData::PVStructure& value,
+                        const pvd::BitSet& changed,
+                        const pvd::BitSet& overrun,
+                        const MonitorElement::Trace* trace)
 {
     Guard G(mutex);
 
@@ -293,6 +373,7 @@ void MonitorFIFO::post(const pvData::PVStructure& value,
         *elem->changedBitSet = scratch;
         elem->overrunBitSet->clear();
         mapper.maskBaseToRequested(overrun, *elem->overrunBitSet);
+        elem->trace = trace ? *trace : MonitorElement::Trace();
 
         if(inuse.empty() && running)
             needEvent = true;
@@ -305,14 +386,20 @@ void MonitorFIFO::post(const pvData::PVStructure& value,
     } else {
         // in overflow
         // squash
+        noverrun++;
         elem->overrunBitSet->or_and(*elem->changedBitSet, scratch);
         *elem->changedBitSet |= scratch;
         oscratch.clear();
         mapper.maskBaseToRequested(overrun, oscratch);
         elem->overrunBitSet->or_and(oscratch, scratch);
+        // keep the trace of the oldest update
+        if(trace && !elem->trace.id)
+            elem->trace = *trace;
 
         // leave as inuse.back()
     }
+
+    MB_POINT(pvAccessMB, 4, "MonitorFIFO post");
 }
 
 void MonitorFIFO::notify()
@@ -424,6 +511,12 @@ MonitorElementPtr MonitorFIFO::poll()
 
 void MonitorFIFO::release(MonitorElementPtr const & elem)
 {
+    // elem is not shared with post() until it is back on the empty list.
+    // drop array storage without our lock as this may release an external buffer.
+    // Only worth the walk while some wrapBuffer() buffer is outstanding.
+    if(detail::haveWrappedBuffers())
+        dropArrays(*elem->pvStructurePtr);
+
     size_t nempty;
     {
         Guard G(mutex);
@@ -464,6 +557,7 @@ void MonitorFIFO::getStats(Stats& s) const
     s.nempty = empty.size() + returned.size();
     s.nfilled = inuse.size();
     s.noutstanding = conf.actualCount - s.nempty - s.nfilled;
+    s.noverrun = noverrun;
 }
 
 void MonitorFIFO::reportRemoteQueueStatus(pvd::int32 nfree)
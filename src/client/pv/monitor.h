@@ -18,6 +18,7 @@
 #endif
 
 #include <epicsMutex.h>
+#include <epicsTime.h>
 #include <pv/status.h>
 #include <pv/pvData.h>
 #include <pv/sharedPtr.h>
@@ -59,6 +60,25 @@ public:
     const epics::pvData::BitSet::shared_pointer changedBitSet;
     const epics::pvData::BitSet::shared_pointer overrunBitSet;
 
+    /** End-to-end latency trace of one update.
+     *
+     * Filled in only when a subscriber requests tracing with the pvRequest option
+     * record._options.trace=true , otherwise all zeros.
+     * Times are taken from the clocks of the host where each stage runs.
+     * @since 7.1.3
+     */
+    struct epicsShareClass Trace {
+        epics::pvData::uint64 id; //!< Assigned by pvas::SharedPV::post().  0 for other sources.
+        epicsTimeStamp posted;    //!< when passed to MonitorFIFO::post().  Zero if id==0
+        epicsTimeStamp sent;      //!< when serialized by the server
+        epicsTimeStamp received;  //!< when deserialized by the client
+        Trace();
+        //! Seconds from posted (or sent if id==0) until received.  Negative if not traced.
+        double latency() const;
+    };
+    //! When an element is squashed, the trace of the oldest update is kept.
+    Trace trace;
+
     class Ref;
 };
 
@@ -101,10 +121,29 @@ class epicsShareClass Monitor : public virtual Destroyable{
         size_t nfilled; //!< # of elements ready to be poll()d
         size_t noutstanding; //!< # of elements poll()d but not released()d
         size_t nempty; //!< # of elements available for new remote data
+        size_t noverrun; //!< # of updates squashed into an already filled element
+        enum {nlatency=24};
+        //! Histogram of MonitorElement::Trace::latency() of traced updates received.
+        //! Updates merged into a queued update by an overrun are not counted.
+        //! latency[0] counts latencies below 2us, latency[i] those in [2^i, 2^(i+1)) us,
+        //! and latency[nlatency-1] all longer latencies.
+        //! @since 7.1.3
+        size_t latency[nlatency];
+        Stats() :nfilled(0u), noutstanding(0u), nempty(0u), noverrun(0u) {
+            for(size_t i=0; i<nlatency; i++)
+                latency[i] = 0u;
+        }
+        //! Index in latency[] for a latency in seconds
+        static size_t latencyBucket(double seconds) {
+            size_t i = 0u;
+            for(double us = seconds*1e6; us>=2.0 && i+1u<size_t(nlatency); us/=2.0)
+                i++;
+            return i;
+        }
     };
 
     virtual void getStats(Stats& s) const {
-        s.nfilled = s.noutstanding = s.nempty = 0;
+        s = Stats();
     }
 
     /**
@@ -326,6 +365,16 @@ public:
     void post(const pvData::PVStructure& value,
               const epics::pvData::BitSet& changed,
               const epics::pvData::BitSet& overrun = epics::pvData::BitSet());
+    //! post() an update with a latency trace.
+    //! @since 7.1.3
+    void post(const pvData::PVStructure& value,
+              const epics::pvData::BitSet& changed,
+              const epics::pvData::BitSet& overrun,
+              const MonitorElement::Trace& trace);
+    //! Whether the subscriber requested tracing (pvRequest option record._options.trace=true).
+    //! When false, there is no need to prepare a MonitorElement::Trace for post().
+    //! @since 7.1.3
+    inline bool traced() const { return trace; }
     //! Call after calling any other upstream interface methods (open()/close()/finish()/post()/...)
     //! when no upstream mutexes are locked.
     //! Do not call from Source::freeHighMark().  This is done automatically.
@@ -344,6 +393,10 @@ public:
     size_t freeCount() const;
 private:
     size_t _freeCount() const;
+    void _post(const pvData::PVStructure& value,
+               const epics::pvData::BitSet& changed,
+               const epics::pvData::BitSet& overrun,
+               const MonitorElement::Trace* trace);
 
     friend void providerRegInit(void*);
     static size_t num_instances;
@@ -386,6 +439,7 @@ private:
         Error,  // unsuccessful open()
     } state;
     bool pipeline; // const after ctor
+    bool trace; // const after ctor
     bool running; // start() vs. stop()
     bool finished; // finish() called
     epics::pvData::BitSet scratch, oscratch; // using during post to avoid re-alloc
@@ -399,6 +453,7 @@ private:
 
     size_t freeHighLevel;
     epicsInt32 flowCount;
+    size_t noverrun; // post() squashed into a filled element
 
     epics::pvData::PVRequestMapper mapper;
 
@@ -423,6 +478,15 @@ std::ostream& operator<<(std::ostream& strm, const MonitorFIFO& fifo) {
     return strm;
 }
 
+namespace detail {
+//! Count of buffers wrapped by pvas::wrapBuffer() and not yet released.
+epicsShareFunc void wrappedBufferAdd();
+epicsShareFunc void wrappedBufferRemove();
+//! true if any wrapBuffer() buffer is still referenced somewhere.
+//! MonitorFIFO::release() only drops the arrays of an element while this is so.
+epicsShareFunc bool haveWrappedBuffers();
+} // namespace detail
+
 }}
 
 namespace epics { namespace pvData {
@@ -173,6 +173,30 @@ struct epicsShareClass NetStats {
     virtual void stats(Stats& s) const =0;
 };
 
+/** @brief Application supplied storage for received array values
+ *
+ * A client ChannelGetRequester, ChannelPutGetRequester, or MonitorRequester
+ * which is also dynamic_cast<>able to ArrayAllocator is asked for storage
+ * for each array field about to be received.  This allows large arrays to be
+ * received into buffers recycled by the application, instead of newly allocated.
+ */
+struct epicsShareClass ArrayAllocator {
+    POINTER_DEFINITIONS(ArrayAllocator);
+    virtual ~ArrayAllocator();
+    /** Provide storage for an array field about to be received.
+     *
+     * Called from a client network thread, with locks held.  Must not block or call into pvAccess.
+     *
+     * @param type Element type of the array field.
+     * @param count Length of the previous value of this field.  A hint.
+     * @returns A vector of the requested element type (eg. from epics::pvData::static_shared_vector_cast<void>() ),
+     *          which is not referenced elsewhere.  Its capacity is filled in place.
+     *          If the received array is larger, storage is allocated as usual.
+     *          Return an empty vector to allocate as usual.
+     */
+    virtual epics::pvData::shared_vector<void> allocate(epics::pvData::ScalarType type, size_t count) =0;
+};
+
 //! Base for all Requesters (callbacks to client)
 struct epicsShareClass ChannelBaseRequester : virtual public epics::pvData::Requester
 {
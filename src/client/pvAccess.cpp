@@ -386,6 +386,8 @@ ChannelProvider::~ChannelProvider()
 
 NetStats::~NetStats() {}
 
+ArrayAllocator::~ArrayAllocator() {}
+
 size_t ChannelBaseRequester::num_instances;
 
 ChannelBaseRequester::ChannelBaseRequester()
@@ -453,6 +455,22 @@ MonitorElement::MonitorElement(epics::pvData::PVStructurePtr const & pvStructure
     ,overrunBitSet(epics::pvData::BitSet::create(static_cast<epics::pvData::uint32>(pvStructurePtr->getNumberFields())))
 {}
 
+MonitorElement::Trace::Trace()
+    :id(0u)
+{
+    posted.secPastEpoch = posted.nsec = 0u;
+    sent.secPastEpoch = sent.nsec = 0u;
+    received.secPastEpoch = received.nsec = 0u;
+}
+
+double MonitorElement::Trace::latency() const
+{
+    const epicsTimeStamp& start = id ? posted : sent;
+    if(received.secPastEpoch==0u || start.secPastEpoch==0u)
+        return -1.0;
+    return epicsTimeDiffInSeconds(&received, &start);
+}
+
 }} // namespace epics::pvAccess
 
 namespace {
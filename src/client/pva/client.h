@@ -13,6 +13,8 @@
 
 #include <pv/pvData.h>
 #include <pv/bitSet.h>
+// pvac::Monitor holds a MonitorElement::Trace by value, and fills a Monitor::Stats
+#include <pv/monitor.h>
 
 class epicsEvent;
 
@@ -21,6 +23,7 @@ class ChannelProvider;
 class Channel;
 class Monitor;
 class Configuration;
+struct ArrayAllocator;
 }}//namespace epics::pvAccess
 
 //! See @ref pvac API
@@ -160,6 +163,18 @@ struct epicsShareClass Monitor
     epics::pvData::PVStructure::const_shared_pointer root;
     epics::pvData::BitSet changed,
                           overrun;
+    /** Latency trace of the update extracted by the last poll()==true .
+     *
+     * All zeros unless requested with the pvRequest option record._options.trace=true ,
+     * eg. pvRequest "record[trace=true]field()" .
+     * trace.latency() is the time from the server post() until received by this client.
+     * @since 7.1.3
+     */
+    epics::pvAccess::MonitorElement::Trace trace;
+
+    //! Queue statistics, including a histogram of traced update latencies.
+    //! @since 7.1.3
+    void stats(epics::pvAccess::Monitor::Stats& s) const;
 
     bool valid() const { return !!impl; }
 
@@ -282,6 +297,9 @@ public:
     struct epicsShareClass Options {
         short priority;
         std::string address;
+        //! If set, provides storage for arrays received by get() and monitor() operations.
+        //! @see epics::pvAccess::ArrayAllocator
+        std::tr1::shared_ptr<epics::pvAccess::ArrayAllocator> allocator;
         Options();
         bool operator<(const Options&) const;
     };
@@ -458,6 +476,7 @@ public:
     void show(std::ostream& strm) const;
 private:
     std::tr1::shared_ptr<epics::pvAccess::Channel> getChannel();
+    std::tr1::shared_ptr<epics::pvAccess::ArrayAllocator> getAllocator();
 };
 
 namespace detail {
@@ -7,7 +7,218 @@
 #ifndef _PVACCESSMB_H_
 #define _PVACCESSMB_H_
 
-/* this header is deprecated */
+/** @file pvAccessMB.h
+ *
+ * Micro-benchmark points.
+ *
+ * Compiled in only when the library, and code using these macros, is built with WITH_MICROBENCH defined.
+ * eg. add "WITH_MICROBENCH=YES" to configure/CONFIG_SITE.local .
+ * Otherwise all macros expand to nothing.
+ *
+ * Each MB_POINT() records (stage, ID, cycle counter) in a ring buffer private to the calling thread,
+ * without locking.  Points with the same ID are one sample of a path through a sequence of stages.
+ * A thread's auto ID is 0, and MB_POINT() records nothing, until MB_INC_AUTO_ID() or MB_SET_AUTO_ID().
+ * The ring of a thread created by epicsThread is reused by a later thread once it exits.
+ * MB_STATS() prints the latency between successive stages (STAGE_ONLY!=0) or since the first stage.
+ * Statistics and export are meant to be run after a measurement, as they race with concurrent points
+ * which overwrite the oldest entries of a full ring.
+ *
+ * The library records the path of an update through a server in the Entity pvAccessMB.
+ *
+ * 1. receive header
+ * 2. handler dispatch
+ * 3. deserialize (put data)
+ * 4. MonitorFIFO post
+ * 5. send-queue enqueue
+ * 6. serialize (monitor update)
+ * 7. socket write
+ *
+ * Stages 1-5 are correlated through the auto ID of the receiving thread, so only updates posted
+ * synchronously in response to a Put (eg. a mailbox SharedPV) form a complete sample.
+ * Stages 6 and 7 run on the send thread, with the ID carried over from stage 5 of the same subscription.
+ *
+ @code
+   MB_INIT;
+   ... run a client putting to a mailbox PV which another client monitors ...
+   MB_STATS(pvAccessMB, std::cout);
+   MB_CSV_EXPORT(pvAccessMB, outfile);
+ @endcode
+ */
+
+#ifdef WITH_MICROBENCH
+
+#ifdef epicsExportSharedSymbols
+#   define pvAccessMBEpicsExportSharedSymbols
+#   undef epicsExportSharedSymbols
+#endif
+
+#include <ostream>
+#include <istream>
+#include <vector>
+
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#  include <intrin.h>
+#endif
+
+#include <epicsMutex.h>
+#include <epicsThread.h>
+#include <epicsTime.h>
+#include <epicsAtomic.h>
+
+#include <pv/pvType.h>
+#include <pv/sharedPtr.h>
+#include <pv/noDefaultMethods.h>
+
+#ifdef pvAccessMBEpicsExportSharedSymbols
+#   define epicsExportSharedSymbols
+#   undef pvAccessMBEpicsExportSharedSymbols
+#endif
+
+#include <shareLib.h>
+
+namespace epics {
+namespace pvAccess {
+namespace mb {
+
+//! Read the CPU cycle counter (TSC) where available, otherwise the time in ns.
+inline epics::pvData::uint64 ticks()
+{
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+    epics::pvData::uint32 lo, hi;
+    __asm__ __volatile__ ("rdtsc" : "=a"(lo), "=d"(hi));
+    return (epics::pvData::uint64(hi)<<32) | lo;
+#elif defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+    return __rdtsc();
+#else
+    epicsTimeStamp now;
+    epicsTimeGetCurrent(&now);
+    return epics::pvData::uint64(now.secPastEpoch)*1000000000u + now.nsec;
+#endif
+}
+
+//! Rate of ticks().  Calibrated by the first call, which takes ~0.1 seconds.
+epicsShareFunc double ticksPerSecond();
+
+struct Point {
+    epics::pvData::uint64 id;
+    epics::pvData::uint64 time; //!< ticks()
+    const char *desc;
+    epics::pvData::uint8 stage;
+};
+
+class epicsShareClass Entity {
+    struct Ring {
+        std::vector<Point> points;
+        size_t mask;
+        size_t head; // total points recorded.  Written only by owning thread
+        epics::pvData::uint64 autoId; // only accessed by owning thread.  0 outside of a sample
+        epics::pvData::uint64 nextId; // only accessed by owning thread
+        epicsMutex lock; // guards owner
+        Entity *owner; // NULL once the Entity is destroyed
+    };
+    typedef std::tr1::shared_ptr<Ring> ring_t;
+public:
+    //! @param size Number of points kept for each thread.  Rounded up to a power of 2.
+    Entity(const char *name, size_t size);
+    ~Entity();
+
+    void point(epics::pvData::uint8 stage, const char *desc, epics::pvData::uint64 id)
+    {
+        Ring *R = ring();
+        const size_t h = R->head;
+        Point& P = R->points[h & R->mask];
+        P.id = id;
+        P.time = ticks();
+        P.desc = desc;
+        P.stage = stage;
+        epics::atomic::set(R->head, h+1u); // publish
+    }
+
+    //! Record a point with the auto ID of the calling thread, if it is part of a sample
+    void autoPoint(epics::pvData::uint8 stage, const char *desc)
+    {
+        const epics::pvData::uint64 id = ring()->autoId;
+        if(id)
+            point(stage, desc, id);
+    }
+
+    //! ID used by MB_POINT() in the calling thread
+    epics::pvData::uint64 autoId() { return ring()->autoId; }
+    void setAutoId(epics::pvData::uint64 id) { ring()->autoId = id; }
+    //! Begin a new sample in the calling thread.  IDs from different threads do not collide.
+    void incAutoId() { Ring *R = ring(); R->autoId = ++R->nextId; }
+
+    //! Report IDs, and times, relative to the smallest ID, and earliest time, currently recorded.
+    void normalize();
+
+    void stats(std::ostream& strm, bool stageOnly, size_t skip);
+    void csvExport(std::ostream& strm, bool stageOnly, size_t skip);
+    //! Add points previously written by csvExport() with stageOnly==false
+    void csvImport(std::istream& strm);
+    void print(std::ostream& strm, bool stageOnly, size_t skip);
+
+private:
+    Ring* ring()
+    {
+        Ring *R = static_cast<Ring*>(epicsThreadPrivateGet(key));
+        return R ? R : addRing();
+    }
+    Ring* addRing();
+    //! epicsAtThreadExit() callback which makes a ring available for reuse
+    static void ringExit(void *raw);
+
+    //! All points, grouped by ID in ID order, and by time within an ID.  The first 'skip' IDs are omitted.
+    void snapshot(std::vector<Point>& points, size_t skip);
+
+    const char * const name;
+    size_t size;
+    epicsThreadPrivateId key;
+
+    epicsMutex mutex;
+    std::vector<ring_t> rings;
+    std::vector<ring_t> idle; // rings of exited threads
+    std::vector<Point> imported;
+    size_t nthreads;
+    epics::pvData::uint64 idBase, timeBase;
+
+    EPICS_NOT_COPYABLE(Entity)
+};
+
+}}} // namespace epics::pvAccess::mb
+
+//! Points recorded by the pvAccess library
+epicsShareExtern ::epics::pvAccess::mb::Entity pvAccessMB;
+
+#define MB_DECLARE(NAME, SIZE) ::epics::pvAccess::mb::Entity NAME(#NAME, SIZE)
+#define MB_DECLARE_EXTERN(NAME) extern ::epics::pvAccess::mb::Entity NAME
+
+#define MB_POINT_ID(NAME, STAGE, STAGE_DESC, ID) (NAME).point(STAGE, STAGE_DESC, ID)
+
+#define MB_INC_AUTO_ID(NAME) (NAME).incAutoId()
+#define MB_POINT(NAME, STAGE, STAGE_DESC) (NAME).autoPoint(STAGE, STAGE_DESC)
+
+//! Store the auto ID of the calling thread in VAR, to be passed to MB_SET_AUTO_ID() on another thread.
+#define MB_GET_AUTO_ID(NAME, VAR) (VAR) = (NAME).autoId()
+#define MB_SET_AUTO_ID(NAME, ID) (NAME).setAutoId(ID)
+
+#define MB_POINT_CONDITIONAL(NAME, STAGE, STAGE_DESC, COND) do { if(COND) MB_POINT(NAME, STAGE, STAGE_DESC); } while(0)
+
+#define MB_NORMALIZE(NAME) (NAME).normalize()
+
+#define MB_STATS(NAME, STREAM) (NAME).stats(STREAM, true, 0u)
+#define MB_STATS_OPT(NAME, STAGE_ONLY, SKIP_FIRST_N_SAMPLES, STREAM) (NAME).stats(STREAM, STAGE_ONLY, SKIP_FIRST_N_SAMPLES)
+
+#define MB_CSV_EXPORT(NAME, STREAM) (NAME).csvExport(STREAM, false, 0u)
+#define MB_CSV_EXPORT_OPT(NAME, STAGE_ONLY, SKIP_FIRST_N_SAMPLES, STREAM) (NAME).csvExport(STREAM, STAGE_ONLY, SKIP_FIRST_N_SAMPLES)
+#define MB_CSV_IMPORT(NAME, STREAM) (NAME).csvImport(STREAM)
+
+#define MB_PRINT(NAME, STREAM) (NAME).print(STREAM, true, 0u)
+#define MB_PRINT_OPT(NAME, STAGE_ONLY, SKIP_FIRST_N_SAMPLES, STREAM) (NAME).print(STREAM, STAGE_ONLY, SKIP_FIRST_N_SAMPLES)
+
+//! Calibrate ticks() before measuring
+#define MB_INIT ::epics::pvAccess::mb::ticksPerSecond()
+
+#else // WITH_MICROBENCH
 
 #define MB_DECLARE(NAME, SIZE)
 #define MB_DECLARE_EXTERN(NAME)
@@ -17,6 +228,9 @@
 #define MB_INC_AUTO_ID(NAME)
 #define MB_POINT(NAME, STAGE, STAGE_DESC)
 
+#define MB_GET_AUTO_ID(NAME, VAR)
+#define MB_SET_AUTO_ID(NAME, ID)
+
 #define MB_POINT_CONDITIONAL(NAME, STAGE, STAGE_DESC, COND)
 
 #define MB_NORMALIZE(NAME)
@@ -33,4 +247,6 @@
 
 #define MB_INIT
 
+#endif // WITH_MICROBENCH
+
 #endif
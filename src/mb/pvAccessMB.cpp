@@ -0,0 +1,307 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * pvAccessCPP is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#ifdef WITH_MICROBENCH
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <sstream>
+#include <cmath>
+
+#include <epicsGuard.h>
+#include <epicsExit.h>
+
+#define epicsExportSharedSymbols
+#include <pv/pvAccessMB.h>
+
+typedef epicsGuard<epicsMutex> Guard;
+
+namespace pvd = epics::pvData;
+
+// enough for several seconds of updates on each server thread
+MB_DECLARE(pvAccessMB, 1u<<16);
+
+namespace epics {
+namespace pvAccess {
+namespace mb {
+
+namespace {
+
+epicsThreadOnceId calibrateOnce = EPICS_THREAD_ONCE_INIT;
+double tps;
+
+void calibrate(void *)
+{
+    epicsTimeStamp start, end;
+    epicsTimeGetCurrent(&start);
+    pvd::uint64 T0 = ticks();
+    epicsThreadSleep(0.1);
+    pvd::uint64 T1 = ticks();
+    epicsTimeGetCurrent(&end);
+    double dt = epicsTimeDiffInSeconds(&end, &start);
+    tps = dt>0.0 ? (T1-T0)/dt : 1e9;
+}
+
+bool byIdTime(const Point& lhs, const Point& rhs)
+{
+    return lhs.id<rhs.id || (lhs.id==rhs.id && lhs.time<rhs.time);
+}
+
+// ticks to ns
+double ns(pvd::uint64 dt)
+{
+    return dt/ticksPerSecond()*1e9;
+}
+
+// descriptions of imported Points
+std::map<std::string, std::string> descs;
+epicsMutex descsLock;
+
+struct Stat {
+    const char *desc;
+    size_t count;
+    double sum, sum2, min, max;
+    Stat() :desc(0), count(0u), sum(0.0), sum2(0.0), min(0.0), max(0.0) {}
+    void add(double v) {
+        if(count==0u || v<min) min = v;
+        if(count==0u || v>max) max = v;
+        count++;
+        sum += v;
+        sum2 += v*v;
+    }
+};
+
+} // namespace
+
+double ticksPerSecond()
+{
+    epicsThreadOnce(&calibrateOnce, &calibrate, 0);
+    return tps;
+}
+
+Entity::Entity(const char *name, size_t size)
+    :name(name)
+    ,size(1u)
+    ,key(epicsThreadPrivateCreate())
+    ,nthreads(0u)
+    ,idBase(0u)
+    ,timeBase(0u)
+{
+    while(this->size < size)
+        this->size <<= 1u;
+}
+
+Entity::~Entity()
+{
+    epicsThreadPrivateDelete(key);
+    // rings of running threads are freed when they exit
+    for(size_t i=0; i<rings.size(); i++) {
+        Guard G(rings[i]->lock);
+        rings[i]->owner = 0;
+    }
+}
+
+Entity::Ring* Entity::addRing()
+{
+    ring_t R;
+    {
+        Guard G(mutex);
+        if(!idle.empty()) {
+            // points of the previous thread are kept until overwritten
+            R = idle.back();
+            idle.pop_back();
+        } else {
+            R.reset(new Ring);
+            R->points.resize(size);
+            R->mask = size-1u;
+            R->head = 0u;
+            R->owner = this;
+            rings.push_back(R);
+        }
+        // thread index in upper bits so that auto IDs of different threads are distinct
+        R->nextId = pvd::uint64(++nthreads)<<40;
+        R->autoId = 0u;
+    }
+    // only called for threads created by epicsThread, others keep their ring
+    ring_t *pring = new ring_t(R);
+    if(epicsAtThreadExit(&ringExit, pring))
+        delete pring;
+    epicsThreadPrivateSet(key, R.get());
+    return R.get();
+}
+
+void Entity::ringExit(void *raw)
+{
+    ring_t *pring = static_cast<ring_t*>(raw);
+    {
+        Ring& R = **pring;
+        Guard G(R.lock);
+        if(R.owner) {
+            Guard G2(R.owner->mutex);
+            R.owner->idle.push_back(*pring);
+        }
+    }
+    delete pring;
+}
+
+void Entity::snapshot(std::vector<Point>& points, size_t skip)
+{
+    {
+        Guard G(mutex);
+        points = imported;
+        for(size_t i=0; i<rings.size(); i++) {
+            const Ring& R = *rings[i];
+            const size_t head = epics::atomic::get(R.head);
+            const size_t n = std::min(head, R.points.size());
+            for(size_t p = head-n; p<head; p++)
+                points.push_back(R.points[p & R.mask]);
+        }
+    }
+
+    std::sort(points.begin(), points.end(), &byIdTime);
+
+    if(skip) {
+        size_t ids = 0u, i = 0u;
+        for(; i<points.size(); i++) {
+            if(i==0u || points[i].id!=points[i-1].id) {
+                if(ids++==skip)
+                    break;
+            }
+        }
+        points.erase(points.begin(), points.begin()+i);
+    }
+}
+
+void Entity::normalize()
+{
+    std::vector<Point> points;
+    snapshot(points, 0u);
+
+    Guard G(mutex);
+    idBase = timeBase = 0u;
+    for(size_t i=0; i<points.size(); i++) {
+        if(i==0u || points[i].time<timeBase)
+            timeBase = points[i].time;
+    }
+    if(!points.empty())
+        idBase = points.front().id;
+}
+
+void Entity::stats(std::ostream& strm, bool stageOnly, size_t skip)
+{
+    std::vector<Point> points;
+    snapshot(points, skip);
+
+    std::map<pvd::uint8, Stat> stages;
+    size_t samples = 0u;
+
+    for(size_t i=0, first=0; i<points.size(); i++) {
+        if(i==0u || points[i].id!=points[i-1].id) {
+            first = i;
+            samples++;
+        }
+        Stat& S = stages[points[i].stage];
+        S.desc = points[i].desc;
+        if(i!=first)
+            S.add(ns(points[i].time - points[stageOnly ? i-1u : first].time));
+    }
+
+    strm<<name<<": "<<samples<<" samples, ns "<<(stageOnly ? "since previous stage" : "since first stage")<<"\n";
+    for(std::map<pvd::uint8, Stat>::const_iterator it(stages.begin()), end(stages.end()); it!=end; ++it) {
+        const Stat& S = it->second;
+        strm<<"  "<<unsigned(it->first)<<" "<<(S.desc ? S.desc : "")<<": "<<S.count;
+        if(S.count) {
+            double mean = S.sum/S.count;
+            double var = S.sum2/S.count - mean*mean;
+            strm<<" min "<<S.min<<" mean "<<mean<<" max "<<S.max<<" stddev "<<std::sqrt(var>0.0 ? var : 0.0);
+        }
+        strm<<"\n";
+    }
+}
+
+void Entity::csvExport(std::ostream& strm, bool stageOnly, size_t skip)
+{
+    std::vector<Point> points;
+    snapshot(points, skip);
+
+    pvd::uint64 idBase, timeBase;
+    {
+        Guard G(mutex);
+        idBase = this->idBase;
+        timeBase = this->timeBase;
+    }
+
+    strm<<"id,stage,description,ns\n";
+    for(size_t i=0, first=0; i<points.size(); i++) {
+        if(i==0u || points[i].id!=points[i-1].id)
+            first = i;
+        pvd::uint64 ref = timeBase;
+        if(stageOnly && i!=first)
+            ref = points[i-1].time;
+        else if(stageOnly)
+            ref = points[first].time;
+        strm<<(points[i].id-idBase)<<','<<unsigned(points[i].stage)<<','
+            <<(points[i].desc ? points[i].desc : "")<<','
+            <<pvd::uint64(ns(points[i].time-ref))<<"\n";
+    }
+}
+
+void Entity::csvImport(std::istream& strm)
+{
+    std::vector<Point> points;
+    std::string line;
+    while(std::getline(strm, line)) {
+        std::istringstream fields(line);
+        std::string id, stage, desc, time;
+        if(!std::getline(fields, id, ',') || !std::getline(fields, stage, ',')
+                || !std::getline(fields, desc, ',') || !std::getline(fields, time))
+            continue;
+        if(id.empty() || id[0]<'0' || id[0]>'9')
+            continue; // header
+
+        Point P;
+        std::istringstream(id)>>P.id;
+        unsigned st = 0u;
+        std::istringstream(stage)>>st;
+        P.stage = pvd::uint8(st);
+        double t = 0.0;
+        std::istringstream(time)>>t;
+        P.time = pvd::uint64(t*1e-9*ticksPerSecond());
+        {
+            Guard G(descsLock);
+            P.desc = descs.insert(std::make_pair(desc, desc)).first->second.c_str();
+        }
+        points.push_back(P);
+    }
+
+    Guard G(mutex);
+    imported.insert(imported.end(), points.begin(), points.end());
+}
+
+void Entity::print(std::ostream& strm, bool stageOnly, size_t skip)
+{
+    std::vector<Point> points;
+    snapshot(points, skip);
+
+    for(size_t i=0, first=0; i<points.size(); i++) {
+        if(i==0u || points[i].id!=points[i-1].id) {
+            first = i;
+            if(i!=0u)
+                strm<<"\n";
+            strm<<points[i].id<<":";
+        }
+        strm<<" "<<unsigned(points[i].stage);
+        if(i!=first)
+            strm<<" +"<<ns(points[i].time - points[stageOnly ? i-1u : first].time)<<"ns";
+    }
+    if(!points.empty())
+        strm<<"\n";
+}
+
+}}} // namespace epics::pvAccess::mb
+
+#endif // WITH_MICROBENCH
@@ -8,6 +8,10 @@
 #include <vector>
 #include <queue>
 #include <utility>
+#include <algorithm>
+
+#include <epicsEvent.h>
+#include <epicsTime.h>
 
 #define epicsExportSharedSymbols
 #include <pv/pipelineServer.h>
@@ -52,6 +56,19 @@ private:
 
     bool m_unlistenReported;
 
+    // signaled when credits may have become available, or on done/destroy
+    epicsEvent m_creditEvent;
+
+    // m_monitorQueueLock must be locked
+    size_t availableCredits()
+    {
+        size_t queued = m_monitorQueue.size();
+        size_t requested = m_requestedCount > queued ? m_requestedCount - queued : 0u;
+
+        Lock guard(m_freeQueueLock);
+        return std::min(requested, m_freeQueue.size());
+    }
+
 public:
     ChannelPipelineMonitorImpl(
         Channel::shared_pointer const & channel,
@@ -185,8 +202,31 @@ public:
 
     virtual void release(MonitorElement::shared_pointer const & monitorElement)
     {
-        Lock guard(m_freeQueueLock);
-        m_freeQueue.push_back(monitorElement);
+        bool notify = false;
+        size_t credits = 0u;
+        {
+            Lock guard(m_monitorQueueLock);
+            bool wasEmpty;
+            {
+                Lock freeGuard(m_freeQueueLock);
+                wasEmpty = m_freeQueue.empty();
+                // the free queue never holds more than the queue size.
+                // any further element, whatever its origin, is dropped
+                if (m_freeQueue.size() < m_queueSize)
+                    m_freeQueue.push_back(monitorElement);
+            }
+
+            if (m_done)
+                return;
+
+            credits = availableCredits();
+            notify = wasEmpty && credits != 0;
+        }
+
+        m_creditEvent.signal();
+
+        if (notify)
+            m_pipelineSession->creditsAvailable(shared_from_this(), credits);
     }
 
     virtual void reportRemoteQueueStatus(int32 freeElements)
@@ -203,6 +243,8 @@ public:
             notify = m_active && (m_monitorQueue.size() != 0);
         }
 
+        m_creditEvent.signal();
+
         // notify
         // TODO too many notify calls?
         if (notify)
@@ -225,6 +267,8 @@ public:
             m_done = true;
         }
 
+        m_creditEvent.signal();
+
         if (notifyCancel)
             m_pipelineSession->cancel();
     }
@@ -240,6 +284,50 @@ public:
         return m_requestedCount;
     }
 
+    virtual size_t getAvailableCredits() {
+        Lock guard(m_monitorQueueLock);
+        return availableCredits();
+    }
+
+    virtual bool waitForCredits(size_t count, double timeout) {
+        Lock guard(m_monitorQueueLock);
+        // credits are limited by the free queue, which is never larger
+        if (count > m_queueSize)
+            return false;
+
+        epicsTimeStamp deadline;
+        if (timeout > 0.0) {
+            epicsTimeGetCurrent(&deadline);
+            epicsTimeAddSeconds(&deadline, timeout);
+        }
+
+        while (!m_done) {
+            if (availableCredits() >= count) {
+                guard.unlock();
+                m_creditEvent.signal(); // pass on to any other waiter
+                return true;
+            }
+
+            guard.unlock();
+            bool ok;
+            if (timeout <= 0.0) {
+                m_creditEvent.wait();
+                ok = true;
+            } else {
+                // wakeups which free too few credits don't extend the timeout
+                epicsTimeStamp now;
+                epicsTimeGetCurrent(&now);
+                double remaining = epicsTimeDiffInSeconds(&deadline, &now);
+                ok = remaining > 0.0 && m_creditEvent.wait(remaining);
+            }
+            guard.lock();
+
+            if (!ok)
+                return !m_done && availableCredits() >= count;
+        }
+        return false;
+    }
+
     virtual MonitorElement::shared_pointer getFreeElement() {
         Lock guard(m_freeQueueLock);
         if (m_freeQueue.empty())
@@ -260,9 +348,10 @@ public:
                 return;
             // throw std::logic_error("putElement called after done");
 
+            // the sender polls until the queue is empty,
+            // so only notify when the first element is queued
+            notify = m_monitorQueue.empty() && m_requestedCount != 0;
             m_monitorQueue.push(element);
-            // TODO there is way to much of notification, per each putElement
-            notify = (m_requestedCount != 0);
         }
 
         // notify
@@ -283,6 +372,8 @@ public:
 
         guard.unlock();
 
+        m_creditEvent.signal();
+
         if (report)
             m_monitorRequester->unlisten(shared_from_this());
     }
@@ -56,6 +56,18 @@ public:
     /// This call destroyes corresponding pipeline session.
     virtual void done() = 0;
 
+    /// Number of elements which may be put now without exceeding the client's window.
+    /// ie. the requested count less elements already queued, limited by getFreeElementCount().
+    /// A service may call getFreeElement() and putElement() this many times.
+    virtual size_t getAvailableCredits() = 0;
+
+    /// Block until at least count credits are available,
+    /// the session is done or cancelled, or timeout (in seconds, 0 means forever) expires.
+    /// For use by a service producing from its own thread.
+    /// @returns true if at least count credits are available.
+    ///          false at once if count exceeds the queue size, as that many can never be available.
+    virtual bool waitForCredits(size_t count, double timeout) = 0;
+
 };
 
 
@@ -78,6 +90,12 @@ public:
     /// to provide [PipelineControl.getRequestedCount(), PipelineControl.getFreeElementCount()] elements.
     virtual void request(PipelineControl::shared_pointer const & control, size_t elementCount) = 0;
 
+    /// Notification that elements acknowledged by the client have been returned to the free queue,
+    /// after credits were exhausted for lack of free elements.
+    /// credits is the value of PipelineControl.getAvailableCredits() at the time.
+    /// Called from a server thread, which must not be blocked.
+    virtual void creditsAvailable(PipelineControl::shared_pointer const & /*control*/, size_t /*credits*/) {}
+
     /// Cancel the session (called by the client).
     virtual void cancel() = 0;
 };
@@ -31,6 +31,12 @@ const epics::pvData::int8 PVA_MAGIC = static_cast<epics::pvData::int8>(0xCA);
 const epics::pvData::int8 PVA_SERVER_PROTOCOL_REVISION = 2;
 const epics::pvData::int8 PVA_CLIENT_PROTOCOL_REVISION = 2;
 
+/** Bits of the optional byte which follows the list of authNZ plugins in a server CMD_CONNECTION_VALIDATION.
+ *  Servers which do not send this byte support none of these features.
+ */
+//! Server accepts CMD_CREATE_CHANNEL with count > 1.  Not advertised if $EPICS_PVAS_MULTI_CREATE is NO.
+const epics::pvData::int8 PVA_SERVER_FEATURE_MULTI_CREATE = 0x01;
+
 /** PVA protocol revision (implemented by this library). */
 const epics::pvData::int8 PVA_PROTOCOL_REVISION EPICS_DEPRECATED = 1;
 
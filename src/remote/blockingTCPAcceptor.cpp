@@ -5,11 +5,17 @@
  */
 
 #include <sstream>
+#include <fstream>
+#include <algorithm>
+
+#include <stdlib.h>
 
 #include <epicsThread.h>
+#include <epicsAtomic.h>
 #include <osiSock.h>
 
 #include <pv/epicsException.h>
+#include <pv/timer.h>
 
 #define epicsExportSharedSymbols
 #include <pv/blockingTCP.h>
@@ -20,22 +26,93 @@
 using std::ostringstream;
 using namespace epics::pvData;
 
+namespace {
+using namespace epics::pvAccess;
+
+// time allowed for a new client to complete connection validation (and authentication)
+const double VALIDATION_TIMEOUT = 5.0;
+
+/* Closes a connection which has not been validated in time.
+ * Also holds off a client which failed validation
+ * from retrying at a very high rate.
+ */
+struct ValidationTimeout : public TimerCallback
+{
+    const std::tr1::weak_ptr<detail::BlockingServerTCPTransportCodec> transport;
+
+    explicit ValidationTimeout(const detail::BlockingServerTCPTransportCodec::shared_pointer& transport)
+        :transport(transport)
+    {}
+    virtual ~ValidationTimeout() {}
+
+    virtual void callback() OVERRIDE FINAL
+    {
+        detail::BlockingServerTCPTransportCodec::shared_pointer T(transport.lock());
+        if(!T || T->isClosed() || T->isVerified())
+            return;
+
+        LOG(logLevelDebug,
+            "Connection to PVA client %s failed to be validated, closing it.",
+            T->getRemoteName().c_str());
+        T->close();
+    }
+
+    virtual void timerStopped() OVERRIDE FINAL {}
+};
+
+// acceptors of this process, which connectLoopback() may find
+epics::pvData::Mutex loopbackLock;
+std::vector<BlockingTCPAcceptor*> loopbackAcceptors;
+// source of the (fake) remote address of in-process clients.  Guarded by loopbackLock
+epicsUInt64 loopbackClients;
+
+bool loopbackMatch(const osiSockAddr& bind, const osiSockAddr& addr)
+{
+    if(bind.ia.sin_port!=addr.ia.sin_port)
+        return false;
+    else if(bind.ia.sin_addr.s_addr==addr.ia.sin_addr.s_addr)
+        return true;
+    // an acceptor bound to the wildcard address is reached through localhost
+    return bind.ia.sin_addr.s_addr==htonl(INADDR_ANY) && addr.ia.sin_addr.s_addr==htonl(INADDR_LOOPBACK);
+}
+
+// is some other socket (possibly with SO_REUSEPORT) bound to this address?
+bool portInUse(const osiSockAddr& addr)
+{
+    SOCKET probe = epicsSocketCreate(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if(probe==INVALID_SOCKET)
+        return false; // let the real bind() fail
+    bool inUse = ::bind(probe, &addr.sa, sizeof(sockaddr))<0 && SOCKERRNO==SOCK_EADDRINUSE;
+    epicsSocketDestroy(probe);
+    return inUse;
+}
+
+} // namespace
+
 namespace epics {
 namespace pvAccess {
 
 BlockingTCPAcceptor::BlockingTCPAcceptor(Context::shared_pointer const & context,
         ResponseHandler::shared_pointer const & responseHandler,
-        const osiSockAddr& addr, int receiveBufferSize) :
+        const osiSockAddr& addr, int receiveBufferSize,
+        int backlog, ReusePort reusePort) :
     _context(context),
     _responseHandler(responseHandler),
     _bindAddress(),
     _serverSocketChannel(INVALID_SOCKET),
     _receiveBufferSize(receiveBufferSize),
+    _backlog(backlog>0 ? backlog : DEFAULT_BACKLOG),
+    _reusePort(reusePort),
     _destroyed(false),
     _thread(*this, "TCP-acceptor",
             epicsThreadGetStackSize(
                 epicsThreadStackBig),
-            epicsThreadPriorityMedium)
+            epicsThreadPriorityMedium),
+    _setupThread(Thread::Config(this, &BlockingTCPAcceptor::setupThread)
+                 .prio(epicsThreadPriorityMedium)
+                 .name("TCP-setup")
+                 .stack(epicsThreadStackBig)
+                 .autostart(false))
 {
     _bindAddress = addr;
     initialize();
@@ -68,12 +145,34 @@ int BlockingTCPAcceptor::initialize() {
 
             //epicsSocketEnableAddressReuseDuringTimeWaitState(_serverSocketChannel);
 
+            if(_reusePort!=ReuseNone) {
+#ifdef SO_REUSEPORT
+                int optval = 1;
+                if(::setsockopt(_serverSocketChannel, SOL_SOCKET, SO_REUSEPORT, (char *)&optval, sizeof(optval))<0) {
+                    epicsSocketConvertErrnoToString(strBuffer, sizeof(strBuffer));
+                    LOG(logLevelError, "Error setting SO_REUSEPORT: %s.", strBuffer);
+                }
+#else
+                LOG(logLevelError, "SO_REUSEPORT not supported on this target.");
+#endif
+            }
+
+            // with SO_REUSEPORT, bind() would also succeed if another server
+            // listening with SO_REUSEPORT has this port, and steal its clients.
+            bool inUse = _reusePort==ReuseFirst && _bindAddress.ia.sin_port!=0 && portInUse(_bindAddress);
+
             // try to bind
-            int retval = ::bind(_serverSocketChannel, &_bindAddress.sa, sizeof(sockaddr));
+            int retval = inUse ? -1 : ::bind(_serverSocketChannel, &_bindAddress.sa, sizeof(sockaddr));
             if(retval<0) {
-                epicsSocketConvertErrnoToString(strBuffer, sizeof(strBuffer));
-                LOG(logLevelDebug, "Socket bind error: %s.", strBuffer);
-                if(_bindAddress.ia.sin_port!=0) {
+                if(inUse) {
+                    LOG(logLevelDebug, "Socket bind error: port %d in use.", ntohs(_bindAddress.ia.sin_port));
+                } else {
+                    epicsSocketConvertErrnoToString(strBuffer, sizeof(strBuffer));
+                    LOG(logLevelDebug, "Socket bind error: %s.", strBuffer);
+                }
+                epicsSocketDestroy(_serverSocketChannel);
+                _serverSocketChannel = INVALID_SOCKET;
+                if(_bindAddress.ia.sin_port!=0 && _reusePort!=ReuseShared) {
                     // failed to bind to specified bind address,
                     // try to get port dynamically, but only once
                     LOG(
@@ -83,7 +182,6 @@ int BlockingTCPAcceptor::initialize() {
                     _bindAddress.ia.sin_port = htons(0);
                 }
                 else {
-                    epicsSocketDestroy(_serverSocketChannel);
                     break; // exit while loop
                 }
             }
@@ -108,7 +206,7 @@ int BlockingTCPAcceptor::initialize() {
                     }
                 }
 
-                retval = ::listen(_serverSocketChannel, 4);
+                retval = ::listen(_serverSocketChannel, _backlog);
                 if(retval<0) {
                     epicsSocketConvertErrnoToString(strBuffer, sizeof(strBuffer));
                     ostringstream temp;
@@ -117,8 +215,14 @@ int BlockingTCPAcceptor::initialize() {
                     THROW_BASE_EXCEPTION(temp.str().c_str());
                 }
 
+                _setupThread.start();
                 _thread.start();
 
+                {
+                    Lock guard(loopbackLock);
+                    loopbackAcceptors.push_back(this);
+                }
+
                 // all OK, return
                 return ntohs(_bindAddress.ia.sin_port);
             } // successful bind
@@ -137,10 +241,12 @@ void BlockingTCPAcceptor::run() {
     ipAddrToDottedIP(&_bindAddress.ia, ipAddrStr, sizeof(ipAddrStr));
     LOG(logLevelDebug, "Accepting connections at %s.", ipAddrStr);
 
-    bool socketOpen = true;
     char strBuffer[64];
 
-    while(socketOpen) {
+    // Only accept() here.  Setup of new connections is done by setupThread()
+    // so that a burst of (re)connecting clients is drained from
+    // the kernel queue quickly.
+    while(true) {
 
         SOCKET sock;
         {
@@ -150,85 +256,243 @@ void BlockingTCPAcceptor::run() {
             sock = _serverSocketChannel;
         }
 
-        osiSockAddr address;
+        Accepted client;
         osiSocklen_t len = sizeof(sockaddr);
 
-        SOCKET newClient = epicsSocketAccept(sock, &address.sa, &len);
-        if(newClient!=INVALID_SOCKET) {
-            // accept succeeded
-            ipAddrToDottedIP(&address.ia, ipAddrStr, sizeof(ipAddrStr));
-            LOG(logLevelDebug, "Accepted connection from PVA client: %s.", ipAddrStr);
-
-            // enable TCP_NODELAY (disable Nagle's algorithm)
-            int optval = 1; // true
-            int retval = ::setsockopt(newClient, IPPROTO_TCP, TCP_NODELAY, (char *)&optval, sizeof(int));
-            if(retval<0) {
-                epicsSocketConvertErrnoToString(strBuffer, sizeof(strBuffer));
-                LOG(logLevelDebug, "Error setting TCP_NODELAY: %s.", strBuffer);
+#if defined(__linux__) && defined(SOCK_CLOEXEC)
+        // atomically set close-on-exec, saving the fcntl() done by epicsSocketAccept()
+        client.socket = ::accept4(sock, &client.address.sa, &len, SOCK_CLOEXEC);
+        if(client.socket<0)
+            client.socket = INVALID_SOCKET;
+#else
+        client.socket = epicsSocketAccept(sock, &client.address.sa, &len);
+#endif
+        if(client.socket==INVALID_SOCKET) {
+            int err = SOCKERRNO;
+            {
+                Lock guard(_mutex);
+                if (_destroyed)
+                    break;
             }
+            if(err==SOCK_EINTR || err==SOCK_ECONNABORTED)
+                continue;
 
-            // enable TCP_KEEPALIVE
-            retval = ::setsockopt(newClient, SOL_SOCKET, SO_KEEPALIVE, (char *)&optval, sizeof(int));
-            if(retval<0) {
-                epicsSocketConvertErrnoToString(strBuffer, sizeof(strBuffer));
-                LOG(logLevelDebug, "Error setting SO_KEEPALIVE: %s.", strBuffer);
-            }
+            // eg. out of file descriptors.  Keep trying.
+            epicsSocketConvertErrnoToString(strBuffer, sizeof(strBuffer));
+            LOG(logLevelError, "Error accepting PVA client connection: %s.", strBuffer);
+            epicsThreadSleep(0.1);
+            continue;
+        }
 
-            // do NOT tune socket buffer sizes, this will disable auto-tunning
+        epics::atomic::increment(_stats.accepted);
 
-            // get TCP send buffer size
-            osiSocklen_t intLen = sizeof(int);
-            int _socketSendBufferSize;
-            retval = getsockopt(newClient, SOL_SOCKET, SO_SNDBUF, (char *)&_socketSendBufferSize, &intLen);
-            if(retval<0) {
-                epicsSocketConvertErrnoToString(strBuffer, sizeof(strBuffer));
-                LOG(logLevelDebug, "Error getting SO_SNDBUF: %s.", strBuffer);
+#if defined(__linux__) && defined(TCP_INFO)
+        {
+            // for a listening socket, tcpi_unacked is the current length of the
+            // accept() queue, and tcpi_sacked its maximum length.
+            struct tcp_info info;
+            osiSocklen_t infoLen = sizeof(info);
+            if(::getsockopt(sock, IPPROTO_TCP, TCP_INFO, &info, &infoLen)==0) {
+                // include the connection just accepted
+                size_t depth = size_t(info.tcpi_unacked)+1u;
+                if(depth > epics::atomic::get(_stats.acceptQueuePeak))
+                    epics::atomic::set(_stats.acceptQueuePeak, depth);
+                if(depth > info.tcpi_sacked)
+                    epics::atomic::increment(_stats.acceptQueueFull);
             }
+        }
+#endif
 
-            /**
-             * Create transport, it registers itself to the registry.
-             */
-            detail::BlockingServerTCPTransportCodec::shared_pointer transport =
-                detail::BlockingServerTCPTransportCodec::create(
-                    _context,
-                    newClient,
-                    _responseHandler,
-                    _socketSendBufferSize,
-                    _receiveBufferSize);
-
-            // validate connection
-            if(!validateConnection(transport, ipAddrStr)) {
-                // TODO
-                // wait for negative response to be sent back and
-                // hold off the client for retrying at very high rate
-                epicsThreadSleep(1.0);
-
-                transport->close();
-                LOG(
-                    logLevelDebug,
-                    "Connection to PVA client %s failed to be validated, closing it.",
-                    ipAddrStr);
-                continue;
+        {
+            Lock guard(_mutex);
+            if (_destroyed) {
+                epicsSocketDestroy(client.socket);
+                break;
             }
+            _setupQueue.push_back(client);
+            if(_setupQueue.size() > _stats.setupQueuePeak)
+                _stats.setupQueuePeak = _setupQueue.size();
+        }
+        _setupWakeup.signal();
+    } // while
+}
 
-            LOG(logLevelDebug, "Serving to PVA client: %s.", ipAddrStr);
+void BlockingTCPAcceptor::setupThread()
+{
+    while(true) {
+        Accepted client;
+        bool have;
+        {
+            Lock guard(_mutex);
+            if (_destroyed)
+                break;
+            have = !_setupQueue.empty();
+            if(have) {
+                client = _setupQueue.front();
+                _setupQueue.pop_front();
+            }
+        }
 
-        }// accept succeeded
-        else
-            socketOpen = false;
-    } // while
+        if(!have) {
+            _setupWakeup.wait();
+            continue;
+        }
+
+        try {
+            setupConnection(client);
+        } catch(std::exception& e) {
+            LOG(logLevelError, "Unable to setup connection from PVA client: %s", e.what());
+        }
+    }
 }
 
-bool BlockingTCPAcceptor::validateConnection(Transport::shared_pointer const & transport, const char* address) {
-    try {
-        return transport->verify(5000);
-    } catch(...) {
-        LOG(logLevelDebug, "Validation of %s failed.", address);
-        return false;
+void BlockingTCPAcceptor::setupConnection(const Accepted& client)
+{
+    char strBuffer[64];
+    char ipAddrStr[24];
+    ipAddrToDottedIP(&client.address.ia, ipAddrStr, sizeof(ipAddrStr));
+    LOG(logLevelDebug, "Accepted connection from PVA client: %s.", ipAddrStr);
+
+    // enable TCP_NODELAY (disable Nagle's algorithm)
+    int optval = 1; // true
+    int retval = ::setsockopt(client.socket, IPPROTO_TCP, TCP_NODELAY, (char *)&optval, sizeof(int));
+    if(retval<0) {
+        epicsSocketConvertErrnoToString(strBuffer, sizeof(strBuffer));
+        LOG(logLevelDebug, "Error setting TCP_NODELAY: %s.", strBuffer);
+    }
+
+    // enable TCP_KEEPALIVE
+    retval = ::setsockopt(client.socket, SOL_SOCKET, SO_KEEPALIVE, (char *)&optval, sizeof(int));
+    if(retval<0) {
+        epicsSocketConvertErrnoToString(strBuffer, sizeof(strBuffer));
+        LOG(logLevelDebug, "Error setting SO_KEEPALIVE: %s.", strBuffer);
+    }
+
+    // do NOT tune socket buffer sizes, this will disable auto-tunning
+
+    // get TCP send buffer size
+    osiSocklen_t intLen = sizeof(int);
+    int _socketSendBufferSize;
+    retval = getsockopt(client.socket, SOL_SOCKET, SO_SNDBUF, (char *)&_socketSendBufferSize, &intLen);
+    if(retval<0) {
+        epicsSocketConvertErrnoToString(strBuffer, sizeof(strBuffer));
+        LOG(logLevelDebug, "Error getting SO_SNDBUF: %s.", strBuffer);
+    }
+
+    /**
+     * Create transport, it registers itself to the registry.
+     */
+    detail::BlockingServerTCPTransportCodec::shared_pointer transport =
+        detail::BlockingServerTCPTransportCodec::create(
+            _context,
+            client.socket,
+            _responseHandler,
+            _socketSendBufferSize,
+            _receiveBufferSize);
+
+    // validate connection.  Validation and authentication complete
+    // on the transport's own threads.  Don't wait here.
+    transport->startVerify();
+
+    TimerCallback::shared_pointer timeout(new ValidationTimeout(transport));
+    _context->getTimer()->scheduleAfterDelay(timeout, VALIDATION_TIMEOUT);
+
+    LOG(logLevelDebug, "Serving to PVA client: %s.", ipAddrStr);
+}
+
+bool BlockingTCPAcceptor::connectLoopback(const osiSockAddr& address, detail::CodecEndpoint& clientEnd)
+{
+    Lock guard(loopbackLock);
+
+    for(size_t i=0; i<loopbackAcceptors.size(); i++) {
+        BlockingTCPAcceptor *acceptor = loopbackAcceptors[i];
+        if(!loopbackMatch(acceptor->_bindAddress, address))
+            continue;
+
+        // 0.0.0.0/8 is never the address of a TCP peer.  Its 24 host bits, with the port,
+        // give 2**40 distinct in-process clients before an address is reused.
+        const epicsUInt64 id = ++loopbackClients;
+        osiSockAddr clientAddress;
+        memset(&clientAddress, 0, sizeof(clientAddress));
+        clientAddress.ia.sin_family = AF_INET;
+        clientAddress.ia.sin_addr.s_addr = htonl(epicsUInt32(id>>16) & 0x00ffffffu);
+        clientAddress.ia.sin_port = htons(epicsUInt16(id));
+
+        detail::CodecEndpoint serverEnd(INVALID_SOCKET);
+        detail::CodecEndpoint::loopbackPair(clientEnd, address,
+                                            serverEnd, clientAddress,
+                                            LOOPBACK_PIPE_SIZE);
+        acceptor->setupLoopback(serverEnd);
+        epics::atomic::increment(acceptor->_stats.accepted);
+        return true;
     }
+    return false;
+}
+
+void BlockingTCPAcceptor::setupLoopback(const detail::CodecEndpoint& serverEnd)
+{
+    LOG(logLevelDebug, "Accepted in-process connection from PVA client.");
+
+    detail::BlockingServerTCPTransportCodec::shared_pointer transport =
+        detail::BlockingServerTCPTransportCodec::create(
+            _context,
+            serverEnd,
+            _responseHandler,
+            LOOPBACK_PIPE_SIZE,
+            _receiveBufferSize);
+
+    transport->startVerify();
+
+    TimerCallback::shared_pointer timeout(new ValidationTimeout(transport));
+    _context->getTimer()->scheduleAfterDelay(timeout, VALIDATION_TIMEOUT);
+}
+
+void BlockingTCPAcceptor::getStats(Stats& stats) const
+{
+    stats.accepted = epics::atomic::get(_stats.accepted);
+    stats.acceptQueuePeak = epics::atomic::get(_stats.acceptQueuePeak);
+    stats.acceptQueueFull = epics::atomic::get(_stats.acceptQueueFull);
+    Lock guard(_mutex);
+    stats.setupQueuePeak = _stats.setupQueuePeak;
+}
+
+bool BlockingTCPAcceptor::getListenOverflows(size_t& overflows, size_t& drops)
+{
+#ifdef __linux__
+    // pairs of lines: "TcpExt: <name> ..." followed by "TcpExt: <value> ..."
+    std::ifstream strm("/proc/net/netstat");
+    std::string names, values;
+    while(std::getline(strm, names) && std::getline(strm, values)) {
+        if(names.compare(0, 7, "TcpExt:")!=0)
+            continue;
+
+        std::istringstream nstrm(names), vstrm(values);
+        std::string name, value;
+        bool foundOverflows = false, foundDrops = false;
+        while(nstrm>>name && vstrm>>value) {
+            if(name=="ListenOverflows") {
+                overflows = strtoul(value.c_str(), 0, 10);
+                foundOverflows = true;
+            } else if(name=="ListenDrops") {
+                drops = strtoul(value.c_str(), 0, 10);
+                foundDrops = true;
+            }
+        }
+        return foundOverflows && foundDrops;
+    }
+#endif
+    return false;
 }
 
 void BlockingTCPAcceptor::destroy() {
+    {
+        // waits for a connectLoopback() in progress
+        Lock guard(loopbackLock);
+        std::vector<BlockingTCPAcceptor*>::iterator it(std::find(loopbackAcceptors.begin(), loopbackAcceptors.end(), this));
+        if(it!=loopbackAcceptors.end())
+            loopbackAcceptors.erase(it);
+    }
+
     SOCKET sock;
     {
         Lock guard(_mutex);
@@ -258,7 +522,19 @@ void BlockingTCPAcceptor::destroy() {
             _thread.exitWait();
             break;
         }
+
+        _setupWakeup.signal();
+        _setupThread.exitWait();
+    }
+
+    // close connections never setup
+    std::deque<Accepted> pending;
+    {
+        Lock guard(_mutex);
+        pending.swap(_setupQueue);
     }
+    for(size_t i=0; i<pending.size(); i++)
+        epicsSocketDestroy(pending[i].socket);
 }
 
 }
@@ -5,163 +5,573 @@
  */
 
 #include <sstream>
+#include <stdexcept>
+#include <string.h>
+#include <algorithm>
 #include <sys/types.h>
 
+#if !defined(_WIN32) && !defined(vxWorks) && !defined(__rtems__)
+#  include <poll.h>
+#  define USE_POLL
+#endif
+
 #include <osiSock.h>
 #include <epicsThread.h>
+#include <epicsTime.h>
 
 #define epicsExportSharedSymbols
 #include <pv/blockingTCP.h>
 #include <pv/remote.h>
 #include <pv/logger.h>
 #include <pv/codec.h>
+#include <pv/clientContextImpl.h>
 
 using namespace epics::pvData;
 
 namespace epics {
 namespace pvAccess {
 
+struct BlockingTCPConnector::Pending {
+    osiSockAddr address;
+    int16 priority;
+    int8 revision;
+    ResponseHandler::shared_pointer responseHandler;
+    char name[24];
+
+    // until connect() completes
+    SOCKET socket;
+    // after connect() completes, until validated
+    Transport::shared_pointer transport;
+    // client which was passed to BlockingClientTCPTransportCodec::create()
+    pvAccessID acquiredID;
+
+    epicsTimeStamp deadline;
+
+    typedef std::vector<std::pair<pvAccessID, std::tr1::weak_ptr<ClientChannelImpl> > > clients_t;
+    clients_t clients;
+
+    Pending() :priority(0), revision(0), socket(INVALID_SOCKET), acquiredID(0) {}
+    ~Pending() {
+        if(socket!=INVALID_SOCKET)
+            epicsSocketDestroy(socket);
+    }
+};
+
+// A UDP socket, bound to the loopback interface, which sends to itself.
+// The worker waits for it to become readable along with connecting sockets.
+struct BlockingTCPConnector::Wakeup : public detail::BlockingClientTCPTransportCodec::VerifyListener {
+    SOCKET socket;
+    osiSockAddr self;
+
+    Wakeup() :socket(epicsSocketCreate(AF_INET, SOCK_DGRAM, IPPROTO_UDP))
+    {
+        if(socket==INVALID_SOCKET)
+            throw std::runtime_error("Unable to create connector wakeup socket");
+
+        memset(&self, 0, sizeof(self));
+        self.ia.sin_family = AF_INET;
+        self.ia.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        self.ia.sin_port = 0;
+        osiSocklen_t slen = sizeof(self.ia);
+        osiSockIoctl_t nonblocking = 1;
+
+        if(::bind(socket, &self.sa, sizeof(self.ia))!=0
+                || ::getsockname(socket, &self.sa, &slen)!=0
+                || socket_ioctl(socket, FIONBIO, &nonblocking)!=0)
+        {
+            char strBuffer[64];
+            epicsSocketConvertErrnoToString(strBuffer, sizeof(strBuffer));
+            epicsSocketDestroy(socket);
+            throw std::runtime_error(std::string("Unable to setup connector wakeup socket: ")+strBuffer);
+        }
+    }
+    virtual ~Wakeup() {
+        epicsSocketDestroy(socket);
+    }
+
+    void signal() {
+        char dummy = 0;
+        // failure with a full buffer is ok, a wakeup is already pending
+        (void)::sendto(socket, &dummy, 1, 0, &self.sa, sizeof(self.ia));
+    }
+    void drain() {
+        char buf[16];
+        while(::recv(socket, buf, sizeof(buf), 0)>0) {}
+    }
+
+    virtual void verifyDone() OVERRIDE FINAL { signal(); }
+};
+
+#ifndef USE_POLL
+namespace {
+// Can select() wait on this socket, in addition to the wakeup socket and
+// nconnecting sockets already waiting.
+bool selectable(SOCKET socket, size_t nconnecting)
+{
+#  ifdef _WIN32
+    // fd_set is a list of up to FD_SETSIZE sockets of any value
+    (void)socket;
+    return 1u+nconnecting < FD_SETSIZE;
+#  else
+    // fd_set is a bit mask indexed by descriptor
+    (void)nconnecting;
+    return socket < FD_SETSIZE;
+#  endif
+}
+} // namespace
+#endif
+
 BlockingTCPConnector::BlockingTCPConnector(
     Context::shared_pointer const & context,
     int receiveBufferSize,
-    float heartbeatInterval) :
+    float heartbeatInterval,
+    bool loopback) :
     _context(context),
     _receiveBufferSize(receiveBufferSize),
-    _heartbeatInterval(heartbeatInterval)
+    _heartbeatInterval(heartbeatInterval),
+    _loopback(loopback),
+    _closed(false),
+    _wakeup(new Wakeup),
+    _thread(*this, "TCP-connector",
+            epicsThreadGetStackSize(epicsThreadStackSmall),
+            epicsThreadPriorityMedium)
+{
+    _thread.start();
+}
+
+BlockingTCPConnector::~BlockingTCPConnector()
+{
+    close();
+}
+
+void BlockingTCPConnector::close()
 {
+    pending_t pending;
+    {
+        Lock guard(_mutex);
+        if(_closed)
+            return;
+        _closed = true;
+        pending.swap(_pending);
+    }
+    _wakeup->signal();
+    _thread.exitWait();
+
+    for(size_t i=0; i<pending.size(); i++) {
+        if(pending[i]->transport)
+            pending[i]->transport->close();
+    }
 }
 
-SOCKET BlockingTCPConnector::tryConnect(osiSockAddr& address, int tries) {
+SOCKET BlockingTCPConnector::startConnect(const osiSockAddr& address) {
 
-    char strBuffer[24];
-    ipAddrToDottedIP(&address.ia, strBuffer, sizeof(strBuffer));
+    char strBuffer[64];
 
-    for(int tryCount = 0; tryCount<tries; tryCount++) {
+    SOCKET socket = epicsSocketCreate(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (socket == INVALID_SOCKET)
+    {
+        epicsSocketConvertErrnoToString(strBuffer, sizeof(strBuffer));
+        LOG(logLevelError, "Socket create error: %s", strBuffer);
+        return INVALID_SOCKET;
+    }
 
-        LOG(logLevelDebug,
-            "Opening socket to PVA server %s, attempt %d.",
-            strBuffer, tryCount+1);
+    osiSockIoctl_t nonblocking = 1;
+    if(socket_ioctl(socket, FIONBIO, &nonblocking)) {
+        epicsSocketConvertErrnoToString(strBuffer, sizeof(strBuffer));
+        LOG(logLevelError, "Unable to set non-blocking: %s", strBuffer);
+        epicsSocketDestroy(socket);
+        return INVALID_SOCKET;
+    }
 
-        SOCKET socket = epicsSocketCreate(AF_INET, SOCK_STREAM, IPPROTO_TCP);
-        if (socket == INVALID_SOCKET)
-        {
+    if(::connect(socket, &address.sa, sizeof(sockaddr))!=0) {
+        int err = SOCKERRNO;
+        if(err!=SOCK_EINPROGRESS && err!=SOCK_EWOULDBLOCK && err!=SOCK_EINTR) {
             epicsSocketConvertErrnoToString(strBuffer, sizeof(strBuffer));
-            std::ostringstream temp;
-            temp<<"Socket create error: "<<strBuffer;
-            THROW_EXCEPTION2(std::runtime_error, temp.str());
+            char saddr[32];
+            sockAddrToDottedIP(&address.sa, saddr, sizeof(saddr));
+            LOG(logLevelDebug, "error connecting to %s : %s", saddr, strBuffer);
+            epicsSocketDestroy(socket);
+            return INVALID_SOCKET;
         }
-        else {
-            // TODO: use non-blocking connect() to have controllable timeout
-            if(::connect(socket, &address.sa, sizeof(sockaddr))==0) {
-                return socket;
+    }
+    // completion (even immediate) is found by the worker
+
+    return socket;
+}
+
+bool BlockingTCPConnector::startLoopback(Pending& pend,
+                                         const std::tr1::shared_ptr<ClientChannelImpl>& client,
+                                         const Context::shared_pointer& context)
+{
+    detail::CodecEndpoint clientEnd(INVALID_SOCKET);
+    if(!BlockingTCPAcceptor::connectLoopback(pend.address, clientEnd))
+        return false;
+
+    try {
+        // no connect() to wait for, so go straight to validation
+        detail::BlockingClientTCPTransportCodec::shared_pointer transport(detail::BlockingClientTCPTransportCodec::create(
+                    context, clientEnd, pend.responseHandler, _receiveBufferSize,
+                    int(BlockingTCPAcceptor::LOOPBACK_PIPE_SIZE),
+                    client, pend.revision, _heartbeatInterval, pend.priority));
+        transport->setVerifyListener(_wakeup);
+        pend.transport = transport;
+    } catch(std::exception& e) {
+        LOG(logLevelDebug, "Error creating in-process transport to %s : %s", pend.name, e.what());
+        return false;
+    }
+    pend.acquiredID = client->getID();
+    pend.clients.push_back(std::make_pair(client->getID(), std::tr1::weak_ptr<ClientChannelImpl>(client)));
+
+    epicsTimeGetCurrent(&pend.deadline);
+    epicsTimeAddSeconds(&pend.deadline, VERIFY_TIMEOUT);
+    return true;
+}
+
+void BlockingTCPConnector::connect(std::tr1::shared_ptr<ClientChannelImpl> const & client,
+        ResponseHandler::shared_pointer const & responseHandler, const osiSockAddr& address,
+        int8 transportRevision, int16 priority) {
+
+    Context::shared_pointer context = _context.lock();
+    Transport::shared_pointer transport;
+    {
+        Lock guard(_mutex);
+
+        if(!_closed && context) {
+            // join a connection already in progress.
+            // checked before the registry, which already holds transports being validated.
+            for(size_t i=0; i<_pending.size(); i++) {
+                Pending& pend = *_pending[i];
+                if(pend.priority==priority && sockAddrAreIdentical(&pend.address, &address)) {
+                    pend.clients.push_back(std::make_pair(client->getID(), std::tr1::weak_ptr<ClientChannelImpl>(client)));
+                    return;
+                }
             }
-            else {
-                epicsSocketConvertErrnoToString(strBuffer, sizeof(strBuffer));
-                char saddr[32];
-                sockAddrToDottedIP(&address.sa, saddr, sizeof(saddr));
-                epicsSocketDestroy (socket);
-                std::ostringstream temp;
-                temp<<"error connecting to "<<saddr<<" : "<<strBuffer;
-                throw std::runtime_error(temp.str());
+
+            transport = context->getTransportRegistry()->get(address, priority);
+            if(transport && transport->acquire(client)) {
+                LOG(logLevelDebug, "Reusing existing connection to PVA server: %s.",
+                    transport->getRemoteName().c_str());
+
+            } else {
+                transport.reset();
+
+                std::tr1::shared_ptr<Pending> pend(new Pending);
+                pend->address = address;
+                pend->priority = priority;
+                pend->revision = transportRevision;
+                pend->responseHandler = responseHandler;
+                ipAddrToDottedIP(&address.ia, pend->name, sizeof(pend->name));
+
+                if(_loopback && startLoopback(*pend, client, context)) {
+                    LOG(logLevelDebug, "Connecting in-process to PVA server: %s.", pend->name);
+
+                    _pending.push_back(pend);
+                    guard.unlock();
+                    _wakeup->signal();
+                    return;
+                }
+
+                LOG(logLevelDebug, "Connecting to PVA server: %s.", pend->name);
+
+                pend->socket = startConnect(address);
+#ifndef USE_POLL
+                size_t nconnecting = 0u;
+                for(size_t i=0; i<_pending.size(); i++) {
+                    if(_pending[i]->socket!=INVALID_SOCKET)
+                        nconnecting++;
+                }
+                if(pend->socket!=INVALID_SOCKET && !selectable(pend->socket, nconnecting)) {
+                    LOG(logLevelWarn, "Too many connections in progress to wait for connection to %s", pend->name);
+                    epicsSocketDestroy(pend->socket);
+                    pend->socket = INVALID_SOCKET;
+                }
+#endif
+                if(pend->socket!=INVALID_SOCKET) {
+                    epicsTimeGetCurrent(&pend->deadline);
+                    epicsTimeAddSeconds(&pend->deadline, _heartbeatInterval);
+                    pend->clients.push_back(std::make_pair(client->getID(), std::tr1::weak_ptr<ClientChannelImpl>(client)));
+
+                    _pending.push_back(pend);
+                    guard.unlock();
+                    _wakeup->signal();
+                    return;
+                }
             }
         }
     }
-    return INVALID_SOCKET;
+
+    if(transport)
+        client->transportConnected(transport);
+    else
+        client->createChannelFailed();
 }
 
-Transport::shared_pointer BlockingTCPConnector::connect(std::tr1::shared_ptr<ClientChannelImpl> const & client,
-        ResponseHandler::shared_pointer const & responseHandler, osiSockAddr& address,
-        int8 transportRevision, int16 priority) {
+void BlockingTCPConnector::run()
+{
+    pending_t work;
+    // indices in work of sockets waiting for connect()
+    std::vector<size_t> connecting;
+    std::vector<bool> ready;
+#ifdef USE_POLL
+    std::vector<pollfd> fds;
+#endif
 
-    SOCKET socket = INVALID_SOCKET;
+    while(true) {
+        {
+            Lock guard(_mutex);
+            if(_closed)
+                break;
+            work = _pending;
+        }
 
-    char ipAddrStr[24];
-    ipAddrToDottedIP(&address.ia, ipAddrStr, sizeof(ipAddrStr));
+        epicsTimeStamp now;
+        epicsTimeGetCurrent(&now);
 
-    Context::shared_pointer context = _context.lock();
+        // complete validations and timeouts, and find the nearest remaining deadline.
+        // timeout < 0 waits until signaled.
+        double timeout = -1.0;
+        connecting.clear();
 
-    TransportRegistry::Reservation rsvp(context->getTransportRegistry(),
-                                        address, priority);
-    // we are now blocking any connect() to this destination (address and prio)
-    // concurrent connect() to other destination is allowed.
-    // This prevents us from opening duplicate connections.
+        for(size_t i=0; i<work.size(); i++) {
+            const std::tr1::shared_ptr<Pending>& pend = work[i];
 
-    Transport::shared_pointer transport = context->getTransportRegistry()->get(address, priority);
-    if(transport.get()) {
-        LOG(logLevelDebug,
-            "Reusing existing connection to PVA server: %s.",
-            ipAddrStr);
-        if (transport->acquire(client))
-            return transport;
-    }
+            if(pend->socket!=INVALID_SOCKET) {
+                if(epicsTimeGreaterThan(&now, &pend->deadline)) {
+                    complete(pend, false, "connect() timeout");
+                    continue;
+                }
+                connecting.push_back(i);
 
-    try {
-        LOG(logLevelDebug, "Connecting to PVA server: %s.", ipAddrStr);
+            } else if(pend->transport) {
+                // only the connector calls verify() on a new transport,
+                // and only until the first success
+                if(pend->transport->verify(0)) {
+                    LOG(logLevelDebug, "Connected to PVA server: %s.", pend->name);
+                    complete(pend, true, 0);
+                    continue;
 
-        socket = tryConnect(address, 3);
+                } else if(pend->transport->isClosed() || epicsTimeGreaterThan(&now, &pend->deadline)) {
+                    LOG(logLevelDebug,
+                        "Connection to PVA server %s failed to be validated, closing it.",
+                        pend->name);
+                    complete(pend, false, "validation failed");
+                    continue;
+                }
 
-        LOG(logLevelDebug, "Socket connected to PVA server: %s.", ipAddrStr);
+            } else {
+                continue;
+            }
 
-        // enable TCP_NODELAY (disable Nagle's algorithm)
-        int optval = 1; // true
-        int retval = ::setsockopt(socket, IPPROTO_TCP, TCP_NODELAY,
-                                  (char *)&optval, sizeof(int));
-        if(retval<0) {
-            char errStr[64];
-            epicsSocketConvertErrnoToString(errStr, sizeof(errStr));
-            LOG(logLevelWarn, "Error setting TCP_NODELAY: %s.", errStr);
+            double remaining = epicsTimeDiffInSeconds(&pend->deadline, &now);
+            if(remaining<0.0)
+                remaining = 0.0;
+            if(timeout<0.0 || remaining<timeout)
+                timeout = remaining;
         }
 
-        // enable TCP_KEEPALIVE
-        retval = ::setsockopt(socket, SOL_SOCKET, SO_KEEPALIVE,
-                              (char *)&optval, sizeof(int));
-        if(retval<0)
-        {
-            char errStr[64];
-            epicsSocketConvertErrnoToString(errStr, sizeof(errStr));
-            LOG(logLevelWarn, "Error setting SO_KEEPALIVE: %s.", errStr);
+        // wait for a signal, a deadline, or for any connect() in progress to complete
+        ready.assign(connecting.size(), false);
+        bool signaled = false;
+#ifdef USE_POLL
+        fds.resize(1u+connecting.size());
+        fds[0].fd = _wakeup->socket;
+        fds[0].events = POLLIN;
+        fds[0].revents = 0;
+        for(size_t n=0; n<connecting.size(); n++) {
+            fds[1u+n].fd = work[connecting[n]]->socket;
+            fds[1u+n].events = POLLOUT;
+            fds[1u+n].revents = 0;
+        }
+        // round up so that a deadline has passed on wakeup
+        int timeoutMs = timeout<0.0 ? -1 : int(timeout*1000.0)+1;
+        if(::poll(&fds[0], fds.size(), timeoutMs)>0) {
+            signaled = fds[0].revents!=0;
+            for(size_t n=0; n<connecting.size(); n++)
+                ready[n] = fds[1u+n].revents!=0;
         }
+#else
+        // connect() only admits sockets which fit in an fd_set
+        fd_set rfds, wfds, efds;
+        FD_ZERO(&rfds);
+        FD_ZERO(&wfds);
+        FD_ZERO(&efds);
+        FD_SET(_wakeup->socket, &rfds);
+        SOCKET maxfd = _wakeup->socket;
+        for(size_t n=0; n<connecting.size(); n++) {
+            SOCKET sock = work[connecting[n]]->socket;
+            FD_SET(sock, &wfds);
+            FD_SET(sock, &efds);
+            maxfd = std::max(maxfd, sock);
+        }
+        timeval timo;
+        if(timeout>=0.0) {
+            timo.tv_sec = long(timeout);
+            timo.tv_usec = long((timeout-timo.tv_sec)*1e6)+1;
+        }
+        if(::select(int(maxfd+1), &rfds, &wfds, &efds, timeout<0.0 ? 0 : &timo)>0) {
+            signaled = FD_ISSET(_wakeup->socket, &rfds);
+            for(size_t n=0; n<connecting.size(); n++) {
+                SOCKET sock = work[connecting[n]]->socket;
+                ready[n] = FD_ISSET(sock, &wfds) || FD_ISSET(sock, &efds);
+            }
+        }
+#endif
+        if(signaled)
+            _wakeup->drain();
 
-        // TODO tune buffer sizes?! Win32 defaults are 8k, which is OK
+        for(size_t n=0; n<connecting.size(); n++) {
+            if(!ready[n])
+                continue;
+            const std::tr1::shared_ptr<Pending>& pend = work[connecting[n]];
 
-        // create transport
-        // TODO introduce factory
-        // get TCP send buffer size
-        osiSocklen_t intLen = sizeof(int);
-        int _socketSendBufferSize;
-        retval = getsockopt(socket, SOL_SOCKET, SO_SNDBUF, (char *)&_socketSendBufferSize, &intLen);
-        if(retval<0) {
-            char strBuffer[64];
-            epicsSocketConvertErrnoToString(strBuffer, sizeof(strBuffer));
-            LOG(logLevelDebug, "Error getting SO_SNDBUF: %s.", strBuffer);
+            int err = 0;
+            osiSocklen_t len = sizeof(err);
+            if(::getsockopt(pend->socket, SOL_SOCKET, SO_ERROR, (char*)&err, &len)!=0)
+                err = SOCKERRNO;
+            if(err) {
+                char strBuffer[64];
+                epicsSocketConvertErrorToString(strBuffer, sizeof(strBuffer), err);
+                LOG(logLevelDebug, "error connecting to %s : %s", pend->name, strBuffer);
+                complete(pend, false, "connect() error");
+            } else {
+                connected(pend);
+            }
         }
 
+        work.clear();
+    }
+}
+
+void BlockingTCPConnector::connected(const std::tr1::shared_ptr<Pending>& pend)
+{
+    LOG(logLevelDebug, "Socket connected to PVA server: %s.", pend->name);
+
+    SOCKET socket = pend->socket;
+
+    // transport worker threads use blocking I/O
+    osiSockIoctl_t nonblocking = 0;
+    if(socket_ioctl(socket, FIONBIO, &nonblocking)) {
+        complete(pend, false, "unable to clear non-blocking");
+        return;
+    }
+
+    // enable TCP_NODELAY (disable Nagle's algorithm)
+    int optval = 1; // true
+    int retval = ::setsockopt(socket, IPPROTO_TCP, TCP_NODELAY,
+                              (char *)&optval, sizeof(int));
+    if(retval<0) {
+        char errStr[64];
+        epicsSocketConvertErrnoToString(errStr, sizeof(errStr));
+        LOG(logLevelWarn, "Error setting TCP_NODELAY: %s.", errStr);
+    }
+
+    // enable TCP_KEEPALIVE
+    retval = ::setsockopt(socket, SOL_SOCKET, SO_KEEPALIVE,
+                          (char *)&optval, sizeof(int));
+    if(retval<0)
+    {
+        char errStr[64];
+        epicsSocketConvertErrnoToString(errStr, sizeof(errStr));
+        LOG(logLevelWarn, "Error setting SO_KEEPALIVE: %s.", errStr);
+    }
+
+    // TODO tune buffer sizes?! Win32 defaults are 8k, which is OK
+
+    // create transport
+    // TODO introduce factory
+    // get TCP send buffer size
+    osiSocklen_t intLen = sizeof(int);
+    int _socketSendBufferSize;
+    retval = getsockopt(socket, SOL_SOCKET, SO_SNDBUF, (char *)&_socketSendBufferSize, &intLen);
+    if(retval<0) {
+        char strBuffer[64];
+        epicsSocketConvertErrnoToString(strBuffer, sizeof(strBuffer));
+        LOG(logLevelDebug, "Error getting SO_SNDBUF: %s.", strBuffer);
+    }
+
+    // a transport must be created with one owner
+    Context::shared_pointer context(_context.lock());
+    std::tr1::shared_ptr<ClientChannelImpl> client;
+    {
+        Lock guard(_mutex);
+        for(size_t i=0; i<pend->clients.size() && !client; i++) {
+            client = pend->clients[i].second.lock();
+            if(client)
+                pend->acquiredID = pend->clients[i].first;
+        }
+    }
+    if(!context || !client) {
+        complete(pend, false, "no clients remain");
+        return;
+    }
+
+    try {
         // create() also adds to context connection pool _context->getTransportRegistry()
-        transport = detail::BlockingClientTCPTransportCodec::create(
-                    context, socket, responseHandler, _receiveBufferSize, _socketSendBufferSize,
-                    client, transportRevision, _heartbeatInterval, priority);
-
-        // verify
-        if(!transport->verify(5000)) {
-            LOG(
-                        logLevelDebug,
-                        "Connection to PVA server %s failed to be validated, closing it.",
-                        ipAddrStr);
+        detail::BlockingClientTCPTransportCodec::shared_pointer transport(detail::BlockingClientTCPTransportCodec::create(
+                    context, socket, pend->responseHandler, _receiveBufferSize, _socketSendBufferSize,
+                    client, pend->revision, _heartbeatInterval, pend->priority));
+        // transport now owns the socket
+        pend->socket = INVALID_SOCKET;
+        // completion is seen before the worker next waits
+        transport->setVerifyListener(_wakeup);
+        pend->transport = transport;
+    } catch(std::exception& e) {
+        LOG(logLevelDebug, "Error creating transport to %s : %s", pend->name, e.what());
+        complete(pend, false, "transport creation failed");
+        return;
+    }
 
-            std::ostringstream temp;
-            temp<<"Failed to verify TCP connection to '"<<ipAddrStr<<"'.";
-            THROW_BASE_EXCEPTION(temp.str().c_str());
+    epicsTimeGetCurrent(&pend->deadline);
+    epicsTimeAddSeconds(&pend->deadline, VERIFY_TIMEOUT);
+}
+
+void BlockingTCPConnector::complete(const std::tr1::shared_ptr<Pending>& pend, bool success, const char *reason)
+{
+    Pending::clients_t clients;
+    {
+        Lock guard(_mutex);
+        pending_t::iterator it(std::find(_pending.begin(), _pending.end(), pend));
+        if(it!=_pending.end())
+            _pending.erase(it);
+        // clients parked after this point will find the transport in the registry
+        clients.swap(pend->clients);
+    }
+
+    if(!success) {
+        LOG(logLevelDebug, "Failed to connect to PVA server %s : %s", pend->name, reason);
+
+        if(pend->transport)
+            pend->transport->close();
+        if(pend->socket!=INVALID_SOCKET) {
+            epicsSocketDestroy(pend->socket);
+            pend->socket = INVALID_SOCKET;
+        }
+
+        for(size_t i=0; i<clients.size(); i++) {
+            std::tr1::shared_ptr<ClientChannelImpl> client(clients[i].second.lock());
+            if(client)
+                client->createChannelFailed();
         }
+        return;
+    }
 
-        LOG(logLevelDebug, "Connected to PVA server: %s.", ipAddrStr);
+    Transport::shared_pointer transport;
+    transport.swap(pend->transport);
 
-        return transport;
-    } catch(std::exception&) {
-        if(transport.get())
-            transport->close();
-        else if(socket!=INVALID_SOCKET)
-            epicsSocketDestroy(socket);
-        throw;
+    for(size_t i=0; i<clients.size(); i++) {
+        std::tr1::shared_ptr<ClientChannelImpl> client(clients[i].second.lock());
+        const bool acquired = clients[i].first==pend->acquiredID;
+
+        if(!client) {
+            if(acquired)
+                transport->release(clients[i].first);
+
+        } else if(acquired || transport->acquire(client)) {
+            client->transportConnected(transport);
+
+        } else {
+            client->createChannelFailed();
+        }
     }
 }
 
@@ -17,6 +17,7 @@
 #include <epicsThread.h>
 #include <osiSock.h>
 #include <epicsAtomic.h>
+#include <epicsString.h>
 
 #include <pv/lock.h>
 #include <pv/byteBuffer.h>
@@ -47,6 +48,16 @@ inline int sendto(int s, const char *buf, size_t len, int flags, const struct so
 // reserve some space for CMD_ORIGIN_TAG message
 #define RECEIVE_BUFFER_PRE_RESERVE (PVA_MESSAGE_HEADER_SIZE + 16)
 
+// batch socket I/O with recvmmsg()/sendmmsg() where available (Linux)
+#if defined(__linux__) && defined(MSG_WAITFORONE)
+#  define USE_MMSG
+#endif
+
+// number of datagrams received by one recvmmsg() call
+#define RECEIVE_BATCH_SIZE 8
+// max number of datagrams sent by one sendmmsg() call
+#define SEND_BATCH_SIZE 16
+
 size_t BlockingUDPTransport::num_instances;
 
 BlockingUDPTransport::BlockingUDPTransport(bool serverFlag,
@@ -62,7 +73,10 @@ BlockingUDPTransport::BlockingUDPTransport(bool serverFlag,
     _tappedNIF(0),
     _sendToEnabled(false),
     _localMulticastAddressEnabled(false),
+    _shardIndex(0u),
+    _shardCount(1u),
     _receiveBuffer(MAX_UDP_RECV+RECEIVE_BUFFER_PRE_RESERVE),
+    _activeReceiveBuffer(&_receiveBuffer),
     _sendBuffer(MAX_UDP_RECV),
     _lastMessageStartPosition(0),
     _clientServerWithEndianFlag(
@@ -118,11 +132,11 @@ void BlockingUDPTransport::close() {
 }
 
 void BlockingUDPTransport::ensureData(std::size_t size) {
-    if (_receiveBuffer.getRemaining() >= size)
+    if (_activeReceiveBuffer->getRemaining() >= size)
         return;
     std::ostringstream msg;
     msg<<"no more data in UDP packet : "
-       <<_receiveBuffer.getPosition()<<":"<<_receiveBuffer.getLimit()
+       <<_activeReceiveBuffer->getPosition()<<":"<<_activeReceiveBuffer->getLimit()
        <<" for "<<size;
     throw std::underflow_error(msg.str());
 }
@@ -192,6 +206,8 @@ void BlockingUDPTransport::enqueueSendRequest(TransportSender::shared_pointer co
         epicsGuard<TransportSender> G(*sender);
         sender->send(&_sendBuffer, this);
     }
+    if(_sendBuffer.getPosition()==0)
+        return; // nothing to send
     endMessage();
     if(!_sendToEnabled)
         send(&_sendBuffer);
@@ -224,67 +240,70 @@ void BlockingUDPTransport::run() {
     // This function is always called from only one thread - this
     // object's own thread.
 
-    osiSockAddr fromAddress;
-    osiSocklen_t addrStructSize = sizeof(sockaddr);
     Transport::shared_pointer thisTransport(internal_this);
 
     try {
 
+#ifdef USE_MMSG
+        // _receiveBuffer, and additional buffers to receive a batch of datagrams
+        std::vector<std::tr1::shared_ptr<ByteBuffer> > extraBuffers(RECEIVE_BATCH_SIZE-1);
+        ByteBuffer* buffers[RECEIVE_BATCH_SIZE];
+        buffers[0] = &_receiveBuffer;
+        for(size_t i=1; i<RECEIVE_BATCH_SIZE; i++) {
+            extraBuffers[i-1].reset(new ByteBuffer(_receiveBuffer.getSize()));
+            buffers[i] = extraBuffers[i-1].get();
+        }
+
+        osiSockAddr fromAddresses[RECEIVE_BATCH_SIZE];
+        struct iovec iovecs[RECEIVE_BATCH_SIZE];
+        struct mmsghdr msgs[RECEIVE_BATCH_SIZE];
+#else
+        osiSockAddr fromAddress;
+        osiSocklen_t addrStructSize = sizeof(sockaddr);
+
         char* recvfrom_buffer_start = (char*)(_receiveBuffer.getBuffer()+RECEIVE_BUFFER_PRE_RESERVE);
         size_t recvfrom_buffer_len =_receiveBuffer.getSize()-RECEIVE_BUFFER_PRE_RESERVE;
+#endif
         while(!_closed.get())
         {
+#ifdef USE_MMSG
+            memset(msgs, 0, sizeof(msgs));
+            for(size_t i=0; i<RECEIVE_BATCH_SIZE; i++) {
+                iovecs[i].iov_base = (char*)(buffers[i]->getBuffer()+RECEIVE_BUFFER_PRE_RESERVE);
+                iovecs[i].iov_len = buffers[i]->getSize()-RECEIVE_BUFFER_PRE_RESERVE;
+                msgs[i].msg_hdr.msg_iov = &iovecs[i];
+                msgs[i].msg_hdr.msg_iovlen = 1;
+                msgs[i].msg_hdr.msg_name = &fromAddresses[i].sa;
+                msgs[i].msg_hdr.msg_namelen = sizeof(fromAddresses[i]);
+            }
+
+            // block for the first datagram, then take any others already queued
+            int count = recvmmsg(_channel, msgs, RECEIVE_BATCH_SIZE, MSG_WAITFORONE, NULL);
+
+            if(likely(count>=0)) {
+                atomic::increment(_stats.recvCalls);
+                atomic::add(_stats.recvDatagrams, count);
+
+                for(int i=0; i<count; i++) {
+                    processDatagram(thisTransport, fromAddresses[i], buffers[i], msgs[i].msg_len);
+                }
+                continue;
+            }
+#else
             int bytesRead = recvfrom(_channel,
                                      recvfrom_buffer_start, recvfrom_buffer_len,
                                      0, (sockaddr*)&fromAddress,
                                      &addrStructSize);
 
             if(likely(bytesRead>=0)) {
-                // successfully got datagram
-                atomic::add(_totalBytesRecv, bytesRead);
-                bool ignore = false;
-                for(size_t i = 0; i <_ignoredAddresses.size(); i++)
-                {
-                    if(_ignoredAddresses[i].ia.sin_addr.s_addr==fromAddress.ia.sin_addr.s_addr)
-                    {
-                        ignore = true;
-                        if(pvAccessIsLoggable(logLevelDebug)) {
-                            char strBuffer[64];
-                            sockAddrToDottedIP(&fromAddress.sa, strBuffer, sizeof(strBuffer));
-                            LOG(logLevelDebug, "UDP Ignore (%d) %s x- %s", bytesRead, _remoteName.c_str(), strBuffer);
-                        }
-                        break;
-                    }
-                }
+                atomic::increment(_stats.recvCalls);
+                atomic::increment(_stats.recvDatagrams);
 
-                if(likely(!ignore)) {
-                    if(pvAccessIsLoggable(logLevelDebug)) {
-                        char strBuffer[64];
-                        sockAddrToDottedIP(&fromAddress.sa, strBuffer, sizeof(strBuffer));
-                        LOG(logLevelDebug, "UDP %s Rx (%d) %s <- %s", (_clientServerWithEndianFlag&0x40)?"Server":"Client", bytesRead, _remoteName.c_str(), strBuffer);
-                    }
-
-                    _receiveBuffer.setPosition(RECEIVE_BUFFER_PRE_RESERVE);
-                    _receiveBuffer.setLimit(RECEIVE_BUFFER_PRE_RESERVE+bytesRead);
-
-                    try {
-                        processBuffer(thisTransport, fromAddress, &_receiveBuffer);
-                    } catch(std::exception& e) {
-                        if(IS_LOGGABLE(logLevelError)) {
-                            char strBuffer[64];
-                            sockAddrToDottedIP(&fromAddress.sa, strBuffer, sizeof(strBuffer));
-                            size_t epos = _receiveBuffer.getPosition();
-
-                            // of course _receiveBuffer _may_ have been modified during processing...
-                            _receiveBuffer.setPosition(RECEIVE_BUFFER_PRE_RESERVE);
-                            _receiveBuffer.setLimit(RECEIVE_BUFFER_PRE_RESERVE+bytesRead);
-
-                            std::cerr<<"Error on UDP RX "<<strBuffer<<" -> "<<_remoteName<<" at "<<epos<<" : "<<e.what()<<"\n"
-                                      <<HexDump(_receiveBuffer).limit(256u);
-                        }
-                    }
-                }
-            } else {
+                processDatagram(thisTransport, fromAddress, &_receiveBuffer, bytesRead);
+                continue;
+            }
+#endif
+            {
 
                 int socketError = SOCKERRNO;
 
@@ -325,6 +344,61 @@ void BlockingUDPTransport::run() {
     }
 }
 
+void BlockingUDPTransport::processDatagram(Transport::shared_pointer const & transport, osiSockAddr& fromAddress,
+                                           ByteBuffer* receiveBuffer, int bytesRead)
+{
+    // successfully got datagram
+    atomic::add(_totalBytesRecv, bytesRead);
+
+    if (_shardCount > 1u)
+    {
+        // all sockets see this datagram, and agree on which one processes it
+        const char* data = receiveBuffer->getBuffer()+RECEIVE_BUFFER_PRE_RESERVE;
+        if (epicsMemHash(data, bytesRead, 0u) % _shardCount != _shardIndex)
+            return;
+    }
+
+    for(size_t i = 0; i <_ignoredAddresses.size(); i++)
+    {
+        if(_ignoredAddresses[i].ia.sin_addr.s_addr==fromAddress.ia.sin_addr.s_addr)
+        {
+            if(pvAccessIsLoggable(logLevelDebug)) {
+                char strBuffer[64];
+                sockAddrToDottedIP(&fromAddress.sa, strBuffer, sizeof(strBuffer));
+                LOG(logLevelDebug, "UDP Ignore (%d) %s x- %s", bytesRead, _remoteName.c_str(), strBuffer);
+            }
+            return;
+        }
+    }
+
+    if(pvAccessIsLoggable(logLevelDebug)) {
+        char strBuffer[64];
+        sockAddrToDottedIP(&fromAddress.sa, strBuffer, sizeof(strBuffer));
+        LOG(logLevelDebug, "UDP %s Rx (%d) %s <- %s", (_clientServerWithEndianFlag&0x40)?"Server":"Client", bytesRead, _remoteName.c_str(), strBuffer);
+    }
+
+    receiveBuffer->setPosition(RECEIVE_BUFFER_PRE_RESERVE);
+    receiveBuffer->setLimit(RECEIVE_BUFFER_PRE_RESERVE+bytesRead);
+    _activeReceiveBuffer = receiveBuffer;
+
+    try {
+        processBuffer(transport, fromAddress, receiveBuffer);
+    } catch(std::exception& e) {
+        if(IS_LOGGABLE(logLevelError)) {
+            char strBuffer[64];
+            sockAddrToDottedIP(&fromAddress.sa, strBuffer, sizeof(strBuffer));
+            size_t epos = receiveBuffer->getPosition();
+
+            // of course receiveBuffer _may_ have been modified during processing...
+            receiveBuffer->setPosition(RECEIVE_BUFFER_PRE_RESERVE);
+            receiveBuffer->setLimit(RECEIVE_BUFFER_PRE_RESERVE+bytesRead);
+
+            std::cerr<<"Error on UDP RX "<<strBuffer<<" -> "<<_remoteName<<" at "<<epos<<" : "<<e.what()<<"\n"
+                      <<HexDump(*receiveBuffer).limit(256u);
+        }
+    }
+}
+
 bool BlockingUDPTransport::processBuffer(Transport::shared_pointer const & transport,
         osiSockAddr& fromAddress, ByteBuffer* receiveBuffer) {
 
@@ -419,7 +493,7 @@ bool BlockingUDPTransport::processBuffer(Transport::shared_pointer const & trans
             // handle
             _responseHandler->handleResponse(&fromAddress, transport,
                                              version, command, payloadSize,
-                                             &_receiveBuffer);
+                                             receiveBuffer);
         }
 
         // set position (e.g. in case handler did not read all)
@@ -440,6 +514,7 @@ bool BlockingUDPTransport::send(const char* buffer, size_t length, const osiSock
 
     int retval = sendto(_channel, buffer,
                         length, 0, &(address.sa), sizeof(sockaddr));
+    atomic::increment(_stats.sendCalls);
     if(unlikely(retval<0))
     {
         char errStr[64];
@@ -448,6 +523,7 @@ bool BlockingUDPTransport::send(const char* buffer, size_t length, const osiSock
             inetAddressToString(address).c_str(), errStr);
         return false;
     }
+    atomic::increment(_stats.sendDatagrams);
     atomic::add(_totalBytesSent, length);
 
     return true;
@@ -465,6 +541,7 @@ bool BlockingUDPTransport::send(ByteBuffer* buffer, const osiSockAddr& address)
 
     int retval = sendto(_channel, buffer->getBuffer(),
                         buffer->getLimit(), 0, &(address.sa), sizeof(sockaddr));
+    atomic::increment(_stats.sendCalls);
     if(unlikely(retval<0))
     {
         char errStr[64];
@@ -473,6 +550,7 @@ bool BlockingUDPTransport::send(ByteBuffer* buffer, const osiSockAddr& address)
             inetAddressToString(address).c_str(), errStr);
         return false;
     }
+    atomic::increment(_stats.sendDatagrams);
     atomic::add(_totalBytesSent, buffer->getLimit());
 
     // all sent
@@ -486,7 +564,74 @@ bool BlockingUDPTransport::send(ByteBuffer* buffer, InetAddressType target) {
 
     buffer->flip();
 
+    bool allOK = sendToAll(buffer->getBuffer(), buffer->getLimit(), target);
+
+    // all sent
+    buffer->setPosition(buffer->getLimit());
+
+    return allOK;
+}
+
+bool BlockingUDPTransport::sendToAll(const char* buffer, size_t length, InetAddressType target)
+{
     bool allOK = true;
+
+#ifdef USE_MMSG
+    // one message per destination, all referencing the same payload
+    struct iovec iov;
+    iov.iov_base = const_cast<char*>(buffer);
+    iov.iov_len = length;
+
+    struct mmsghdr msgs[SEND_BATCH_SIZE];
+    size_t dests[SEND_BATCH_SIZE];
+    size_t i = 0;
+
+    while(i<_sendAddresses.size()) {
+        // fill a batch
+        size_t count = 0;
+        memset(msgs, 0, sizeof(msgs));
+        for(; i<_sendAddresses.size() && count<SEND_BATCH_SIZE; i++) {
+            // filter
+            if (target != inetAddressType_all)
+                if ((target == inetAddressType_unicast && !_isSendAddressUnicast[i]) ||
+                        (target == inetAddressType_broadcast_multicast && _isSendAddressUnicast[i]))
+                    continue;
+
+            if (IS_LOGGABLE(logLevelDebug))
+            {
+                LOG(logLevelDebug, "Sending %zu bytes %s -> %s.",
+                    length, _remoteName.c_str(), inetAddressToString(_sendAddresses[i]).c_str());
+            }
+
+            msgs[count].msg_hdr.msg_iov = &iov;
+            msgs[count].msg_hdr.msg_iovlen = 1;
+            msgs[count].msg_hdr.msg_name = &_sendAddresses[i].sa;
+            msgs[count].msg_hdr.msg_namelen = sizeof(sockaddr);
+            dests[count] = i;
+            count++;
+        }
+
+        // sendmmsg() stops at the first failed message, which is then skipped
+        size_t sent = 0;
+        while(sent<count) {
+            int retval = sendmmsg(_channel, &msgs[sent], count-sent, 0);
+            atomic::increment(_stats.sendCalls);
+            if(unlikely(retval<=0))
+            {
+                char errStr[64];
+                epicsSocketConvertErrnoToString(errStr, sizeof(errStr));
+                LOG(logLevelDebug, "Socket sendto to %s error: %s.",
+                    inetAddressToString(_sendAddresses[dests[sent]]).c_str(), errStr);
+                allOK = false;
+                sent++;
+            } else {
+                atomic::add(_stats.sendDatagrams, retval);
+                atomic::add(_totalBytesSent, length*retval);
+                sent += retval;
+            }
+        }
+    }
+#else
     for(size_t i = 0; i<_sendAddresses.size(); i++) {
 
         // filter
@@ -498,12 +643,13 @@ bool BlockingUDPTransport::send(ByteBuffer* buffer, InetAddressType target) {
         if (IS_LOGGABLE(logLevelDebug))
         {
             LOG(logLevelDebug, "Sending %zu bytes %s -> %s.",
-                buffer->getRemaining(), _remoteName.c_str(), inetAddressToString(_sendAddresses[i]).c_str());
+                length, _remoteName.c_str(), inetAddressToString(_sendAddresses[i]).c_str());
         }
 
-        int retval = sendto(_channel, buffer->getBuffer(),
-                            buffer->getLimit(), 0, &(_sendAddresses[i].sa),
+        int retval = sendto(_channel, buffer,
+                            length, 0, &(_sendAddresses[i].sa),
                             sizeof(sockaddr));
+        atomic::increment(_stats.sendCalls);
         if(unlikely(retval<0))
         {
             char errStr[64];
@@ -511,16 +657,23 @@ bool BlockingUDPTransport::send(ByteBuffer* buffer, InetAddressType target) {
             LOG(logLevelDebug, "Socket sendto to %s error: %s.",
                 inetAddressToString(_sendAddresses[i]).c_str(), errStr);
             allOK = false;
+        } else {
+            atomic::increment(_stats.sendDatagrams);
         }
-        atomic::add(_totalBytesSent, buffer->getLimit());
+        atomic::add(_totalBytesSent, length);
     }
-
-    // all sent
-    buffer->setPosition(buffer->getLimit());
+#endif
 
     return allOK;
 }
 
+void BlockingUDPTransport::getStats(Stats& stats) const
+{
+    stats.recvCalls = atomic::get(_stats.recvCalls);
+    stats.recvDatagrams = atomic::get(_stats.recvDatagrams);
+    stats.sendCalls = atomic::get(_stats.sendCalls);
+    stats.sendDatagrams = atomic::get(_stats.sendDatagrams);
+}
 
 void BlockingUDPTransport::join(const osiSockAddr & mcastAddr, const osiSockAddr & nifAddr)
 {
@@ -573,6 +726,47 @@ void BlockingUDPTransport::setMutlicastNIF(const osiSockAddr & nifAddr, bool loo
 
 }
 
+namespace {
+/* Bind additional sockets to the same address as 'primary', each to be served by its own thread.
+ *
+ * Unicast datagrams are distributed between sockets sharing SO_REUSEPORT by the kernel (Linux).
+ * Broadcast and multicast datagrams are delivered to every socket,
+ * so with 'shard' each socket processes only its share of these.
+ *
+ * Replicas inherit the ignore list and tapped NIF list of 'primary', and are not started.
+ */
+void replicateUDPTransport(BlockingUDPConnector& connector,
+                           const ResponseHandler::shared_pointer& responseHandler,
+                           const BlockingUDPTransport::shared_pointer& primary,
+                           int8_t protoVer,
+                           unsigned int count,
+                           bool shard,
+                           BlockingUDPTransportVector& replicas)
+{
+    osiSockAddr bindAddress(*primary->getBindAddress());
+
+    for (unsigned int n = 1u; n < count; n++)
+    {
+        BlockingUDPTransport::shared_pointer replica = connector.connect(
+                    responseHandler, bindAddress, protoVer, true);
+        if (!replica)
+            break;
+
+        replica->setIgnoredAddresses(primary->getIgnoredAddresses());
+        replica->setTappedNIF(primary->getTappedNIF());
+        replicas.push_back(replica);
+    }
+
+    if (shard && !replicas.empty())
+    {
+        const unsigned int actual = 1u + replicas.size();
+        primary->setShard(0u, actual);
+        for (unsigned int n = 0u; n < replicas.size(); n++)
+            replicas[n]->setShard(n+1u, actual);
+    }
+}
+} // namespace
+
 void initializeUDPTransports(bool serverFlag,
                              BlockingUDPTransportVector& udpTransports,
                              const IfaceNodeVector& ifaceList,
@@ -581,7 +775,8 @@ void initializeUDPTransports(bool serverFlag,
                              int32& listenPort,
                              bool autoAddressList,
                              const std::string& addressList,
-                             const std::string& ignoreAddressList)
+                             const std::string& ignoreAddressList,
+                             unsigned int listenerCount)
 {
     BlockingUDPConnector connector(serverFlag);
 
@@ -712,6 +907,18 @@ void initializeUDPTransports(bool serverFlag,
     InetAddrVector ignoreAddressVector;
     getSocketAddressList(ignoreAddressVector, ignoreAddressList, 0, 0);
 
+#ifndef SO_REUSEPORT
+    if (listenerCount > 1u) {
+        LOG(logLevelWarn, "SO_REUSEPORT not supported, using one UDP listener per address.");
+        listenerCount = 1u;
+    }
+#endif
+    if (listenerCount < 1u)
+        listenerCount = 1u;
+    // several sockets, each with a receive thread, are bound to each listening address.
+    // All must set SO_REUSEPORT.
+    const bool reusePort = listenerCount > 1u;
+
     //
     // Setup UDP trasport(s) (per interface)
     //
@@ -736,7 +943,7 @@ void initializeUDPTransports(bool serverFlag,
             listenLocalAddress.ia.sin_addr.s_addr = node.addr.ia.sin_addr.s_addr;
 
             BlockingUDPTransport::shared_pointer transport = connector.connect(
-                        responseHandler, listenLocalAddress, protoVer);
+                        responseHandler, listenLocalAddress, protoVer, reusePort);
             if (!transport)
                 continue;
             listenLocalAddress = transport->getRemoteAddress();
@@ -745,6 +952,10 @@ void initializeUDPTransports(bool serverFlag,
 
             tappedNIF.push_back(listenLocalAddress);
 
+            // the kernel distributes unicast datagrams by peer address, so no sharding
+            BlockingUDPTransportVector replicas, replicas2;
+            replicateUDPTransport(connector, responseHandler, transport, protoVer, listenerCount, false, replicas);
+
 
             BlockingUDPTransport::shared_pointer transport2;
 
@@ -770,7 +981,7 @@ void initializeUDPTransports(bool serverFlag,
                 bcastAddress.ia.sin_port = htons(listenPort);
                 bcastAddress.ia.sin_addr.s_addr = node.bcast.ia.sin_addr.s_addr;
 
-                transport2 = connector.connect(responseHandler, bcastAddress, protoVer);
+                transport2 = connector.connect(responseHandler, bcastAddress, protoVer, reusePort);
                 if (transport2)
                 {
                     /* The other wrinkle is that nothing should be sent from this second
@@ -783,6 +994,9 @@ void initializeUDPTransports(bool serverFlag,
                     transport2->setIgnoredAddresses(ignoreAddressVector);
 
                     tappedNIF.push_back(bcastAddress);
+
+                    // every socket receives each broadcast, so shard
+                    replicateUDPTransport(connector, responseHandler, transport2, protoVer, listenerCount, true, replicas2);
                 }
             }
 #endif
@@ -793,11 +1007,27 @@ void initializeUDPTransports(bool serverFlag,
             transport->start();
             udpTransports.push_back(transport);
 
+            // unicast searches received by any replica are re-broadcast locally like the original
+            for (size_t i = 0; i < replicas.size(); i++)
+            {
+                replicas[i]->setMutlicastNIF(loAddr, true);
+                replicas[i]->setLocalMulticastAddress(group);
+
+                replicas[i]->start();
+                udpTransports.push_back(replicas[i]);
+            }
+
             if (transport2)
             {
                 transport2->start();
                 udpTransports.push_back(transport2);
             }
+
+            for (size_t i = 0; i < replicas2.size(); i++)
+            {
+                replicas2[i]->start();
+                udpTransports.push_back(replicas2[i]);
+            }
         }
     }
 
@@ -822,15 +1052,28 @@ void initializeUDPTransports(bool serverFlag,
 #else
                                       anyAddress,
 #endif
-                                      protoVer);
+                                      protoVer, reusePort);
         if (!localMulticastTransport)
             throw std::runtime_error("Failed to bind UDP socket.");
 
         localMulticastTransport->setTappedNIF(tappedNIF);
         localMulticastTransport->join(group, loAddr);
+
+        // every socket receives each multicast, so shard
+        BlockingUDPTransportVector replicas;
+        replicateUDPTransport(connector, responseHandler, localMulticastTransport, protoVer, listenerCount, true, replicas);
+        for (size_t i = 0; i < replicas.size(); i++)
+            replicas[i]->join(group, loAddr);
+
         localMulticastTransport->start();
         udpTransports.push_back(localMulticastTransport);
 
+        for (size_t i = 0; i < replicas.size(); i++)
+        {
+            replicas[i]->start();
+            udpTransports.push_back(replicas[i]);
+        }
+
         LOG(logLevelDebug, "Local multicast enabled on %s/%s.",
             inetAddressToString(loAddr, false).c_str(),
             inetAddressToString(group).c_str());
@@ -6,6 +6,7 @@
 
 #include <map>
 #include <string>
+#include <algorithm>
 #include <vector>
 #include <limits>
 #include <stdexcept>
@@ -37,6 +38,7 @@
 #include <pv/serializationHelper.h>
 #include <pv/serverChannelImpl.h>
 #include <pv/clientContextImpl.h>
+#include <pv/pvAccessMB.h>
 
 using namespace std;
 using namespace epics::pvData;
@@ -219,6 +221,9 @@ void AbstractCodec::processReadNormal()  {
                         "not-a-first segmented message received in normal mode");
                 }
 
+                MB_INC_AUTO_ID(pvAccessMB);
+                MB_POINT(pvAccessMB, 1, "receive header");
+
                 _storedPayloadSize = _payloadSize;
                 _storedPosition = _socketBuffer.getPosition();
                 _storedLimit = _socketBuffer.getLimit();
@@ -226,6 +231,8 @@ void AbstractCodec::processReadNormal()  {
                 bool postProcess = true;
                 try
                 {
+                    MB_POINT(pvAccessMB, 2, "handler dispatch");
+
                     // handle response
                     processApplicationMessage();
 
@@ -791,6 +798,10 @@ void AbstractCodec::send(ByteBuffer *buffer)
         }
         tries = 0;
     }
+
+    // ID was set by the last sender, if it was part of a sample
+    MB_POINT(pvAccessMB, 7, "socket write");
+    MB_SET_AUTO_ID(pvAccessMB, 0u);
 }
 
 
@@ -1019,7 +1030,11 @@ void BlockingTCPTransportCodec::waitJoin()
 
 void BlockingTCPTransportCodec::internalClose()
 {
-    {
+    if(_rxPipe) {
+        _rxPipe->close();
+        _txPipe->close();
+
+    } else {
 
         epicsSocketSystemCallInterruptMechanismQueryInfo info  =
             epicsSocketSystemCallInterruptMechanismQuery ();
@@ -1161,6 +1176,11 @@ void BlockingTCPTransportCodec::setRxTimeout(bool ena)
     timo.tv_usec = (timeout-timo.tv_sec)*1e6;
 #endif
 
+    if(_rxPipe) {
+        _rxTimeout = timeout;
+        return;
+    }
+
     int ret = setsockopt(_channel, SOL_SOCKET, SO_RCVTIMEO, (char*)&timo, sizeof(timo));
     if(ret==-1) {
         int err = SOCKERRNO;
@@ -1187,8 +1207,99 @@ void BlockingTCPTransportCodec::sendBufferFull(int tries) {
 
 size_t BlockingTCPTransportCodec::num_instances;
 
+namespace {
+size_t powerOf2(size_t size)
+{
+    size_t ret = 1u;
+    while(ret < size)
+        ret <<= 1u;
+    return ret;
+}
+}
+
+LoopbackPipe::LoopbackPipe(size_t size)
+    :_ring(powerOf2(size))
+    ,_mask(_ring.size()-1u)
+    ,_head(0u)
+    ,_tail(0u)
+    ,_closed(0)
+{}
+
+LoopbackPipe::~LoopbackPipe() {}
+
+int LoopbackPipe::write(const char *buf, size_t count)
+{
+    while(true) {
+        if(epics::atomic::get(_closed))
+            return -1;
+
+        const size_t head = _head;
+        const size_t space = _ring.size() - (head - epics::atomic::get(_tail));
+
+        if(space==0u) {
+            _writable.wait();
+            continue;
+        }
+
+        const size_t n = std::min(space, count);
+        const size_t start = head & _mask;
+        const size_t first = std::min(n, _ring.size() - start);
+        memcpy(&_ring[start], buf, first);
+        memcpy(&_ring[0], buf+first, n-first);
+
+        epics::atomic::set(_head, head+n); // publish
+        _readable.signal();
+        return int(n);
+    }
+}
+
+int LoopbackPipe::read(char *buf, size_t count, double timeout)
+{
+    while(true) {
+        const size_t tail = _tail;
+        const size_t avail = epics::atomic::get(_head) - tail;
+
+        if(avail==0u) {
+            if(epics::atomic::get(_closed))
+                return -1;
+            if(timeout<=0.0)
+                _readable.wait();
+            else if(!_readable.wait(timeout))
+                return -1;
+            continue;
+        }
+
+        const size_t n = std::min(avail, count);
+        const size_t start = tail & _mask;
+        const size_t first = std::min(n, _ring.size() - start);
+        memcpy(buf, &_ring[start], first);
+        memcpy(buf+first, &_ring[0], n-first);
+
+        epics::atomic::set(_tail, tail+n); // release space
+        _writable.signal();
+        return int(n);
+    }
+}
+
+void LoopbackPipe::close()
+{
+    epics::atomic::set(_closed, 1);
+    _readable.signal();
+    _writable.signal();
+}
+
+void CodecEndpoint::loopbackPair(CodecEndpoint& client, const osiSockAddr& serverAddress,
+                                 CodecEndpoint& server, const osiSockAddr& clientAddress,
+                                 size_t size)
+{
+    LoopbackPipe::shared_pointer toServer(new LoopbackPipe(size)),
+                                 toClient(new LoopbackPipe(size));
+    client = CodecEndpoint(toClient, toServer, serverAddress);
+    server = CodecEndpoint(toServer, toClient, clientAddress);
+}
+
 BlockingTCPTransportCodec::BlockingTCPTransportCodec(bool serverFlag, const Context::shared_pointer &context,
-    SOCKET channel, const ResponseHandler::shared_pointer &responseHandler,
+    const CodecEndpoint& channel, const ResponseHandler::shared_pointer &responseHandler,
     size_t sendBufferSize,
     size_t receiveBufferSize, int16 priority)
     :AbstractCodec(
@@ -1207,7 +1318,10 @@ BlockingTCPTransportCodec::BlockingTCPTransportCodec(bool serverFlag, const Cont
                  .name("TCP-tx")
                  .stack(epicsThreadStackBig)
                  .autostart(false))
-    ,_channel(channel)
+    ,_channel(channel.socket)
+    ,_rxPipe(channel.rx)
+    ,_txPipe(channel.tx)
+    ,_rxTimeout(0.0)
     ,_context(context), _responseHandler(responseHandler)
     ,_remoteTransportReceiveBufferSize(MAX_TCP_RECV)
     ,_priority(priority)
@@ -1217,6 +1331,14 @@ BlockingTCPTransportCodec::BlockingTCPTransportCodec(bool serverFlag, const Cont
 
     _isOpen.getAndSet(true);
 
+    if(_rxPipe) {
+        _socketAddress = channel.peer;
+        char ipAddrStr[24];
+        ipAddrToDottedIP(&_socketAddress.ia, ipAddrStr, sizeof(ipAddrStr));
+        _socketName = std::string("loopback:") + ipAddrStr;
+        return;
+    }
+
     // get remote address
     osiSocklen_t saSize = sizeof(sockaddr);
     int retval = getpeername(_channel, &(_socketAddress.sa), &saSize);
@@ -1243,6 +1365,16 @@ void BlockingTCPTransportCodec::invalidDataStreamHandler() {
 int BlockingTCPTransportCodec::write(
     epics::pvData::ByteBuffer *src) {
 
+    if(_txPipe) {
+        int bytesSent = 0;
+        if(src->getRemaining() > 0) {
+            bytesSent = _txPipe->write(&src->getBuffer()[src->getPosition()], src->getRemaining());
+            if(bytesSent > 0)
+                src->setPosition(src->getPosition() + bytesSent);
+        }
+        return bytesSent;
+    }
+
     std::size_t remaining;
     while((remaining=src->getRemaining()) > 0) {
 
@@ -1279,6 +1411,16 @@ int BlockingTCPTransportCodec::write(
 
 int BlockingTCPTransportCodec::read(epics::pvData::ByteBuffer* dst) {
 
+    if(_rxPipe) {
+        int bytesRead = 0;
+        if(dst->getRemaining() > 0) {
+            bytesRead = _rxPipe->read((char*)(dst->getBuffer()+dst->getPosition()), dst->getRemaining(), _rxTimeout);
+            if(bytesRead > 0)
+                dst->setPosition(dst->getPosition() + bytesRead);
+        }
+        return bytesRead;
+    }
+
     std::size_t remaining;
     while((remaining=dst->getRemaining()) > 0) {
 
@@ -1397,7 +1539,7 @@ void BlockingTCPTransportCodec::sendSecurityPluginMessage(epics::pvData::PVStruc
 
 BlockingServerTCPTransportCodec::BlockingServerTCPTransportCodec(
     Context::shared_pointer const & context,
-    SOCKET channel,
+    const CodecEndpoint& channel,
     ResponseHandler::shared_pointer const & responseHandler,
     int32_t sendBufferSize,
     int32_t receiveBufferSize)
@@ -1537,6 +1679,13 @@ void BlockingServerTCPTransportCodec::send(ByteBuffer* buffer,
             SerializeHelper::serializeString(*iter, buffer, this);
         }
 
+        // features, an addition which clients not expecting it ignore
+        int8 features = 0;
+        if(_context->getConfiguration()->getPropertyAsBoolean("EPICS_PVAS_MULTI_CREATE", true))
+            features |= PVA_SERVER_FEATURE_MULTI_CREATE;
+        ensureBuffer(1);
+        buffer->putByte(features);
+
         {
             Guard G(_mutex);
             advertisedAuthPlugins.swap(validSPNames);
@@ -1661,7 +1810,7 @@ void BlockingServerTCPTransportCodec::authNZInitialize(const std::string& securi
 
 BlockingClientTCPTransportCodec::BlockingClientTCPTransportCodec(
     Context::shared_pointer const & context,
-    SOCKET channel,
+    const CodecEndpoint& channel,
     ResponseHandler::shared_pointer const & responseHandler,
     int32_t sendBufferSize,
     int32_t receiveBufferSize,
@@ -1673,7 +1822,8 @@ BlockingClientTCPTransportCodec::BlockingClientTCPTransportCodec(
                               sendBufferSize, receiveBufferSize, priority),
     _connectionTimeout(heartbeatInterval),
     _verifyOrEcho(true),
-    sendQueued(true) // don't start sending echo until after auth complete
+    sendQueued(true), // don't start sending echo until after auth complete
+    _serverFeatures(0)
 {
     // initialize owners list, send queue
     acquire(client);
@@ -1770,6 +1920,14 @@ void BlockingClientTCPTransportCodec::internalClose() {
     }
 
     _owners.clear();
+
+    notifyVerifyListener();
+
+    ClientContextImpl *context = dynamic_cast<ClientContextImpl*>(_context.get());
+    if (context)
+    {
+        EXCEPTION_GUARD(context->transportClosed(this));
+    }
 }
 
 //void BlockingClientTCPTransportCodec::release(ClientChannelImpl::shared_pointer const & client) {
@@ -1921,6 +2079,18 @@ void BlockingClientTCPTransportCodec::verified(epics::pvData::Status const & sta
     if(sess)
         sess->authenticationComplete(status);
     this->BlockingTCPTransportCodec::verified(status);
+    notifyVerifyListener();
+}
+
+void BlockingClientTCPTransportCodec::notifyVerifyListener()
+{
+    std::tr1::shared_ptr<VerifyListener> listener;
+    {
+        Guard G(_mutex);
+        listener = _verifyListener.lock();
+    }
+    if(listener)
+        listener->verifyDone();
 }
 
 }
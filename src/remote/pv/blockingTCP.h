@@ -10,6 +10,7 @@
 #include <set>
 #include <map>
 #include <deque>
+#include <vector>
 
 #ifdef epicsExportSharedSymbols
 #   define blockingTCPEpicsExportSharedSymbols
@@ -20,12 +21,14 @@
 #include <osiSock.h>
 #include <epicsTime.h>
 #include <epicsThread.h>
+#include <epicsEvent.h>
 
 #include <pv/byteBuffer.h>
 #include <pv/pvType.h>
 #include <pv/lock.h>
 #include <pv/timer.h>
 #include <pv/event.h>
+#include <pv/thread.h>
 
 #ifdef blockingTCPEpicsExportSharedSymbols
 #   define epicsExportSharedSymbols
@@ -43,26 +46,52 @@ namespace pvAccess {
 
 class ClientChannelImpl;
 
+namespace detail {
+struct CodecEndpoint;
+}
+
 /**
  * Channel Access TCP connector.
  * @author <a href="mailto:matej.sekoranjaATcosylab.com">Matej Sekoranja</a>
  * @version $Id: BlockingTCPConnector.java,v 1.1 2010/05/03 14:45:47 mrkraimer Exp $
  */
-class BlockingTCPConnector {
+class BlockingTCPConnector : public epicsThreadRunable {
 public:
     POINTER_DEFINITIONS(BlockingTCPConnector);
 
+    /**
+     * @param loopback Connect to servers of this process through an in-process
+     *                 connection, bypassing the network stack.  cf. BlockingTCPAcceptor::connectLoopback()
+     */
     BlockingTCPConnector(Context::shared_pointer const & context, int receiveBufferSize,
-                         float beaconInterval);
+                         float beaconInterval, bool loopback = false);
 
-    Transport::shared_pointer connect(std::tr1::shared_ptr<ClientChannelImpl> const & client,
-            ResponseHandler::shared_pointer const & responseHandler, osiSockAddr& address,
+    virtual ~BlockingTCPConnector();
+
+    /**
+     * Begin connecting to a server, or re-use an existing connection.
+     * Does not block.  Completion is reported, possibly before return, through
+     * ClientChannelImpl::transportConnected() or ClientChannelImpl::createChannelFailed().
+     * Clients connecting to the same address and priority while a connection is being
+     * established and validated are parked on that pending connection.
+     */
+    void connect(std::tr1::shared_ptr<ClientChannelImpl> const & client,
+            ResponseHandler::shared_pointer const & responseHandler, const osiSockAddr& address,
             epics::pvData::int8 transportRevision, epics::pvData::int16 priority);
+
+    /**
+     * Abandon all pending connections, and stop the worker thread.
+     * Parked clients are not notified.
+     */
+    void close();
+
 private:
+    virtual void run() OVERRIDE FINAL;
+
     /**
-     * Lock timeout
+     * Verify timeout
      */
-    static const int LOCK_TIMEOUT = 20*1000; // 20s
+    static const int VERIFY_TIMEOUT = 5; // 5s
 
     /**
      * Context instance.
@@ -75,19 +104,48 @@ private:
     int _receiveBufferSize;
 
     /**
-     * Heartbeat interval.
+     * Heartbeat interval.  Also the timeout of TCP connect().
      */
     float _heartbeatInterval;
 
+    const bool _loopback;
+
     /**
-     * Tries to connect to the given address.
-     * @param[in] address
-     * @param[in] tries
-     * @return the SOCKET
-     * @throws IOException
+     * Connection being established (non-blocking connect()), or validated.
      */
-    SOCKET tryConnect(osiSockAddr& address, int tries);
+    struct Pending;
+    typedef std::vector<std::tr1::shared_ptr<Pending> > pending_t;
+
+    epics::pvData::Mutex _mutex;
+    pending_t _pending;
+    bool _closed;
+
+    /**
+     * Interrupts the worker's wait on connecting sockets.
+     * Signaled by connect(), close(), and by transports which complete validation.
+     */
+    struct Wakeup;
+    const std::tr1::shared_ptr<Wakeup> _wakeup;
+    epicsThread _thread;
+
+    /**
+     * Start a non-blocking connect().
+     * @return the SOCKET, or INVALID_SOCKET on immediate failure.
+     */
+    SOCKET startConnect(const osiSockAddr& address);
+
+    /**
+     * Connect to a server of this process, when _loopback is set.  Called with _mutex locked.
+     * On success, pend holds the new transport, which the worker validates.
+     * @return false if the address is not of this process, or the transport could not be created.
+     */
+    bool startLoopback(Pending& pend,
+                       const std::tr1::shared_ptr<ClientChannelImpl>& client,
+                       const Context::shared_pointer& context);
+
+    void connected(const std::tr1::shared_ptr<Pending>& pending);
 
+    void complete(const std::tr1::shared_ptr<Pending>& pending, bool success, const char *reason);
 };
 
 /**
@@ -99,9 +157,29 @@ class BlockingTCPAcceptor : public epicsThreadRunable {
 public:
     POINTER_DEFINITIONS(BlockingTCPAcceptor);
 
+    //! Default length of the queue of pending connections passed to listen()
+    static const int DEFAULT_BACKLOG = 128;
+
+    /**
+     * Several acceptors may listen on the same port with SO_REUSEPORT.
+     * The kernel then distributes new connections between them (Linux).
+     */
+    enum ReusePort {
+        //! Exclusive use of the port
+        ReuseNone,
+        //! First of several acceptors.  Falls back to a dynamic port if the configured port is in use.
+        ReuseFirst,
+        //! Additional acceptor listening on the (actual) port of a ReuseFirst acceptor
+        ReuseShared
+    };
+
+    /**
+     * @param backlog length of the kernel queue of not yet accepted connections.
+     */
     BlockingTCPAcceptor(Context::shared_pointer const & context,
                         ResponseHandler::shared_pointer const & responseHandler,
-                        const osiSockAddr& addr, int receiveBufferSize);
+                        const osiSockAddr& addr, int receiveBufferSize,
+                        int backlog = DEFAULT_BACKLOG, ReusePort reusePort = ReuseNone);
 
     virtual ~BlockingTCPAcceptor();
 
@@ -118,9 +196,50 @@ public:
      */
     void destroy();
 
+    struct Stats {
+        //! connections accepted
+        size_t accepted;
+        //! longest observed queue of connections waiting for accept()  (Linux only)
+        size_t acceptQueuePeak;
+        //! number of times the accept() queue was found full  (Linux only)
+        size_t acceptQueueFull;
+        //! longest observed queue of accepted connections waiting for setup
+        size_t setupQueuePeak;
+        Stats() :accepted(0u), acceptQueuePeak(0u), acceptQueueFull(0u), setupQueuePeak(0u) {}
+    };
+
+    void getStats(Stats& stats) const;
+
+    int getBacklog() const { return _backlog; }
+
+    /**
+     * System wide counts of TCP connections dropped because a listen queue overflowed.
+     * Read from /proc/net/netstat (ListenOverflows and ListenDrops).
+     * @return false if not available on this target.
+     */
+    static bool getListenOverflows(size_t& overflows, size_t& drops);
+
+    //! Capacity in bytes of each direction of an in-process connection
+    static const size_t LOOPBACK_PIPE_SIZE = 1u<<18;
+
+    /**
+     * Open an in-process connection to the acceptor of this process listening at address.
+     * Matches the same address, or 127.0.0.1 with the port of an acceptor bound to the wildcard address.
+     * The server end is set up, and validated, like an accepted socket.
+     * @param clientEnd Set to the client end of the connection, to be passed to
+     *                  detail::BlockingClientTCPTransportCodec::create().
+     * @return false if no acceptor of this process listens at address.
+     */
+    static bool connectLoopback(const osiSockAddr& address, detail::CodecEndpoint& clientEnd);
+
 private:
     virtual void run();
 
+    /**
+     * Creates transports for accepted sockets, and starts their validation.
+     */
+    void setupThread();
+
     /**
      * Context instance.
      */
@@ -146,14 +265,28 @@ private:
      */
     int _receiveBufferSize;
 
+    const int _backlog;
+    const ReusePort _reusePort;
+
     /**
      * Destroyed flag.
      */
     bool _destroyed;
 
-    epics::pvData::Mutex _mutex;
+    mutable epics::pvData::Mutex _mutex;
+
+    struct Accepted {
+        SOCKET socket;
+        osiSockAddr address;
+    };
+    //! accepted sockets waiting for setupThread().  Guarded by _mutex
+    std::deque<Accepted> _setupQueue;
+    epicsEvent _setupWakeup;
+
+    Stats _stats;
 
     epicsThread _thread;
+    epics::pvData::Thread _setupThread;
 
     /**
      * Initialize connection acception.
@@ -162,10 +295,15 @@ private:
     int initialize();
 
     /**
-     * Validate connection by sending a validation message request.
-     * @return <code>true</code> on success.
+     * Create transport for the server end of an in-process connection,
+     * and begin validating the connection.
+     */
+    void setupLoopback(const detail::CodecEndpoint& serverEnd);
+
+    /**
+     * Create transport for an accepted socket, and begin validating the connection.
      */
-    bool validateConnection(Transport::shared_pointer const & transport, const char* address);
+    void setupConnection(const Accepted& client);
 };
 
 }
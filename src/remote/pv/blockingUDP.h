@@ -220,6 +220,17 @@ public:
         _tappedNIF = addresses;
     }
 
+    /**
+     * Process only a share of received datagrams.
+     * Used when several sockets receive the same broadcast/multicast traffic.
+     * @param index this share, in [0, count)
+     * @param count number of sockets sharing the traffic.
+     */
+    void setShard(unsigned int index, unsigned int count) {
+        _shardIndex = index;
+        _shardCount = count;
+    }
+
     /**
      * Get list of tapped NIF addresses.
      * @return tapped NIF addresses.
@@ -266,6 +277,15 @@ public:
 
     void join(const osiSockAddr & mcastAddr, const osiSockAddr & nifAddr);
 
+    //! Socket I/O counters.  Datagrams per system call shows the effect of batching.
+    struct Stats {
+        size_t recvCalls, recvDatagrams;
+        size_t sendCalls, sendDatagrams;
+        Stats() :recvCalls(0u), recvDatagrams(0u), sendCalls(0u), sendDatagrams(0u) {}
+    };
+
+    void getStats(Stats& stats) const;
+
     void setMutlicastNIF(const osiSockAddr & nifAddr, bool loopback);
 
 protected:
@@ -279,8 +299,13 @@ protected:
     virtual void run() OVERRIDE FINAL;
 
 private:
+    void processDatagram(Transport::shared_pointer const & transport, osiSockAddr& fromAddress,
+                         epics::pvData::ByteBuffer* receiveBuffer, int bytesRead);
+
     bool processBuffer(Transport::shared_pointer const & transport, osiSockAddr& fromAddress, epics::pvData::ByteBuffer* receiveBuffer);
 
+    bool sendToAll(const char* buffer, size_t length, InetAddressType target);
+
     void close(bool waitForThreadToComplete);
 
     // Context only used for logging in this class
@@ -338,11 +363,22 @@ private:
     osiSockAddr _localMulticastAddress;
     bool _localMulticastAddressEnabled;
 
+    /**
+     * Share of received datagrams to process.
+     */
+    unsigned int _shardIndex, _shardCount;
+
     /**
      * Receive buffer.
      */
     epics::pvData::ByteBuffer _receiveBuffer;
 
+    /**
+     * Buffer of the datagram being processed (_receiveBuffer, or another batch buffer).
+     * Only accessed from receive thread.
+     */
+    epics::pvData::ByteBuffer* _activeReceiveBuffer;
+
     /**
      * Send buffer.
      */
@@ -366,6 +402,7 @@ private:
 
     epics::pvData::int8 _clientServerWithEndianFlag;
 
+    Stats _stats;
 };
 
 class BlockingUDPConnector{
@@ -376,11 +413,14 @@ public:
 
     /**
      * NOTE: transport client is ignored for broadcast (UDP).
+     * @param reusePort If true, set SO_REUSEPORT so that several sockets may bind
+     *        the same address, with unicast traffic balanced between them.
      */
     BlockingUDPTransport::shared_pointer connect(
             ResponseHandler::shared_pointer const & responseHandler,
             osiSockAddr& bindAddress,
-            epics::pvData::int8 transportRevision);
+            epics::pvData::int8 transportRevision,
+            bool reusePort = false);
 
 private:
 
@@ -403,7 +443,8 @@ void initializeUDPTransports(
     epics::pvData::int32& listenPort,
     bool autoAddressList,
     const std::string& addressList,
-    const std::string& ignoreAddressList);
+    const std::string& ignoreAddressList,
+    unsigned int unicastListenerCount = 1u);
 
 
 }
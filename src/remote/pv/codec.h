@@ -10,6 +10,9 @@
 #include <set>
 #include <map>
 #include <deque>
+#include <vector>
+
+#include <string.h>
 
 #include <shareLib.h>
 #include <osiSock.h>
@@ -24,6 +27,7 @@
 #include <pv/timer.h>
 #include <pv/event.h>
 #include <pv/likely.h>
+#include <pv/noDefaultMethods.h>
 
 #include <pv/pvaConstants.h>
 #include <pv/remote.h>
@@ -200,6 +204,10 @@ public:
         return _sendQueue.empty();
     }
 
+    size_t sendQueueSize() const {
+        return _sendQueue.size();
+    }
+
     epics::pvData::int8 getRevision() const {
         epicsGuard<epicsMutex> G(_mutex);
         int8_t myver = _clientServerFlag ? PVA_SERVER_PROTOCOL_REVISION : PVA_CLIENT_PROTOCOL_REVISION;
@@ -263,6 +271,71 @@ public:
 };
 
 
+/**
+ * One direction of an in-process connection.  A byte ring with one writer thread and one reader thread.
+ * The data path is lock-free.  Events are used only to block a reader of an empty pipe,
+ * or a writer to a full pipe.
+ */
+class epicsShareClass LoopbackPipe
+{
+public:
+    POINTER_DEFINITIONS(LoopbackPipe);
+
+    //! @param size capacity in bytes.  Rounded up to a power of 2.
+    explicit LoopbackPipe(size_t size);
+    ~LoopbackPipe();
+
+    /** Copy some, or all, of buf into the pipe.  Blocks while the pipe is full.
+     * @return number of bytes written, or -1 once closed.
+     */
+    int write(const char *buf, size_t count);
+    /** Copy up to count bytes out of the pipe.  Blocks while the pipe is empty.
+     * @param timeout Seconds to wait for data.  <=0 waits forever.
+     * @return number of bytes read, or -1 when closed (and empty) or after a timeout.
+     */
+    int read(char *buf, size_t count, double timeout);
+    //! Wake up, and fail, any blocked and future reader and writer.
+    void close();
+
+private:
+    std::vector<char> _ring;
+    const size_t _mask;
+    size_t _head; // total bytes written.  Only stored by the writer
+    size_t _tail; // total bytes read.  Only stored by the reader
+    int _closed;
+    epics::pvData::Event _readable, _writable;
+
+    EPICS_NOT_COPYABLE(LoopbackPipe)
+};
+
+/**
+ * What a BlockingTCPTransportCodec reads from and writes to.
+ * A connected TCP socket, or one end of an in-process loopback connection.
+ */
+struct CodecEndpoint {
+    SOCKET socket;
+    LoopbackPipe::shared_pointer rx, tx; //!< loopback only
+    osiSockAddr peer; //!< loopback only.  Reported by getRemoteAddress()
+
+    CodecEndpoint(SOCKET socket) :socket(socket) { memset(&peer, 0, sizeof(peer)); }
+    CodecEndpoint(const LoopbackPipe::shared_pointer& rx,
+                  const LoopbackPipe::shared_pointer& tx,
+                  const osiSockAddr& peer)
+        :socket(INVALID_SOCKET), rx(rx), tx(tx), peer(peer)
+    {}
+
+    bool isLoopback() const { return !!rx; }
+
+    /** Create the two ends of an in-process connection.
+     * @param serverAddress Remote address of the client end
+     * @param clientAddress Remote address of the server end.  Should be unique among connections to a server.
+     * @param size capacity of each direction in bytes
+     */
+    static void loopbackPair(CodecEndpoint& client, const osiSockAddr& serverAddress,
+                             CodecEndpoint& server, const osiSockAddr& clientAddress,
+                             size_t size);
+};
+
 class BlockingTCPTransportCodec:
     public AbstractCodec,
     public AuthenticationPluginControl,
@@ -278,7 +351,7 @@ public:
     BlockingTCPTransportCodec(
             bool serverFlag,
             Context::shared_pointer const & context,
-            SOCKET channel,
+            const CodecEndpoint& channel,
             ResponseHandler::shared_pointer const & responseHandler,
             size_t sendBufferSize,
             size_t receiveBufferSize,
@@ -386,6 +459,12 @@ public:
 
     virtual void verified(epics::pvData::Status const & status) OVERRIDE;
 
+    //! Has verified() been called with a successful status.  Does not wait.
+    bool isVerified() {
+        epicsGuard<epicsMutex> G(_mutex);
+        return _verified;
+    }
+
     virtual void authNZMessage(epics::pvData::PVStructure::shared_pointer const & data) OVERRIDE FINAL;
 
     virtual void sendSecurityPluginMessage(epics::pvData::PVStructure::const_shared_pointer const & data) OVERRIDE FINAL;
@@ -409,6 +488,9 @@ private:
     AtomicValue<bool> _isOpen;
     epics::pvData::Thread _readThread, _sendThread;
     const SOCKET _channel;
+    // set for an in-process connection, instead of _channel
+    const LoopbackPipe::shared_pointer _rxPipe, _txPipe;
+    double _rxTimeout; // loopback only.  cf. setRxTimeout()
 protected:
     osiSockAddr _socketAddress;
     std::string _socketName;
@@ -446,7 +528,7 @@ public:
 protected:
     BlockingServerTCPTransportCodec(
         Context::shared_pointer const & context,
-        SOCKET channel,
+        const CodecEndpoint& channel,
         ResponseHandler::shared_pointer const & responseHandler,
         int32_t sendBufferSize,
         int32_t receiveBufferSize );
@@ -454,7 +536,7 @@ protected:
 public:
     static shared_pointer create(
         Context::shared_pointer const & context,
-        SOCKET channel,
+        const CodecEndpoint& channel,
         ResponseHandler::shared_pointer const & responseHandler,
         int sendBufferSize,
         int receiveBufferSize)
@@ -493,17 +575,20 @@ public:
 
     size_t getChannelCount() const;
 
-    virtual bool verify(epics::pvData::int32 timeoutMs) OVERRIDE FINAL {
-
+    /**
+     * Queue the connection validation request to the client.
+     * Does not wait.  The reply (CMD_CONNECTION_VALIDATED) is queued
+     * by verified() once the client has answered and been authenticated.
+     */
+    void startVerify() {
         TransportSender::shared_pointer transportSender =
             std::tr1::dynamic_pointer_cast<TransportSender>(shared_from_this());
         enqueueSendRequest(transportSender);
+    }
 
-        bool verifiedStatus = BlockingTCPTransportCodec::verify(timeoutMs);
-
-        enqueueSendRequest(transportSender);
-
-        return verifiedStatus;
+    virtual bool verify(epics::pvData::int32 timeoutMs) OVERRIDE FINAL {
+        startVerify();
+        return BlockingTCPTransportCodec::verify(timeoutMs);
     }
 
     virtual void verified(epics::pvData::Status const & status) OVERRIDE FINAL {
@@ -512,6 +597,10 @@ public:
             _verificationStatus = status;
         }
         BlockingTCPTransportCodec::verified(status);
+
+        TransportSender::shared_pointer transportSender =
+            std::tr1::dynamic_pointer_cast<TransportSender>(shared_from_this());
+        enqueueSendRequest(transportSender);
     }
 
     void authNZInitialize(const std::string& securityPluginName,
@@ -564,7 +653,7 @@ public:
 protected:
     BlockingClientTCPTransportCodec(
         Context::shared_pointer const & context,
-        SOCKET channel,
+        const CodecEndpoint& channel,
         ResponseHandler::shared_pointer const & responseHandler,
         int32_t sendBufferSize,
         int32_t receiveBufferSize,
@@ -576,7 +665,7 @@ protected:
 public:
     static shared_pointer create(
         Context::shared_pointer const & context,
-        SOCKET channel,
+        const CodecEndpoint& channel,
         ResponseHandler::shared_pointer const & responseHandler,
         int32_t sendBufferSize,
         int32_t receiveBufferSize,
@@ -621,6 +710,30 @@ public:
                                          const std::tr1::shared_ptr<PeerInfo>& peer) OVERRIDE FINAL;
 
     virtual void verified(epics::pvData::Status const & status) OVERRIDE FINAL;
+
+    //! Notified when validation completes, successfully or not, or when the transport closes.
+    struct VerifyListener {
+        virtual ~VerifyListener() {}
+        virtual void verifyDone() =0;
+    };
+    /**
+     * Validation may already have completed before this call,
+     * so callers should check verify(0) after setting a listener.
+     */
+    void setVerifyListener(const std::tr1::weak_ptr<VerifyListener>& listener) {
+        epicsGuard<epicsMutex> G(_mutex);
+        _verifyListener = listener;
+    }
+
+    //! PVA_SERVER_FEATURE_* bits sent by the server during validation.  0 until then.
+    epics::pvData::int8 getServerFeatures() const {
+        epicsGuard<epicsMutex> G(_mutex);
+        return _serverFeatures;
+    }
+    void setServerFeatures(epics::pvData::int8 features) {
+        epicsGuard<epicsMutex> G(_mutex);
+        _serverFeatures = features;
+    }
 protected:
 
     virtual void internalClose() OVERRIDE FINAL;
@@ -644,6 +757,12 @@ private:
     // are we queued to send verify or echo?
     bool sendQueued;
 
+    // guarded by _mutex
+    epics::pvData::int8 _serverFeatures;
+    std::tr1::weak_ptr<VerifyListener> _verifyListener;
+
+    void notifyVerifyListener();
+
     /**
      * Notifies clients about disconnect.
      */
@@ -82,6 +82,20 @@ enum QoS {
     QOS_GET_PUT = 0x80
 };
 
+/** Flags of the subcommand byte of a CMD_MONITOR update (server to client).
+ *
+ * Separate from QoS as bits are reused.  QOS_REPLY_REQUIRED has no meaning for an update,
+ * so MONITOR_UPDATE_TRACE shares its value.
+ */
+enum MonitorUpdateFlags {
+    /**
+     * Update followed by a latency trace,
+     * only sent if requested with pvRequest option record._options.trace=true .
+     * int64 ID, then (uint32 seconds, uint32 nanoseconds) when posted and when sent.
+     */
+    MONITOR_UPDATE_TRACE = 0x01
+};
+
 enum ApplicationCommands {
     CMD_BEACON = 0,
     CMD_CONNECTION_VALIDATION = 1,
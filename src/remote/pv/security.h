@@ -306,6 +306,47 @@ public:
 epicsShareFunc
 void osdGetRoles(const std::string &account, PeerInfo::roles_t& roles);
 
+/** @brief Cache of role names, in front of a lookup function such as osdGetRoles().
+ *
+ * Concurrent lookups of the same account wait for one call of the lookup function.
+ * Once cached, roles of an account are returned without waiting.
+ * Results older than the timeout are returned while being refreshed by a worker thread.
+ * If a refresh fails, the account is forgotten, and the next lookup waits for a new call.
+ * A timeout of zero disables the cache.
+ */
+class epicsShareClass RolesCache
+{
+    EPICS_NOT_COPYABLE(RolesCache)
+public:
+    typedef void (*lookup_t)(const std::string &account, PeerInfo::roles_t& roles);
+
+    /**
+     * @param timeout Seconds after which cached roles are refreshed.  <=0 disables the cache.
+     * @param lookup Called to find the roles of an account.  May throw.
+     */
+    explicit RolesCache(double timeout, lookup_t lookup = &osdGetRoles);
+    ~RolesCache();
+
+    /**
+     * @param account User name
+     * @param roles Role names are added to this set.  Existing names are not removed.
+     */
+    void get(const std::string &account, PeerInfo::roles_t& roles);
+
+    struct Pvt;
+private:
+    const std::tr1::shared_ptr<Pvt> pvt;
+};
+
+/** @brief As osdGetRoles(), through a RolesCache with a timeout of $EPICS_PVAS_ROLES_CACHE_TMO seconds.
+ *
+ * The default, 0, disables the cache.
+ * @param account User name
+ * @param roles Role names are added to this set.  Existing names are not removed.
+ */
+epicsShareFunc
+void cachedGetRoles(const std::string &account, PeerInfo::roles_t& roles);
+
 }
 }
 
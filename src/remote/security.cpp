@@ -119,7 +119,7 @@ struct GroupsPlugin : public pva::AuthorizationPlugin
         if(!peer->identified)
             return; // no groups for anonymous
 
-        pva::osdGetRoles(peer->account, peer->roles);
+        pva::cachedGetRoles(peer->account, peer->roles);
     }
 };
 
@@ -7,6 +7,9 @@
 #include <iostream>
 #include <sstream>
 #include <memory>
+#include <algorithm>
+#include <vector>
+#include <map>
 #include <queue>
 #include <stdexcept>
 
@@ -36,6 +39,7 @@
 #include <pv/clientContextImpl.h>
 #include <pv/configuration.h>
 #include <pv/beaconHandler.h>
+#include <pv/nameCache.h>
 #include <pv/logger.h>
 #include <pv/securityImpl.h>
 
@@ -75,6 +79,69 @@ typedef std::map<pvAccessID, ResponseRequest::weak_pointer> IOIDResponseRequestM
 #define SEND_MESSAGE(WEAK, PTR, MSG, MTYPE) \
 do{requester_type::shared_pointer PTR((WEAK).lock()); if(PTR) (PTR)->message(MSG, MTYPE); }while(0)
 
+// replace array fields of root which are marked in changed (or whose parent is marked)
+// with storage from the application, which deserialization then fills in place.
+void allocateArrays(ArrayAllocator& alloc, PVStructure& root, const BitSet& changed, bool all)
+{
+    const PVFieldPtrArray& fields = root.getPVFields();
+    for(size_t i=0, N=fields.size(); i<N; i++) {
+        PVField *fld = fields[i].get();
+        const size_t offset = fld->getFieldOffset();
+        const bool marked = all || changed.get(offset);
+
+        switch(fld->getField()->getType()) {
+        case structure:
+            if(!marked) {
+                // skip unless some sub-field is marked
+                int32 next = changed.nextSetBit(offset);
+                if(next<0 || size_t(next)>=fld->getNextFieldOffset())
+                    break;
+            }
+            allocateArrays(alloc, static_cast<PVStructure&>(*fld), changed, marked);
+            break;
+        case scalarArray:
+            if(marked) {
+                PVScalarArray *arr = static_cast<PVScalarArray*>(fld);
+                shared_vector<void> storage(alloc.allocate(arr->getScalarArray()->getElementType(),
+                                                           arr->getLength()));
+                if(!storage.data())
+                    break; // default allocation
+                try {
+                    arr->putFrom(freeze(storage));
+                } catch(std::exception& e) {
+                    LOG(logLevelError, "Invalid storage from ArrayAllocator::allocate(): %s", e.what());
+                }
+            }
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+// The requester of an operation, if it is also an ArrayAllocator.
+// Looked up once, when the operation is created, not for each message.
+class ArrayAllocatorRef {
+    const std::tr1::weak_ptr<ArrayAllocator> m_alloc;
+    const bool m_present;
+public:
+    template<typename Requester>
+    explicit ArrayAllocatorRef(const std::tr1::shared_ptr<Requester>& requester)
+        :m_alloc(std::tr1::dynamic_pointer_cast<ArrayAllocator>(requester))
+        ,m_present(!m_alloc.expired())
+    {}
+
+    // use the allocator, if any, before deserializing into root.
+    void allocate(PVStructure& root, const BitSet& changed) const
+    {
+        if(!m_present)
+            return;
+        std::tr1::shared_ptr<ArrayAllocator> alloc(m_alloc.lock());
+        if(alloc)
+            allocateArrays(*alloc, root, changed, changed.get(0));
+    }
+};
+
 /**
  * Base channel request.
  * @author <a href="mailto:matej.sekoranjaATcosylab.com">Matej Sekoranja</a>
@@ -563,6 +630,7 @@ class ChannelGetImpl :
 {
 public:
     const ChannelGetRequester::weak_pointer m_callback;
+    const ArrayAllocatorRef m_allocator;
 
     const PVStructure::shared_pointer m_pvRequest;
 
@@ -576,6 +644,7 @@ public:
                    PVStructure::shared_pointer const & pvRequest) :
         BaseRequestImpl(channel),
         m_callback(requester),
+        m_allocator(requester),
         m_pvRequest(pvRequest)
     {
     }
@@ -659,6 +728,7 @@ public:
         {
             Lock lock(m_structureMutex);
             m_bitSet->deserialize(payloadBuffer, transport.get());
+            m_allocator.allocate(*m_structure, *m_bitSet);
             m_structure->deserialize(payloadBuffer, transport.get(), m_bitSet.get());
         }
 
@@ -985,6 +1055,7 @@ class ChannelPutGetImpl :
 {
 public:
     const ChannelPutGetRequester::weak_pointer m_callback;
+    const ArrayAllocatorRef m_allocator;
 
     const PVStructure::shared_pointer m_pvRequest;
 
@@ -1003,6 +1074,7 @@ public:
                       PVStructure::shared_pointer const & pvRequest) :
         BaseRequestImpl(channel),
         m_callback(requester),
+        m_allocator(requester),
         m_pvRequest(pvRequest)
     {
     }
@@ -1103,6 +1175,7 @@ public:
                 Lock lock(m_structureMutex);
                 // deserialize get data
                 m_getDataBitSet->deserialize(payloadBuffer, transport.get());
+                m_allocator.allocate(*m_getData, *m_getDataBitSet);
                 m_getData->deserialize(payloadBuffer, transport.get(), m_getDataBitSet.get());
             }
 
@@ -1137,6 +1210,7 @@ public:
                 Lock lock(m_structureMutex);
                 // deserialize data
                 m_getDataBitSet->deserialize(payloadBuffer, transport.get());
+                m_allocator.allocate(*m_getData, *m_getDataBitSet);
                 m_getData->deserialize(payloadBuffer, transport.get(), m_getDataBitSet.get());
             }
 
@@ -1806,7 +1880,8 @@ class MonitorStrategy : public Monitor {
 public:
     virtual ~MonitorStrategy() {};
     virtual void init(StructureConstPtr const & structure) = 0;
-    virtual void response(Transport::shared_pointer const & transport, ByteBuffer* payloadBuffer) = 0;
+    //! @param traced update is followed by a latency trace.  cf. MONITOR_UPDATE_TRACE
+    virtual void response(Transport::shared_pointer const & transport, ByteBuffer* payloadBuffer, bool traced) = 0;
     virtual void unlisten() = 0;
 };
 
@@ -1829,8 +1904,9 @@ private:
 
 
     const MonitorRequester::weak_pointer m_callback;
+    const ArrayAllocatorRef m_allocator;
 
-    Mutex m_mutex;
+    mutable Mutex m_mutex;
 
     BitSet m_bitSet1;
     BitSet m_bitSet2;
@@ -1851,6 +1927,21 @@ private:
 
     bool m_unlisten;
 
+    size_t m_noverrun;
+    size_t m_latency[Monitor::Stats::nlatency];
+
+    void deserializeTrace(Transport::shared_pointer const & transport, ByteBuffer* payloadBuffer,
+                          MonitorElement::Trace& trace)
+    {
+        transport->ensureData(24);
+        trace.id = payloadBuffer->getLong();
+        trace.posted.secPastEpoch = payloadBuffer->getInt();
+        trace.posted.nsec = payloadBuffer->getInt();
+        trace.sent.secPastEpoch = payloadBuffer->getInt();
+        trace.sent.nsec = payloadBuffer->getInt();
+        epicsTimeGetCurrent(&trace.received);
+    }
+
 public:
 
     MonitorStrategyQueue(ClientChannelImpl::shared_pointer channel, pvAccessID ioid,
@@ -1860,14 +1951,18 @@ public:
         m_queueSize(queueSize), m_lastStructure(),
         m_freeQueue(),
         m_monitorQueue(),
-        m_callback(callback), m_mutex(),
+        m_callback(callback), m_allocator(callback.lock()), m_mutex(),
         m_bitSet1(), m_bitSet2(), m_overrunInProgress(false),
         m_releasedCount(0),
         m_reportQueueStateInProgress(false),
         m_channel(channel), m_ioid(ioid),
         m_pipeline(pipeline), m_ackAny(ackAny),
-        m_unlisten(false)
+        m_unlisten(false),
+        m_noverrun(0u)
     {
+        for (size_t i = 0; i < Monitor::Stats::nlatency; i++)
+            m_latency[i] = 0u;
+
         if (queueSize <= 1)
             throw std::invalid_argument("queueSize <= 1");
 
@@ -1904,7 +1999,7 @@ public:
     }
 
 
-    virtual void response(Transport::shared_pointer const & transport, ByteBuffer* payloadBuffer) OVERRIDE FINAL {
+    virtual void response(Transport::shared_pointer const & transport, ByteBuffer* payloadBuffer, bool traced) OVERRIDE FINAL {
 
         {
             // TODO do not lock deserialization
@@ -1917,6 +2012,7 @@ public:
                 BitSet::shared_pointer overrunBitSet = m_overrunElement->overrunBitSet;
 
                 m_bitSet1.deserialize(payloadBuffer, transport.get());
+                m_allocator.allocate(*pvStructure, m_bitSet1);
                 pvStructure->deserialize(payloadBuffer, transport.get(), &m_bitSet1);
                 m_bitSet2.deserialize(payloadBuffer, transport.get());
 
@@ -1931,6 +2027,15 @@ public:
                 // OR remote overrun
                 *(overrunBitSet.get()) |= m_bitSet2;
 
+                // m_overrunElement keeps the trace of the oldest update.
+                // This update is never delivered on its own, so isn't counted in m_latency.
+                if (traced)
+                {
+                    transport->ensureData(24);
+                    payloadBuffer->setPosition(payloadBuffer->getPosition()+24);
+                }
+                m_noverrun++;
+
                 // m_up2datePVStructure is already set
 
                 return;
@@ -1956,9 +2061,16 @@ public:
                 assert(pvStructure->getStructure().get()==m_up2datePVStructure->getStructure().get());
                 pvStructure->copyUnchecked(*m_up2datePVStructure, *changedBitSet, true);
             }
+            m_allocator.allocate(*pvStructure, *changedBitSet);
             pvStructure->deserialize(payloadBuffer, transport.get(), changedBitSet.get());
             overrunBitSet->deserialize(payloadBuffer, transport.get());
 
+            if (traced) {
+                deserializeTrace(transport, payloadBuffer, newElement->trace);
+                m_latency[Monitor::Stats::latencyBucket(newElement->trace.latency())]++;
+            } else
+                newElement->trace = MonitorElement::Trace();
+
             m_up2datePVStructure = pvStructure;
 
             if (!m_overrunInProgress)
@@ -2102,6 +2214,16 @@ public:
     void destroy() OVERRIDE FINAL {
     }
 
+    virtual void getStats(Stats& s) const OVERRIDE FINAL {
+        Lock guard(m_mutex);
+        s.nfilled = m_monitorQueue.size();
+        s.nempty = m_freeQueue.size();
+        s.noutstanding = m_queueSize - s.nfilled - s.nempty;
+        s.noverrun = m_noverrun;
+        for (size_t i = 0; i < Monitor::Stats::nlatency; i++)
+            s.latency[i] = m_latency[i];
+    }
+
 };
 
 
@@ -2122,6 +2244,7 @@ public:
     int32 m_queueSize;
     bool m_pipeline;
     int32 m_ackAny;
+    bool m_trace;
 
     ChannelMonitorImpl(
         ClientChannelImpl::shared_pointer const & channel,
@@ -2134,7 +2257,8 @@ public:
         m_pvRequest(pvRequest),
         m_queueSize(2),
         m_pipeline(false),
-        m_ackAny(0)
+        m_ackAny(0),
+        m_trace(false)
     {
     }
 
@@ -2168,6 +2292,16 @@ public:
                 }
             }
 
+            // also passed to the server with the pvRequest
+            option = pvOptions->getSubField<PVScalar>("trace");
+            if (option) {
+                try {
+                    m_trace = option->getAs<epics::pvData::boolean>();
+                }catch(std::runtime_error& e){
+                    SEND_MESSAGE(m_callback, cb, "Invalid trace=", warningMessage);
+                }
+            }
+
             // pipeline options
             if (m_pipeline)
             {
@@ -2307,6 +2441,9 @@ public:
         int8 qos,
         const Status& /*status*/) OVERRIDE FINAL
     {
+        // only a server which understood our request sets MONITOR_UPDATE_TRACE
+        const bool traced = m_trace && (qos & MONITOR_UPDATE_TRACE);
+
         if (qos & QOS_GET)
         {
             // TODO not supported by IF yet...
@@ -2316,14 +2453,14 @@ public:
             // TODO for now status is ignored
 
             if (payloadBuffer->getRemaining())
-                m_monitorStrategy->response(transport, payloadBuffer);
+                m_monitorStrategy->response(transport, payloadBuffer, traced);
 
             // unlisten will be called when all the elements in the queue gets processed
             m_monitorStrategy->unlisten();
         }
         else
         {
-            m_monitorStrategy->response(transport, payloadBuffer);
+            m_monitorStrategy->response(transport, payloadBuffer, traced);
         }
     }
 
@@ -2447,6 +2584,14 @@ public:
         m_monitorStrategy->release(monitorElement);
     }
 
+    virtual void getStats(Stats& s) const OVERRIDE FINAL
+    {
+        if (m_monitorStrategy)
+            m_monitorStrategy->getStats(s);
+        else
+            Monitor::getStats(s);
+    }
+
 };
 
 
@@ -2589,14 +2734,17 @@ public:
 
         transport->ensureData(1);
         bool found = payloadBuffer->getByte() != 0;
-        if (!found)
-            return;
 
         // reads CIDs
         // TODO optimize
         ClientContextImpl::shared_pointer context(_context.lock());
         if(!context)
             return;
+
+        context->serverDetected(guid, serverAddress);
+
+        if (!found)
+            return;
         std::tr1::shared_ptr<epics::pvAccess::ChannelSearchManager> csm = context->getChannelSearchManager();
         int16 count = payloadBuffer->getShort();
         for (int i = 0; i < count; i++)
@@ -2750,6 +2898,8 @@ public:
         if (!context)
             return;
 
+        context->serverDetected(guid, serverAddress);
+
         std::tr1::shared_ptr<epics::pvAccess::BeaconHandler> beaconHandler = context->getBeaconHandler(responseFrom);
         // currently we care only for servers used by this context
         if (!beaconHandler)
@@ -2803,6 +2953,10 @@ public:
         //TODO: simplify byzantine class heirarchy...
         assert(cliTransport);
 
+        // optional server features
+        if (payloadBuffer->getRemaining() >= 1)
+            cliTransport->setServerFeatures(payloadBuffer->getByte());
+
         cliTransport->authNZInitialize(offeredSecurityPlugins);
     }
 };
@@ -3223,6 +3377,26 @@ private:
          */
         ServerGUID m_guid;
 
+        /**
+         * Waiting for BlockingTCPConnector to complete.
+         */
+        bool m_connectPending;
+
+        /**
+         * Name cache has been consulted (only before first connection).
+         */
+        bool m_nameCacheTried;
+
+        /**
+         * Create request in progress was sent to the server remembered in the name cache.
+         */
+        bool m_viaNameCache;
+
+        /**
+         * Server remembered in the name cache.
+         */
+        NameCache::Entry m_nameCacheEntry;
+
     public:
         static size_t num_instances;
         static size_t num_active;
@@ -3253,7 +3427,10 @@ private:
             m_needSubscriptionUpdate(false),
             m_allowCreation(true),
             m_serverChannelID(0xFFFFFFFF),
-            m_issueCreateMessage(true)
+            m_issueCreateMessage(true),
+            m_connectPending(false),
+            m_nameCacheTried(false),
+            m_viaNameCache(false)
         {
             REFTRACE_INCREMENT(num_instances);
         }
@@ -3462,6 +3639,12 @@ public:
             // Hack.  Prevent Transport from being dtor'd while m_channelMutex is held
             Transport::shared_pointer old_transport;
             Lock guard(m_channelMutex);
+
+            m_connectPending = false;
+
+            if (m_connectionState == DESTROYED)
+                return;
+
             // release transport if active
             if (m_transport)
             {
@@ -3469,6 +3652,17 @@ public:
                 old_transport.swap(m_transport);
             }
 
+            if (m_viaNameCache)
+            {
+                // remembered server is gone, or no longer has this channel.
+                // forget, and search without penalty
+                m_viaNameCache = false;
+                if (m_context->m_nameCache)
+                    m_context->m_nameCache->remove(m_name);
+                initiateSearch();
+                return;
+            }
+
             // ... and search again, with penalty
             initiateSearch(true);
         }
@@ -3498,6 +3692,11 @@ public:
 
                     m_addressIndex = 0; // reset
 
+                    if (m_viaNameCache)
+                        m_viaNameCache = false;
+                    else if (m_addresses.empty() && m_transport && m_context->m_nameCache)
+                        m_context->m_nameCache->update(m_name, m_guid, m_transport->getRemoteAddress());
+
                     // user might create monitors in listeners, so this has to be done before this can happen
                     // however, it would not be nice if events would come before connection event is fired
                     // but this cannot happen since transport (TCP) is serving in this thread
@@ -3564,6 +3763,7 @@ public:
         }
 
 #define STATIC_SEARCH_BASE_DELAY_SEC 5
+#define NAME_CACHE_SAVE_PERIOD_SEC 30.0
 #define STATIC_SEARCH_MAX_MULTIPLIER 10
 
         /**
@@ -3575,6 +3775,20 @@ public:
 
             m_allowCreation = true;
 
+            if (m_addresses.empty() && !m_nameCacheTried)
+            {
+                m_nameCacheTried = true;
+
+                if (m_context->m_nameCache && m_context->m_nameCache->lookup(m_name, m_nameCacheEntry))
+                {
+                    // skip search, and try the server remembered from a previous run.
+                    // connect from the timer thread, as with fixed addresses.
+                    m_viaNameCache = true;
+                    m_context->getTimer()->scheduleAfterDelay(internal_from_this(), 0.0);
+                    return;
+                }
+            }
+
             if (m_addresses.empty())
             {
                 m_context->getChannelSearchManager()->registerSearchInstance(internal_from_this(), penalize);
@@ -3587,6 +3801,22 @@ public:
         }
 
         virtual void callback() OVERRIDE FINAL {
+            if (m_addresses.empty())
+            {
+                // name cache hit
+                NameCache::Entry entry;
+                {
+                    Lock guard(m_channelMutex);
+                    if (m_connectionState == DESTROYED || !m_viaNameCache)
+                        return;
+                    entry = m_nameCacheEntry;
+                }
+
+                // NOTE: calls createChannelFailed() on failure, which falls back to search
+                searchResponse(entry.guid, PVA_CLIENT_PROTOCOL_REVISION, &entry.address);
+                return;
+            }
+
             // TODO cancellaction?!
             // TODO not in this timer thread !!!
             // TODO boost when a server (from address list) is started!!! IP vs address !!!
@@ -3606,9 +3836,6 @@ public:
         }
 
         virtual void searchResponse(const ServerGUID & guid, int8 minorRevision, osiSockAddr* serverAddress) OVERRIDE FINAL {
-            // Hack.  Prevent Transport from being dtor'd while m_channelMutex is held
-            Transport::shared_pointer old_transport;
-
             Lock guard(m_channelMutex);
             Transport::shared_pointer transport(m_transport);
             if (transport)
@@ -3626,25 +3853,38 @@ public:
                 return;
             }
 
-            // NOTE: this creates a new or acquires an existing transport (implies increases usage count)
-            transport = m_context->getTransport(internal_from_this(), serverAddress, minorRevision, m_priority);
-            if (!transport)
-            {
-                createChannelFailed();
+            // already waiting for a connection to some server
+            if (m_connectPending)
                 return;
-            }
-
 
             // remember GUID
             std::copy(guid.value, guid.value + 12, m_guid.value);
 
+            m_connectPending = true;
+
+            // NOTE: this creates a new or acquires an existing transport (implies increases usage count)
+            // completes with transportConnected() or createChannelFailed(), perhaps before returning.
+            m_context->connectTransport(internal_from_this(), serverAddress, minorRevision, m_priority);
+        }
+
+        virtual void transportConnected(Transport::shared_pointer const & newTransport) OVERRIDE FINAL {
+            // Hack.  Prevent Transport from being dtor'd while m_channelMutex is held
+            Transport::shared_pointer old_transport;
+            Transport::shared_pointer transport(newTransport);
+
             // create channel
             {
                 Lock guard(m_channelMutex);
 
+                m_connectPending = false;
+
                 // do not allow duplicate creation to the same transport
-                if (!m_allowCreation)
+                if (m_connectionState == DESTROYED || !m_allowCreation)
+                {
+                    if (transport != m_transport)
+                        transport->release(getID());
                     return;
+                }
                 m_allowCreation = false;
 
                 // check existing transport
@@ -3665,10 +3905,19 @@ public:
                 old_transport.swap(m_transport);
                 m_transport.swap(transport);
 
-                m_transport->enqueueSendRequest(internal_from_this());
+                m_context->queueCreateChannel(m_transport, internal_from_this());
             }
         }
 
+        /**
+         * Should a create request be sent through this transport.
+         */
+        bool wantsCreate(const Transport* transport)
+        {
+            Lock guard(m_channelMutex);
+            return m_connectionState != DESTROYED && m_issueCreateMessage && m_transport.get() == transport;
+        }
+
         virtual void transportClosed() OVERRIDE FINAL {
             disconnect(true, false);
 
@@ -3948,6 +4197,127 @@ public:
         }
     };
 
+    /**
+     * Create requests of channels waiting on one transport.
+     * Sent as few CMD_CREATE_CHANNEL messages as the server supports.
+     */
+    class ChannelCreateBatch :
+        public TransportSender
+    {
+    public:
+        POINTER_DEFINITIONS(ChannelCreateBatch);
+
+        //! Channels per message to servers with PVA_SERVER_FEATURE_MULTI_CREATE
+        static const size_t MAX_CHANNELS_PER_MESSAGE = 256u;
+
+        const InternalClientContextImpl::weak_pointer m_context;
+        const Transport::weak_pointer m_transport;
+        // guarded by InternalClientContextImpl::m_createBatchMutex
+        std::vector<InternalChannelImpl::weak_pointer> m_channels;
+
+        ChannelCreateBatch(const InternalClientContextImpl::shared_pointer& context,
+                           const Transport::shared_pointer& transport)
+            :m_context(context)
+            ,m_transport(transport)
+        {}
+        virtual ~ChannelCreateBatch() {}
+
+        virtual void send(ByteBuffer* buffer, TransportSendControl* control) OVERRIDE FINAL {
+            InternalClientContextImpl::shared_pointer context(m_context.lock());
+            Transport::shared_pointer transport(m_transport.lock());
+            if (!context || !transport)
+                return;
+
+            std::vector<InternalChannelImpl::weak_pointer> channels;
+            context->takeCreateChannels(this, channels);
+
+            std::vector<InternalChannelImpl::shared_pointer> todo;
+            todo.reserve(channels.size());
+            for (size_t i = 0; i < channels.size(); i++)
+            {
+                InternalChannelImpl::shared_pointer channel(channels[i].lock());
+                if (channel && channel->wantsCreate(transport.get()))
+                    todo.push_back(channel);
+            }
+
+            size_t perMessage = 1u;
+            detail::BlockingClientTCPTransportCodec* codec = dynamic_cast<detail::BlockingClientTCPTransportCodec*>(transport.get());
+            if (codec && (codec->getServerFeatures() & PVA_SERVER_FEATURE_MULTI_CREATE))
+                perMessage = MAX_CHANNELS_PER_MESSAGE;
+
+            for (size_t i = 0; i < todo.size(); )
+            {
+                const size_t count = std::min(todo.size() - i, perMessage);
+
+                control->startMessage((int8)CMD_CREATE_CHANNEL, 2+4);
+
+                // count
+                buffer->putShort((int16)count);
+                // array of CIDs and names
+                for (size_t n = 0; n < count; n++, i++)
+                {
+                    ClientChannelImpl* channel = todo[i].get();
+                    control->ensureBuffer(4);
+                    buffer->putInt(channel->getChannelID());
+                    SerializeHelper::serializeString(channel->getChannelName(), buffer, control);
+                }
+
+                control->endMessage();
+            }
+
+            // send immediately
+            if (!todo.empty())
+                control->flush(true);
+        }
+    };
+
+    /**
+     * Add the create request of a channel to the batch of its transport.
+     */
+    void queueCreateChannel(const Transport::shared_pointer& transport, const InternalChannelImpl::shared_pointer& channel)
+    {
+        ChannelCreateBatch::shared_pointer batch;
+        {
+            Lock guard(m_createBatchMutex);
+
+            // the channel is notified through transportClosed().
+            // checked with the lock held, so no entry is added after transportClosed(const Transport*) removes it.
+            if (transport->isClosed())
+                return;
+
+            // a batch is removed when sent, or when its transport closes
+            ChannelCreateBatch::shared_pointer& entry = m_createBatches[transport.get()];
+            if (entry && entry->m_transport.lock() == transport)
+            {
+                entry->m_channels.push_back(channel);
+                return;
+            }
+
+            entry.reset(new ChannelCreateBatch(internal_from_this(), transport));
+            entry->m_channels.push_back(channel);
+            batch = entry;
+        }
+
+        transport->enqueueSendRequest(batch);
+    }
+
+    virtual void transportClosed(const Transport* transport) OVERRIDE FINAL
+    {
+        Lock guard(m_createBatchMutex);
+        m_createBatches.erase(transport);
+    }
+
+    void takeCreateChannels(ChannelCreateBatch* batch, std::vector<InternalChannelImpl::weak_pointer>& channels)
+    {
+        Lock guard(m_createBatchMutex);
+
+        CreateBatchMap::iterator it(m_createBatches.find(batch->m_transport.lock().get()));
+        if (it != m_createBatches.end() && it->second.get() == batch)
+            m_createBatches.erase(it);
+
+        channels.swap(batch->m_channels);
+    }
+
 
 
 
@@ -3957,6 +4327,8 @@ public:
     InternalClientContextImpl(const Configuration::shared_pointer& conf) :
         m_addressList(""), m_autoAddressList(true), m_connectionTimeout(30.0f), m_beaconPeriod(15.0f),
         m_broadcastPort(PVA_BROADCAST_PORT), m_receiveBufferSize(MAX_TCP_RECV),
+        m_nameCacheFile(""),
+        m_loopback(false),
         m_lastCID(0x10203040),
         m_lastIOID(0x80706050),
         m_version("pvAccess Client", "cpp",
@@ -4021,6 +4393,12 @@ public:
         out << "BEACON_PERIOD      : " << m_beaconPeriod << std::endl;
         out << "BROADCAST_PORT     : " << m_broadcastPort << std::endl;;
         out << "RCV_BUFFER_SIZE    : " << m_receiveBufferSize << std::endl;
+        out << "LOOPBACK           : " << (m_loopback ? "true" : "false") << std::endl;
+        out << "NAME_CACHE         : ";
+        if (m_nameCache)
+            out << m_nameCache->getFileName() << " (" << m_nameCache->size() << " entries)" << std::endl;
+        else
+            out << "disabled" << std::endl;
         out << "STATE              : ";
         switch (m_contextState)
         {
@@ -4058,9 +4436,16 @@ public:
 
         m_channelSearchManager->cancel();
 
+        if (m_nameCache)
+            m_nameCache->save();
+
         // this will also close all PVA transports
         destroyAllChannels();
 
+        // abandon connections in progress
+        if (m_connector.get())
+            m_connector->close();
+
         // stop UDPs
         for (BlockingUDPTransportVector::const_iterator iter = m_udpTransports.begin();
                 iter != m_udpTransports.end(); iter++)
@@ -4113,6 +4498,8 @@ private:
         m_beaconPeriod = m_configuration->getPropertyAsFloat("EPICS_PVA_BEACON_PERIOD", m_beaconPeriod);
         m_broadcastPort = m_configuration->getPropertyAsInteger("EPICS_PVA_BROADCAST_PORT", m_broadcastPort);
         m_receiveBufferSize = m_configuration->getPropertyAsInteger("EPICS_PVA_MAX_ARRAY_BYTES", m_receiveBufferSize);
+        m_nameCacheFile = m_configuration->getPropertyAsString("EPICS_PVA_NAME_CACHE", m_nameCacheFile);
+        m_loopback = m_configuration->getPropertyAsBoolean("EPICS_PVA_LOOPBACK", m_loopback);
     }
 
     void internalInitialize() {
@@ -4121,13 +4508,22 @@ private:
         m_timer.reset(new Timer("pvAccess-client timer", lowPriority));
         InternalClientContextImpl::shared_pointer thisPointer(internal_from_this());
         // stores weak_ptr
-        m_connector.reset(new BlockingTCPConnector(thisPointer, m_receiveBufferSize, m_connectionTimeout));
+        m_connector.reset(new BlockingTCPConnector(thisPointer, m_receiveBufferSize, m_connectionTimeout, m_loopback));
 
         // stores many weak_ptr
         m_responseHandler.reset(new ClientResponseHandler(thisPointer));
 
         m_channelSearchManager.reset(new ChannelSearchManager(thisPointer));
 
+        if (!m_nameCacheFile.empty())
+        {
+            NameCache::shared_pointer cache(new NameCache(m_nameCacheFile));
+            cache->load();
+            // periodically save if modified
+            m_timer->schedulePeriodic(cache, NAME_CACHE_SAVE_PERIOD_SEC, NAME_CACHE_SAVE_PERIOD_SEC);
+            m_nameCache = cache;
+        }
+
         // TODO put memory barrier here... (if not already called within a lock?)
 
         // setup UDP transport
@@ -4336,6 +4732,12 @@ private:
             m_channelSearchManager->newServerDetected();
     }
 
+    virtual void serverDetected(ServerGUID const & guid, osiSockAddr const & serverAddress) OVERRIDE FINAL
+    {
+        if (m_nameCache)
+            m_nameCache->serverDetected(guid, serverAddress);
+    }
+
     /**
      * Get (and if necessary create) beacon handler.
      * @param protocol the protocol.
@@ -4360,22 +4762,13 @@ private:
 
     /**
      * Get, or create if necessary, transport of given server address.
+     * @param client channel to be notified on completion.
      * @param serverAddress    required transport address
      * @param priority process priority.
-     * @return transport for given address
      */
-    Transport::shared_pointer getTransport(ClientChannelImpl::shared_pointer const & client, osiSockAddr* serverAddress, int8 minorRevision, int16 priority) OVERRIDE FINAL
+    void connectTransport(ClientChannelImpl::shared_pointer const & client, const osiSockAddr* serverAddress, int8 minorRevision, int16 priority) OVERRIDE FINAL
     {
-        try
-        {
-            Transport::shared_pointer t = m_connector->connect(client, m_responseHandler, *serverAddress, minorRevision, priority);
-            return t;
-        }
-        catch (std::exception& e)
-        {
-            LOG(logLevelDebug, "getTransport() fails: %s", e.what());
-            return Transport::shared_pointer();
-        }
+        m_connector->connect(client, m_responseHandler, *serverAddress, minorRevision, priority);
     }
 
     /**
@@ -4451,6 +4844,21 @@ private:
      */
     int m_receiveBufferSize;
 
+    /**
+     * File in which to persist the name cache.  Empty to disable.
+     */
+    string m_nameCacheFile;
+
+    /**
+     * Connect to servers of this process without going through the network stack.
+     */
+    bool m_loopback;
+
+    /**
+     * Channel name to server cache.  NULL if disabled.
+     */
+    NameCache::shared_pointer m_nameCache;
+
     /**
      * Timer.
      */
@@ -4520,6 +4928,14 @@ private:
      */
     ChannelSearchManager::shared_pointer m_channelSearchManager;
 
+    /**
+     * Create requests not yet sent, per transport.
+     */
+    typedef std::map<const Transport*, ChannelCreateBatch::shared_pointer> CreateBatchMap;
+    CreateBatchMap m_createBatches;
+
+    Mutex m_createBatchMutex;
+
     /**
      * Beacon handler map.
      */
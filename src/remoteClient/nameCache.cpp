@@ -0,0 +1,253 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * pvAccessCPP is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+#include <stdio.h>
+#include <string.h>
+
+#include <osiSock.h>
+
+#define epicsExportSharedSymbols
+#include <pv/nameCache.h>
+#include <pv/logger.h>
+
+namespace pvd = epics::pvData;
+
+namespace {
+
+const char header[] = "# pvAccess client name cache v1";
+
+void guidToHex(const epics::pvAccess::ServerGUID& guid, std::ostream& strm)
+{
+    static const char hex[] = "0123456789abcdef";
+    for(size_t i=0; i<sizeof(guid.value); i++) {
+        unsigned char c = guid.value[i];
+        strm<<hex[c>>4]<<hex[c&0xf];
+    }
+}
+
+int hexDigit(char c)
+{
+    if(c>='0' && c<='9') return c-'0';
+    if(c>='a' && c<='f') return c-'a'+10;
+    if(c>='A' && c<='F') return c-'A'+10;
+    return -1;
+}
+
+bool hexToGUID(const std::string& hex, epics::pvAccess::ServerGUID& guid)
+{
+    if(hex.size()!=2u*sizeof(guid.value))
+        return false;
+    for(size_t i=0; i<sizeof(guid.value); i++) {
+        int hi = hexDigit(hex[2*i]), lo = hexDigit(hex[2*i+1]);
+        if(hi<0 || lo<0)
+            return false;
+        guid.value[i] = char((hi<<4)|lo);
+    }
+    return true;
+}
+
+} // namespace
+
+namespace epics {
+namespace pvAccess {
+
+NameCache::NameCache(const std::string& fileName)
+    :fileName(fileName)
+    ,dirty(false)
+{}
+
+NameCache::~NameCache() {}
+
+bool NameCache::lookup(const std::string& name, Entry& entry) const
+{
+    pvd::Lock G(mutex);
+    entries_t::const_iterator it(entries.find(name));
+    if(it==entries.end())
+        return false;
+    entry = it->second;
+    return true;
+}
+
+void NameCache::update(const std::string& name, const ServerGUID& guid, const osiSockAddr& address)
+{
+    pvd::Lock G(mutex);
+
+    servers_t::iterator sit(servers.find(address));
+    if(sit!=servers.end() && memcmp(sit->second.value, guid.value, sizeof(guid.value))!=0) {
+        // a different server now answers at this address
+        forgetServer(address);
+        sit = servers.end();
+    }
+
+    entries_t::iterator it(entries.find(name));
+    if(it==entries.end()) {
+        if(entries.size()>=MAX_ENTRIES)
+            return;
+        it = entries.insert(std::make_pair(name, Entry())).first;
+
+    } else if(sockAddrAreIdentical(&it->second.address, &address) &&
+              memcmp(it->second.guid.value, guid.value, sizeof(guid.value))==0) {
+        return; // no change
+    }
+
+    it->second.guid = guid;
+    it->second.address = address;
+    if(sit==servers.end())
+        servers[address] = guid;
+    dirty = true;
+}
+
+void NameCache::remove(const std::string& name)
+{
+    pvd::Lock G(mutex);
+    if(entries.erase(name))
+        dirty = true;
+}
+
+void NameCache::serverDetected(const ServerGUID& guid, const osiSockAddr& address)
+{
+    pvd::Lock G(mutex);
+
+    servers_t::iterator sit(servers.find(address));
+    if(sit==servers.end() || memcmp(sit->second.value, guid.value, sizeof(guid.value))==0)
+        return; // not a server we remember, or unchanged
+
+    forgetServer(address);
+}
+
+void NameCache::forgetServer(const osiSockAddr& address)
+{
+    // caller holds mutex
+    for(entries_t::iterator it(entries.begin()), end(entries.end()); it!=end;) {
+        if(sockAddrAreIdentical(&it->second.address, &address))
+            entries.erase(it++);
+        else
+            ++it;
+    }
+    servers.erase(address);
+    dirty = true;
+}
+
+size_t NameCache::size() const
+{
+    pvd::Lock G(mutex);
+    return entries.size();
+}
+
+bool NameCache::load()
+{
+    std::ifstream strm(fileName.c_str());
+    if(!strm.is_open())
+        return true; // nothing saved yet
+
+    entries_t newentries;
+    servers_t newservers;
+
+    std::string line;
+    while(std::getline(strm, line) && newentries.size()<MAX_ENTRIES) {
+        if(line.empty() || line[0]=='#')
+            continue;
+
+        // <guid hex> <ip:port> <channel name>
+        std::istringstream lstrm(line);
+        std::string guidhex, addr, name;
+        lstrm>>guidhex>>addr>>std::ws;
+        std::getline(lstrm, name);
+
+        Entry entry;
+        memset(&entry.address, 0, sizeof(entry.address));
+        if(name.empty() || !hexToGUID(guidhex, entry.guid)
+                || aToIPAddr(addr.c_str(), 0, &entry.address.ia)!=0
+                || entry.address.ia.sin_port==0) {
+            LOG(logLevelDebug, "Ignoring malformed name cache line in '%s': %s", fileName.c_str(), line.c_str());
+            continue;
+        }
+
+        // if the file has conflicting GUIDs for an address, the last wins
+        newservers[entry.address] = entry.guid;
+        newentries[name] = entry;
+    }
+
+    if(strm.bad()) {
+        LOG(logLevelWarn, "Error reading name cache '%s'", fileName.c_str());
+        return false;
+    }
+
+    // drop entries whose address was later given a different GUID
+    for(entries_t::iterator it(newentries.begin()), end(newentries.end()); it!=end;) {
+        if(memcmp(newservers[it->second.address].value, it->second.guid.value, sizeof(it->second.guid.value))!=0)
+            newentries.erase(it++);
+        else
+            ++it;
+    }
+
+    pvd::Lock G(mutex);
+    entries.swap(newentries);
+    servers.swap(newservers);
+    dirty = false;
+    return true;
+}
+
+bool NameCache::save()
+{
+    pvd::Lock S(saveMutex);
+
+    std::vector<std::pair<std::string, Entry> > copy;
+    {
+        pvd::Lock G(mutex);
+        copy.reserve(entries.size());
+        copy.assign(entries.begin(), entries.end());
+        dirty = false;
+    }
+
+    std::string tmpName(fileName + ".tmp");
+    bool ok;
+    {
+        std::ofstream strm(tmpName.c_str(), std::ios::out | std::ios::trunc);
+        strm<<header<<"\n";
+        for(size_t i=0; i<copy.size(); i++) {
+            guidToHex(copy[i].second.guid, strm);
+            strm<<' '<<inetAddressToString(copy[i].second.address)<<' '<<copy[i].first<<'\n';
+        }
+        strm.flush();
+        ok = strm.good();
+    }
+
+#ifdef _WIN32
+    // rename() will not replace an existing file
+    if(ok)
+        ::remove(fileName.c_str());
+#endif
+    if(ok && ::rename(tmpName.c_str(), fileName.c_str())!=0)
+        ok = false;
+
+    if(!ok) {
+        LOG(logLevelWarn, "Unable to write name cache '%s'", fileName.c_str());
+        ::remove(tmpName.c_str());
+        pvd::Lock G(mutex);
+        dirty = true; // try again later
+    }
+    return ok;
+}
+
+void NameCache::callback()
+{
+    {
+        pvd::Lock G(mutex);
+        if(!dirty)
+            return;
+    }
+    save();
+}
+
+void NameCache::timerStopped() {}
+
+}
+}
@@ -43,6 +43,8 @@ public:
     virtual pvAccessID getChannelID() = 0;
     virtual void connectionCompleted(pvAccessID sid/*,  rights*/) = 0;
     virtual void createChannelFailed() = 0;
+    //! Connection to server established and validated.  Already acquire()'d for this channel.
+    virtual void transportConnected(Transport::shared_pointer const & transport) = 0;
     virtual ClientContextImpl* getContext() = 0;
     virtual void channelDestroyedOnServer() = 0;
 
@@ -104,10 +106,24 @@ public:
     virtual ResponseRequest::shared_pointer unregisterResponseRequest(pvAccessID ioid) = 0;
 
 
-    virtual Transport::shared_pointer getTransport(ClientChannelImpl::shared_pointer const & client, osiSockAddr* serverAddress, epics::pvData::int8 minorRevision, epics::pvData::int16 priority) = 0;
+    /**
+     * Begin connecting to a server, or re-use an existing connection.  Does not block.
+     * Completion is reported through ClientChannelImpl::transportConnected() or ClientChannelImpl::createChannelFailed().
+     */
+    virtual void connectTransport(ClientChannelImpl::shared_pointer const & client, const osiSockAddr* serverAddress, epics::pvData::int8 minorRevision, epics::pvData::int16 priority) = 0;
 
     virtual void newServerDetected() = 0;
 
+    /**
+     * Called by a closing transport, after its channels have been notified.
+     */
+    virtual void transportClosed(const Transport* transport) = 0;
+
+    /**
+     * A server with the given GUID was seen (beacon or search response) at the given address.
+     */
+    virtual void serverDetected(ServerGUID const & guid, osiSockAddr const & serverAddress) = 0;
+
     virtual std::tr1::shared_ptr<BeaconHandler> getBeaconHandler(osiSockAddr* responseFrom) = 0;
 
     virtual void destroy() = 0;
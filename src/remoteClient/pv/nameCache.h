@@ -0,0 +1,131 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * pvAccessCPP is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#ifndef NAMECACHE_H
+#define NAMECACHE_H
+
+#include <map>
+#include <string>
+
+#ifdef epicsExportSharedSymbols
+#   define nameCacheEpicsExportSharedSymbols
+#   undef epicsExportSharedSymbols
+#endif
+
+#include <osiSock.h>
+
+#include <pv/noDefaultMethods.h>
+#include <pv/lock.h>
+#include <pv/sharedPtr.h>
+#include <pv/timer.h>
+
+#ifdef nameCacheEpicsExportSharedSymbols
+#   define epicsExportSharedSymbols
+#       undef nameCacheEpicsExportSharedSymbols
+#endif
+
+#include <pv/pvaDefs.h>
+#include <pv/inetAddressUtil.h>
+
+#include <shareLib.h>
+
+namespace epics {
+namespace pvAccess {
+
+/**
+ * Client side cache of channel name to server (GUID, address) mappings,
+ * persisted to a file so that a restarted client may connect directly
+ * to the server which last hosted a channel instead of searching for it.
+ *
+ * Entries are only hints.  A client must fall back to a search
+ * when the remembered server no longer hosts the channel.
+ * Entries for a server address are discarded when that address
+ * is seen with a different GUID (the server was restarted, or replaced).
+ *
+ * As a TimerCallback, periodically writes itself to file if modified.
+ */
+class epicsShareClass NameCache :
+    public epics::pvData::TimerCallback
+{
+public:
+    POINTER_DEFINITIONS(NameCache);
+
+    struct Entry {
+        ServerGUID guid;
+        osiSockAddr address;
+    };
+
+    //! Upper limit on the number of entries remembered.
+    static const size_t MAX_ENTRIES = 100000u;
+
+    /**
+     * @param fileName file to load from and save to.
+     */
+    explicit NameCache(const std::string& fileName);
+    virtual ~NameCache();
+
+    const std::string& getFileName() const { return fileName; }
+
+    /**
+     * Lookup the server which last hosted a channel.
+     * @return false if the name is unknown.
+     */
+    bool lookup(const std::string& name, Entry& entry) const;
+
+    //! Remember the server which is hosting a channel.
+    void update(const std::string& name, const ServerGUID& guid, const osiSockAddr& address);
+
+    //! Forget a channel, eg. after the remembered server denied it.
+    void remove(const std::string& name);
+
+    /**
+     * Notification that the server at an address has some GUID (from a beacon or search response).
+     * Forgets all channels remembered for this address with a different GUID.
+     */
+    void serverDetected(const ServerGUID& guid, const osiSockAddr& address);
+
+    size_t size() const;
+
+    /**
+     * Read entries from file, replacing any existing entries.
+     * A missing file is not an error.  Malformed lines are ignored.
+     * @return false if the file exists, but could not be read.
+     */
+    bool load();
+
+    /**
+     * Write all entries to file (through a temporary file and rename).
+     * @return false on error.
+     */
+    bool save();
+
+    virtual void callback() OVERRIDE FINAL;
+    virtual void timerStopped() OVERRIDE FINAL;
+
+private:
+    typedef std::map<std::string, Entry> entries_t;
+    typedef std::map<osiSockAddr, ServerGUID, comp_osiSock_lt> servers_t;
+
+    const std::string fileName;
+
+    mutable epics::pvData::Mutex mutex;
+    entries_t entries;
+    //! Last GUID seen for each server address
+    servers_t servers;
+    bool dirty;
+
+    //! serialize save()
+    epics::pvData::Mutex saveMutex;
+
+    void forgetServer(const osiSockAddr& address);
+
+    EPICS_NOT_COPYABLE(NameCache)
+};
+
+}
+}
+
+#endif // NAMECACHE_H
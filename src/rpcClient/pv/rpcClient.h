@@ -13,7 +13,9 @@
 #   define rpcClientEpicsExportSharedSymbols
 #   undef epicsExportSharedSymbols
 #endif
+#include <epicsEvent.h>
 #include <pv/pvData.h>
+#include <pv/lock.h>
 #include <pv/valueBuilder.h>
 #ifdef rpcClientEpicsExportSharedSymbols
 #   define epicsExportSharedSymbols
@@ -25,6 +27,7 @@
 #include <shareLib.h>
 
 #define RPCCLIENT_DEFAULT_TIMEOUT 5.0
+#define RPCCLIENT_DEFAULT_MAX_INFLIGHT 16
 
 namespace epics
 {
@@ -123,6 +126,100 @@ public:
      */
     epics::pvData::PVStructure::shared_pointer waitResponse(double timeout = RPCCLIENT_DEFAULT_TIMEOUT);
 
+private:
+    struct AsyncPool;
+public:
+
+    /**
+     * Completion notification for requestAsync().
+     * Called from a client worker thread, which should not be blocked.
+     */
+    struct epicsShareClass AsyncCallback {
+        POINTER_DEFINITIONS(AsyncCallback);
+        virtual ~AsyncCallback() {}
+        /**
+         * @param status   Success, or the reason for failure.
+         * @param response The result.  NULL on failure.
+         */
+        virtual void requestDone(const epics::pvData::Status& status,
+                                 epics::pvData::PVStructure::shared_pointer const & response) = 0;
+    };
+
+    /**
+     * Handle to one request issued by requestAsync().
+     */
+    class epicsShareClass AsyncResponse {
+        friend class RPCClient;
+        friend struct RPCClient::AsyncPool;
+    public:
+        POINTER_DEFINITIONS(AsyncResponse);
+        ~AsyncResponse() {}
+
+        //! Has the request completed (successfully or not)?
+        bool isDone() const;
+
+        /**
+         * Wait for the request to complete.
+         * @param timeout timeout in seconds to wait, 0 means forever.
+         * @returns false on timeout.
+         */
+        bool wait(double timeout = RPCCLIENT_DEFAULT_TIMEOUT);
+
+        /**
+         * Wait for the request to complete.
+         * @param timeout timeout in seconds to wait, 0 means forever.
+         * @return             request response.
+         * @throws RPCRequestException exception thrown on error or timeout.
+         */
+        epics::pvData::PVStructure::shared_pointer get(double timeout = RPCCLIENT_DEFAULT_TIMEOUT);
+
+        //! Completion status.  Meaningful once isDone()
+        epics::pvData::Status getStatus() const;
+
+    private:
+        AsyncResponse(epics::pvData::PVStructure::shared_pointer const & args,
+                      const AsyncCallback::shared_pointer& callback);
+        void complete(const epics::pvData::Status& status,
+                      epics::pvData::PVStructure::shared_pointer const & result);
+
+        mutable epics::pvData::Mutex mutex;
+        epicsEvent event;
+        bool done;
+        epics::pvData::Status status;
+        epics::pvData::PVStructure::shared_pointer args, result;
+        AsyncCallback::shared_pointer callback;
+
+        AsyncResponse(const AsyncResponse&);
+        AsyncResponse& operator=(const AsyncResponse&);
+    };
+
+    /**
+     * Issue a request and return immediately.
+     *
+     * Unlike issueRequest(), any number of requests may be outstanding.
+     * Up to getMaxInFlight() requests are in flight at once, each
+     * through its own ChannelRPC on the shared Channel.
+     * Additional requests are queued, and sent in order as earlier requests complete.
+     * Requests do not wait for connect() and are sent once the Channel connects.
+     *
+     * The pvArgument must not be modified until the request completes.
+     *
+     * @param pvArgument The argument to pass to the server.
+     * @param callback If not NULL, notified on completion.
+     * @returns A handle which may be used to wait for completion.
+     */
+    AsyncResponse::shared_pointer requestAsync(
+        epics::pvData::PVStructure::shared_pointer const & pvArgument,
+        const AsyncCallback::shared_pointer& callback = AsyncCallback::shared_pointer());
+
+    /**
+     * Set the maximum number of requestAsync() requests in flight.
+     * Default is RPCCLIENT_DEFAULT_MAX_INFLIGHT.
+     * Reducing the limit does not close ChannelRPCs already created.
+     */
+    void setMaxInFlight(size_t count);
+    size_t getMaxInFlight() const;
+
 private:
 
     const std::string m_serviceName;
@@ -134,6 +231,8 @@ private:
     struct RPCRequester;
     std::tr1::shared_ptr<RPCRequester> m_rpc_requester;
 
+    std::tr1::shared_ptr<AsyncPool> m_async;
+
     RPCClient(const RPCClient&);
     RPCClient& operator=(const RPCClient&);
 };
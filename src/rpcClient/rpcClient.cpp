@@ -6,6 +6,9 @@
 
 #include <iostream>
 #include <string>
+#include <deque>
+#include <vector>
+#include <algorithm>
 
 #include <epicsEvent.h>
 #include <pv/pvData.h>
@@ -115,6 +118,370 @@ struct RPCClient::RPCRequester : public pva::ChannelRPCRequester
 };
 
 
+RPCClient::AsyncResponse::AsyncResponse(pvd::PVStructure::shared_pointer const & args,
+                                        const AsyncCallback::shared_pointer& callback)
+    :done(false)
+    ,status(pvd::Status::error("No Data"))
+    ,args(args)
+    ,callback(callback)
+{}
+
+void RPCClient::AsyncResponse::complete(const pvd::Status& sts,
+                                        pvd::PVStructure::shared_pointer const & data)
+{
+    AsyncCallback::shared_pointer cb;
+    pvd::Status S(sts);
+    if(S.isSuccess() && !data)
+        S = pvd::Status::error("No reply data");
+    {
+        pvd::Lock L(mutex);
+        if(done)
+            return;
+        done = true;
+        status = S;
+        result = data;
+        args.reset();
+        cb.swap(callback);
+    }
+    event.signal();
+
+    if(cb) {
+        try {
+            cb->requestDone(S, data);
+        } catch(std::exception& e) {
+            LOG(logLevelError, "Unhandled exception in RPCClient::AsyncCallback::requestDone(): %s", e.what());
+        }
+    }
+}
+
+bool RPCClient::AsyncResponse::isDone() const
+{
+    pvd::Lock L(mutex);
+    return done;
+}
+
+bool RPCClient::AsyncResponse::wait(double timeout)
+{
+    pvd::Lock L(mutex);
+    while(!done) {
+        L.unlock();
+        bool ok;
+        if(timeout<=0.0) {
+            event.wait();
+            ok = true;
+        } else {
+            ok = event.wait(timeout);
+        }
+        L.lock();
+        if(!ok)
+            return done;
+    }
+    L.unlock();
+    event.signal(); // in case of more than one waiter
+    return true;
+}
+
+pvd::PVStructure::shared_pointer RPCClient::AsyncResponse::get(double timeout)
+{
+    if(!wait(timeout))
+        throw RPCRequestException(pvd::Status::STATUSTYPE_ERROR, "RPC timeout");
+
+    pvd::Lock L(mutex);
+    if(!status.isSuccess())
+        throw RPCRequestException(pvd::Status::STATUSTYPE_ERROR, status.getMessage());
+    return result;
+}
+
+pvd::Status RPCClient::AsyncResponse::getStatus() const
+{
+    pvd::Lock L(mutex);
+    return status;
+}
+
+/* Pool of ChannelRPC operations on one Channel, used by requestAsync().
+ * A ChannelRPC has at most one request in flight, so each in flight
+ * request gets its own operation.  Operations are created on demand,
+ * up to maxOps, and reused.
+ */
+struct RPCClient::AsyncPool : public std::tr1::enable_shared_from_this<AsyncPool>
+{
+    POINTER_DEFINITIONS(AsyncPool);
+
+    struct Op : public pva::ChannelRPCRequester,
+                public std::tr1::enable_shared_from_this<Op>
+    {
+        POINTER_DEFINITIONS(Op);
+
+        const AsyncPool::weak_pointer pool;
+
+        // guarded by AsyncPool::mutex
+        ChannelRPC::shared_pointer rpc;
+        AsyncResponse::shared_pointer current;
+        bool connected,
+             sent,    // current has been passed to rpc->request()
+             issuing; // in AsyncPool::issue()
+
+        explicit Op(const AsyncPool::shared_pointer& pool)
+            :pool(pool)
+            ,connected(false)
+            ,sent(false)
+            ,issuing(false)
+        {}
+        virtual ~Op() {}
+
+        virtual std::string getRequesterName() OVERRIDE FINAL { return "RPCClient::AsyncPool::Op"; }
+
+        virtual void channelRPCConnect(
+            const pvd::Status& status,
+            ChannelRPC::shared_pointer const & operation) OVERRIDE FINAL
+        {
+            AsyncPool::shared_pointer P(pool.lock());
+            if(P)
+                P->opConnect(shared_from_this(), status, operation);
+        }
+
+        virtual void requestDone(
+            const pvd::Status& status,
+            ChannelRPC::shared_pointer const & operation,
+            pvd::PVStructure::shared_pointer const & pvResponse) OVERRIDE FINAL
+        {
+            AsyncPool::shared_pointer P(pool.lock());
+            if(P)
+                P->opDone(shared_from_this(), status, pvResponse);
+        }
+
+        virtual void channelDisconnect(bool destroy) OVERRIDE FINAL
+        {
+            AsyncPool::shared_pointer P(pool.lock());
+            if(P)
+                P->opDisconnect(shared_from_this(), destroy);
+        }
+    };
+
+    typedef std::vector<Op::shared_pointer> ops_t;
+    typedef std::deque<AsyncResponse::shared_pointer> pending_t;
+
+    const Channel::shared_pointer channel;
+    const pvd::PVStructure::shared_pointer pvRequest;
+
+    mutable pvd::Mutex mutex;
+    size_t maxOps;
+    ops_t ops;  // all operations
+    ops_t idle; // connected operations without a request
+    pending_t pending; // requests waiting for an operation
+    bool destroyed;
+
+    AsyncPool(const Channel::shared_pointer& channel,
+              const pvd::PVStructure::shared_pointer& pvRequest)
+        :channel(channel)
+        ,pvRequest(pvRequest)
+        ,maxOps(RPCCLIENT_DEFAULT_MAX_INFLIGHT)
+        ,destroyed(false)
+    {}
+
+    static void remove(ops_t& list, const Op::shared_pointer& op)
+    {
+        ops_t::iterator it(std::find(list.begin(), list.end(), op));
+        if(it!=list.end())
+            list.erase(it);
+    }
+
+    void request(const AsyncResponse::shared_pointer& resp)
+    {
+        Op::shared_pointer op;
+        bool create = false;
+        {
+            pvd::Lock L(mutex);
+            if(destroyed) {
+                L.unlock();
+                resp->complete(pvd::Status::error("RPCClient destroyed"), pvd::PVStructure::shared_pointer());
+                return;
+
+            } else if(!idle.empty()) {
+                op = idle.back();
+                idle.pop_back();
+                op->current = resp;
+                op->sent = false;
+
+            } else {
+                pending.push_back(resp);
+                if(ops.size() < maxOps) {
+                    create = true;
+                    op.reset(new Op(shared_from_this()));
+                    ops.push_back(op);
+                }
+            }
+        }
+
+        if(create) {
+            // picks up a pending request once connected
+            ChannelRPC::shared_pointer rpc(channel->createChannelRPC(op, pvRequest));
+            if(!rpc) {
+                opConnect(op, pvd::Status::error("createChannelRPC() fails"), rpc);
+            } else {
+                pvd::Lock L(mutex);
+                if(!op->rpc)
+                    op->rpc = rpc;
+            }
+
+        } else if(op) {
+            issue(op);
+        }
+    }
+
+    // send op->current, and any request assigned while doing so.
+    void issue(const Op::shared_pointer& op)
+    {
+        pvd::Lock L(mutex);
+        if(op->issuing)
+            return; // called from requestDone() from rpc->request() below.  Our caller will send.
+        op->issuing = true;
+        while(op->current && !op->sent && op->rpc) {
+            AsyncResponse::shared_pointer resp(op->current);
+            ChannelRPC::shared_pointer rpc(op->rpc);
+            op->sent = true;
+
+            pvd::PVStructure::shared_pointer args;
+            {
+                pvd::Lock R(resp->mutex);
+                args = resp->args;
+            }
+            L.unlock();
+            rpc->request(args);
+            L.lock();
+        }
+        op->issuing = false;
+    }
+
+    void opConnect(const Op::shared_pointer& op,
+                   const pvd::Status& status,
+                   ChannelRPC::shared_pointer const & operation)
+    {
+        pending_t failed;
+        {
+            pvd::Lock L(mutex);
+            if(destroyed)
+                return;
+
+            if(operation)
+                op->rpc = operation;
+
+            if(!status.isSuccess()) {
+                // the server will likely refuse our other operations as well
+                remove(ops, op);
+                remove(idle, op);
+                if(op->current)
+                    failed.push_back(op->current);
+                op->current.reset();
+                failed.insert(failed.end(), pending.begin(), pending.end());
+                pending.clear();
+
+            } else {
+                op->connected = true;
+                op->sent = false;
+                if(!op->current && !pending.empty()) {
+                    op->current = pending.front();
+                    pending.pop_front();
+                }
+                if(!op->current && std::find(idle.begin(), idle.end(), op)==idle.end())
+                    idle.push_back(op);
+            }
+        }
+
+        if(status.isSuccess()) {
+            issue(op);
+        } else {
+            if(operation)
+                operation->destroy();
+            for(pending_t::const_iterator it(failed.begin()), end(failed.end()); it!=end; ++it)
+                (*it)->complete(status, pvd::PVStructure::shared_pointer());
+        }
+    }
+
+    void opDone(const Op::shared_pointer& op,
+                const pvd::Status& status,
+                pvd::PVStructure::shared_pointer const & pvResponse)
+    {
+        AsyncResponse::shared_pointer resp;
+        bool next = false;
+        {
+            pvd::Lock L(mutex);
+            if(!op->current) {
+                std::cerr<<"pva provider give RPC requestDone() when no request in progress\n";
+                return;
+            }
+            resp.swap(op->current);
+            op->sent = false;
+
+            if(destroyed || !op->connected) {
+                // nothing more to do
+            } else if(!pending.empty()) {
+                op->current = pending.front();
+                pending.pop_front();
+                next = true;
+            } else {
+                idle.push_back(op);
+            }
+        }
+
+        if(next)
+            issue(op);
+
+        // each response is deserialized into a new PVStructure, so is not changed by reuse of op
+        resp->complete(status, pvResponse);
+    }
+
+    void opDisconnect(const Op::shared_pointer& op, bool destroy)
+    {
+        AsyncResponse::shared_pointer resp;
+        {
+            pvd::Lock L(mutex);
+            op->connected = false;
+            op->sent = false;
+            resp.swap(op->current);
+            remove(idle, op);
+            if(destroy)
+                remove(ops, op);
+        }
+        if(resp)
+            resp->complete(pvd::Status::error("Connection lost"), pvd::PVStructure::shared_pointer());
+    }
+
+    void destroy()
+    {
+        ops_t temp;
+        pending_t failed;
+        {
+            pvd::Lock L(mutex);
+            if(destroyed)
+                return;
+            destroyed = true;
+            temp.swap(ops);
+            idle.clear();
+            failed.swap(pending);
+            for(ops_t::const_iterator it(temp.begin()), end(temp.end()); it!=end; ++it) {
+                if((*it)->current)
+                    failed.push_back((*it)->current);
+                (*it)->current.reset();
+            }
+        }
+
+        for(ops_t::const_iterator it(temp.begin()), end(temp.end()); it!=end; ++it) {
+            ChannelRPC::shared_pointer rpc;
+            {
+                pvd::Lock L(mutex);
+                rpc.swap((*it)->rpc);
+            }
+            if(rpc)
+                rpc->destroy();
+        }
+
+        for(pending_t::const_iterator it(failed.begin()), end(failed.end()); it!=end; ++it)
+            (*it)->complete(pvd::Status::error("RPCClient destroyed"), pvd::PVStructure::shared_pointer());
+    }
+};
+
+
 RPCClient::RPCClient(const std::string & serviceName,
                      pvd::PVStructure::shared_pointer const & pvRequest,
                      const ChannelProvider::shared_pointer &provider,
@@ -140,10 +507,17 @@ RPCClient::RPCClient(const std::string & serviceName,
     m_rpc = m_channel->createChannelRPC(m_rpc_requester, m_pvRequest);
     if(!m_rpc)
         throw std::logic_error("channel createChannelRPC() NULL");
+
+    m_async.reset(new AsyncPool(m_channel, m_pvRequest));
 }
 
 void RPCClient::destroy()
 {
+    if (m_async)
+    {
+        m_async->destroy();
+        m_async.reset();
+    }
     if (m_channel)
     {
         m_channel->destroy();
@@ -263,6 +637,34 @@ pvd::PVStructure::shared_pointer RPCClient::waitResponse(double timeout)
     return ret;
 }
 
+RPCClient::AsyncResponse::shared_pointer RPCClient::requestAsync(
+    pvd::PVStructure::shared_pointer const & pvArgument,
+    const AsyncCallback::shared_pointer& callback)
+{
+    if(!m_async)
+        throw std::logic_error("RPCClient destroyed");
+
+    AsyncResponse::shared_pointer ret(new AsyncResponse(pvArgument, callback));
+    m_async->request(ret);
+    return ret;
+}
+
+void RPCClient::setMaxInFlight(size_t count)
+{
+    if(!m_async)
+        return;
+    pvd::Lock L(m_async->mutex);
+    m_async->maxOps = count ? count : 1u;
+}
+
+size_t RPCClient::getMaxInFlight() const
+{
+    if(!m_async)
+        return 0u;
+    pvd::Lock L(m_async->mutex);
+    return m_async->maxOps;
+}
+
 RPCClient::shared_pointer RPCClient::create(const std::string & serviceName,
         pvd::PVStructure::shared_pointer const & pvRequest)
 {
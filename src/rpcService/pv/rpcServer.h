@@ -12,6 +12,9 @@
 #   undef epicsExportSharedSymbols
 #endif
 
+#include <vector>
+#include <string>
+
 #include <pv/sharedPtr.h>
 
 #ifdef rpcServerEpicsExportSharedSymbols
@@ -31,7 +34,13 @@ namespace pvAccess {
 class ServerContext;
 class RPCChannelProvider;
 
-//! Serves (only) RPCServiceAsync and RPCService instances.
+/** Serves (only) RPCServiceAsync and RPCService instances.
+ *
+ * By default, RPCServiceAsync::request() is called from the server thread
+ * which received the request.  A synchronous RPCService then delays all other
+ * requests received by that thread.  With a pool of workers, services are
+ * instead called from a worker, and several requests proceed concurrently.
+ */
 class epicsShareClass RPCServer :
     public std::tr1::enable_shared_from_this<RPCServer>
 {
@@ -43,12 +52,33 @@ private:
 public:
     POINTER_DEFINITIONS(RPCServer);
 
-    explicit RPCServer(const Configuration::const_shared_pointer& conf = Configuration::const_shared_pointer());
+    /**
+     * @param conf Server configuration, or NULL to use environment variables.
+     * @param nworkers Number of worker threads which call services.
+     *                 0 to call from the thread which received the request.
+     */
+    explicit RPCServer(const Configuration::const_shared_pointer& conf = Configuration::const_shared_pointer(),
+                       size_t nworkers = 0u);
 
     virtual ~RPCServer();
 
+    //! Limits applied to the requests to one registered service.
+    struct ServiceLimits {
+        //! Maximum number of requests in progress at once.  0 for no limit.
+        size_t maxConcurrent;
+        /** Maximum number of requests waiting when maxConcurrent are already in progress.
+         *  Further requests are rejected immediately with an error.
+         */
+        size_t maxQueued;
+        ServiceLimits() :maxConcurrent(0u), maxQueued(0u) {}
+        ServiceLimits(size_t maxConcurrent, size_t maxQueued) :maxConcurrent(maxConcurrent), maxQueued(maxQueued) {}
+    };
+
     void registerService(std::string const & serviceName, RPCServiceAsync::shared_pointer const & service);
 
+    void registerService(std::string const & serviceName, RPCServiceAsync::shared_pointer const & service,
+                         const ServiceLimits& limits);
+
     void unregisterService(std::string const & serviceName);
 
     void run(int seconds = 0);
@@ -60,10 +90,27 @@ public:
     void destroy();
 
     /**
-     * Display basic information about the context.
+     * Display basic information about the context, and service statistics.
      */
     void printInfo();
 
+    struct ServiceStats {
+        std::string name;
+        //! requests completed
+        size_t completed;
+        //! requests rejected because the queue was full
+        size_t rejected;
+        //! requests in progress, and waiting
+        size_t active, queued;
+        /** Time from request received to response, in seconds.
+         *  Estimated from a histogram, so these are upper bounds within a factor of 2.
+         */
+        double p50, p90, p99, max;
+    };
+
+    //! Snapshot of statistics for each registered service.
+    void getStats(std::vector<ServiceStats>& stats) const;
+
     const std::tr1::shared_ptr<ServerContext>& getServer() const { return m_serverContext; }
 };
 
@@ -5,12 +5,20 @@
  */
 
 #include <stdexcept>
+#include <algorithm>
 #include <vector>
+#include <deque>
 #include <utility>
+#include <iostream>
+
+#include <math.h>
+
+#include <epicsTime.h>
 
 #define epicsExportSharedSymbols
 #include <pv/rpcServer.h>
 #include <pv/serverContextImpl.h>
+#include <pv/serverExecutor.h>
 #include <pv/wildcard.h>
 
 using namespace epics::pvData;
@@ -19,6 +27,147 @@ using std::string;
 namespace epics {
 namespace pvAccess {
 
+class ChannelRPCServiceImpl;
+
+/* A registered service, with its limits and statistics.
+ * Shared by all channels (and ChannelRPCs) of the service.
+ */
+struct RPCServiceState
+{
+    POINTER_DEFINITIONS(RPCServiceState);
+
+    // latency histogram.  Bucket i counts times < 2^i microseconds,
+    // and >= 2^(i-1).  The last also counts all longer times.
+    enum { NBUCKETS = 32 };
+
+    const std::string name;
+    const RPCServiceAsync::shared_pointer service;
+    const RPCServer::ServiceLimits limits;
+
+    typedef std::pair<std::tr1::shared_ptr<ChannelRPCServiceImpl>, PVStructure::shared_pointer> pending_t;
+
+    mutable Mutex mutex;
+    size_t active, completed, rejected;
+    // waiting for a slot
+    std::deque<pending_t> waiting;
+    // given a slot, waiting for dispatchReady()
+    std::deque<pending_t> ready;
+    // dispatchReady() in progress
+    bool dispatching;
+    size_t histogram[NBUCKETS];
+    double maxLatency;
+
+    RPCServiceState(const std::string& name,
+                    const RPCServiceAsync::shared_pointer& service,
+                    const RPCServer::ServiceLimits& limits)
+        :name(name)
+        ,service(service)
+        ,limits(limits)
+        ,active(0u), completed(0u), rejected(0u)
+        ,dispatching(false)
+        ,maxLatency(0.0)
+    {
+        for(size_t i=0u; i<NBUCKETS; i++)
+            histogram[i] = 0u;
+    }
+
+    enum admit_t {
+        Run,    // call service now
+        Queued, // will be run when an active request completes
+        Reject  // too many requests waiting
+    };
+
+    admit_t admit(const std::tr1::shared_ptr<ChannelRPCServiceImpl>& op,
+                  const PVStructure::shared_pointer& arg)
+    {
+        Lock G(mutex);
+        if(limits.maxConcurrent==0u || active < limits.maxConcurrent) {
+            active++;
+            return Run;
+        } else if(waiting.size() < limits.maxQueued) {
+            waiting.push_back(std::make_pair(op, arg));
+            return Queued;
+        } else {
+            rejected++;
+            return Reject;
+        }
+    }
+
+    // caller holds mutex
+    void releaseSlot()
+    {
+        if(waiting.empty()) {
+            active--;
+        } else {
+            // hand our slot to the next waiting
+            ready.push_back(waiting.front());
+            waiting.pop_front();
+        }
+    }
+
+    /* Account for a completed request.
+     * The caller must then dispatchReady().
+     */
+    void complete(double latency)
+    {
+        size_t usec = size_t(latency*1e6);
+        size_t bucket = 0u;
+        while(usec && bucket<NBUCKETS-1u) {
+            usec >>= 1u;
+            bucket++;
+        }
+
+        Lock G(mutex);
+        completed++;
+        histogram[bucket]++;
+        if(maxLatency < latency)
+            maxLatency = latency;
+
+        releaseSlot();
+    }
+
+    void dispatchReady();
+
+    // caller holds mutex
+    double percentile(double fraction) const
+    {
+        size_t target = size_t(ceil(fraction*completed)), total = 0u;
+        for(size_t i=0u; i<NBUCKETS; i++) {
+            total += histogram[i];
+            if(total && total >= target)
+                return std::min(ldexp(1e-6, int(i)), maxLatency);
+        }
+        return maxLatency;
+    }
+
+    void getStats(RPCServer::ServiceStats& stats) const
+    {
+        Lock G(mutex);
+        stats.name = name;
+        stats.completed = completed;
+        stats.rejected = rejected;
+        stats.active = active;
+        stats.queued = waiting.size() + ready.size();
+        stats.p50 = percentile(0.50);
+        stats.p90 = percentile(0.90);
+        stats.p99 = percentile(0.99);
+        stats.max = maxLatency;
+    }
+};
+
+namespace {
+struct RPCWork : public ServerExecutor::Work
+{
+    const std::tr1::shared_ptr<ChannelRPCServiceImpl> op;
+    const PVStructure::shared_pointer arg;
+    RPCWork(const std::tr1::shared_ptr<ChannelRPCServiceImpl>& op, const PVStructure::shared_pointer& arg)
+        :op(op), arg(arg) {}
+    virtual ~RPCWork() {}
+    virtual void run() OVERRIDE FINAL;
+};
+
+const Status serviceBusyStatus(Status::STATUSTYPE_ERROR, "RPC service busy");
+} // namespace
 
 class ChannelRPCServiceImpl :
     public ChannelRPC,
@@ -30,17 +179,31 @@ private:
     ChannelRPCRequester::shared_pointer m_channelRPCRequester;
     RPCServiceAsync::shared_pointer m_rpcService;
     AtomicBoolean m_lastRequest;
+    AtomicBoolean m_destroyed;
+
+    const RPCServiceState::shared_pointer m_state;
+    // NULL to call service from the thread calling request()
+    const ServerExecutor::shared_pointer m_executor;
+    const ServerExecutor::Strand::shared_pointer m_strand;
+    // time of the request() in progress
+    epicsTimeStamp m_start;
 
 public:
     ChannelRPCServiceImpl(
         Channel::shared_pointer const & channel,
         ChannelRPCRequester::shared_pointer const & channelRPCRequester,
-        RPCServiceAsync::shared_pointer const & rpcService) :
+        RPCServiceState::shared_pointer const & state,
+        ServerExecutor::shared_pointer const & executor) :
         m_channel(channel),
         m_channelRPCRequester(channelRPCRequester),
-        m_rpcService(rpcService),
-        m_lastRequest()
+        m_rpcService(state->service),
+        m_lastRequest(),
+        m_destroyed(),
+        m_state(state),
+        m_executor(executor),
+        m_strand(executor ? new ServerExecutor::Strand : 0)
     {
+        epicsTimeGetCurrent(&m_start);
     }
 
     virtual ~ChannelRPCServiceImpl()
@@ -53,13 +216,51 @@ public:
         epics::pvData::PVStructure::shared_pointer const & result
     )
     {
+        epicsTimeStamp now;
+        epicsTimeGetCurrent(&now);
+        m_state->complete(epicsTimeDiffInSeconds(&now, &m_start));
+
         m_channelRPCRequester->requestDone(status, shared_from_this(), result);
 
         if (m_lastRequest.get())
             destroy();
+
+        m_state->dispatchReady();
     }
 
     virtual void request(epics::pvData::PVStructure::shared_pointer const & pvArgument)
+    {
+        epicsTimeGetCurrent(&m_start);
+
+        switch(m_state->admit(shared_from_this(), pvArgument)) {
+        case RPCServiceState::Run:
+            dispatch(pvArgument);
+            break;
+        case RPCServiceState::Queued:
+            break; // dispatch()'d after the requestDone() of an earlier request
+        case RPCServiceState::Reject:
+            m_channelRPCRequester->requestDone(serviceBusyStatus, shared_from_this(), PVStructure::shared_pointer());
+
+            if (m_lastRequest.get())
+                destroy();
+            break;
+        }
+    }
+
+    void dispatch(epics::pvData::PVStructure::shared_pointer const & pvArgument)
+    {
+        if (m_executor)
+        {
+            ServerExecutor::Work::shared_pointer work(new RPCWork(shared_from_this(), pvArgument));
+            m_executor->execute(m_strand, work);
+        }
+        else
+        {
+            invoke(pvArgument);
+        }
+    }
+
+    void invoke(epics::pvData::PVStructure::shared_pointer const & pvArgument)
     {
         try
         {
@@ -70,10 +271,7 @@ public:
             // handle user unexpected errors
             Status errorStatus(Status::STATUSTYPE_FATAL, ex.what());
 
-            m_channelRPCRequester->requestDone(errorStatus, shared_from_this(), PVStructure::shared_pointer());
-
-            if (m_lastRequest.get())
-                destroy();
+            requestDone(errorStatus, PVStructure::shared_pointer());
         }
         catch (...)
         {
@@ -81,10 +279,7 @@ public:
             Status errorStatus(Status::STATUSTYPE_FATAL,
                                "Unexpected exception caught while calling RPCServiceAsync.request(PVStructure, RPCResponseCallback).");
 
-            m_channelRPCRequester->requestDone(errorStatus, shared_from_this(), PVStructure::shared_pointer());
-
-            if (m_lastRequest.get())
-                destroy();
+            requestDone(errorStatus, PVStructure::shared_pointer());
         }
 
         // we wait for callback to be called
@@ -107,11 +302,58 @@ public:
 
     virtual void destroy()
     {
-        // noop
+        m_destroyed.set();
+    }
+
+    //! True once this operation, or its channel, is destroyed
+    bool isDestroyed()
+    {
+        return m_destroyed.get() || m_channel->getConnectionState()==Channel::DESTROYED;
     }
 };
 
+void RPCWork::run()
+{
+    op->invoke(arg);
+}
 
+/* Dispatch requests which have been given a slot.
+ *
+ * When a service completes synchronously, dispatch() leads back here
+ * through requestDone().  That nested call returns immediately, and
+ * this loop picks up the request it would have dispatched, so a
+ * long queue does not become a deep recursion.
+ */
+void RPCServiceState::dispatchReady()
+{
+    Lock G(mutex);
+    if(dispatching)
+        return;
+    dispatching = true;
+
+    while(!ready.empty()) {
+        pending_t next(ready.front());
+        ready.pop_front();
+
+        if(next.first->isDestroyed()) {
+            // no one to reply to
+            releaseSlot();
+            continue;
+        }
+
+        G.unlock();
+        try {
+            next.first->dispatch(next.second);
+        } catch(...) {
+            G.lock();
+            dispatching = false;
+            throw;
+        }
+        G.lock();
+    }
+
+    dispatching = false;
+}
 
 
 class RPCChannel :
@@ -126,7 +368,8 @@ private:
     string m_channelName;
     ChannelRequester::shared_pointer m_channelRequester;
 
-    RPCServiceAsync::shared_pointer m_rpcService;
+    RPCServiceState::shared_pointer m_state;
+    ServerExecutor::shared_pointer m_executor;
 
 public:
     POINTER_DEFINITIONS(RPCChannel);
@@ -135,11 +378,13 @@ public:
         ChannelProvider::shared_pointer const & provider,
         string const & channelName,
         ChannelRequester::shared_pointer const & channelRequester,
-        RPCServiceAsync::shared_pointer const & rpcService) :
+        RPCServiceState::shared_pointer const & state,
+        ServerExecutor::shared_pointer const & executor = ServerExecutor::shared_pointer()) :
         m_provider(provider),
         m_channelName(channelName),
         m_channelRequester(channelRequester),
-        m_rpcService(rpcService)
+        m_state(state),
+        m_executor(executor)
     {
     }
 
@@ -199,7 +444,7 @@ public:
 
         // TODO use std::make_shared
         std::tr1::shared_ptr<ChannelRPCServiceImpl> tp(
-            new ChannelRPCServiceImpl(shared_from_this(), channelRPCRequester, m_rpcService)
+            new ChannelRPCServiceImpl(shared_from_this(), channelRPCRequester, m_state, m_executor)
         );
         ChannelRPC::shared_pointer channelRPCImpl = tp;
         channelRPCRequester->channelRPCConnect(Status::Ok, channelRPCImpl);
@@ -232,8 +477,9 @@ Channel::shared_pointer createRPCChannel(ChannelProvider::shared_pointer const &
         RPCServiceAsync::shared_pointer const & rpcService)
 {
     // TODO use std::make_shared
+    RPCServiceState::shared_pointer state(new RPCServiceState(channelName, rpcService, RPCServer::ServiceLimits()));
     std::tr1::shared_ptr<RPCChannel> tp(
-        new RPCChannel(provider, channelName, channelRequester, rpcService)
+        new RPCChannel(provider, channelName, channelRequester, state)
     );
     Channel::shared_pointer channel = tp;
     return channel;
@@ -252,9 +498,19 @@ public:
 
     static const Status noSuchChannelStatus;
 
-    // TODO thread pool support
+    explicit RPCChannelProvider(size_t nworkers) {
+        if(nworkers)
+            m_executor.reset(new ServerExecutor(nworkers));
+    }
 
-    RPCChannelProvider() {
+    virtual ~RPCChannelProvider() {
+        close();
+    }
+
+    //! Stop workers
+    void close() {
+        if(m_executor)
+            m_executor->close();
     }
 
     virtual string getProviderName() {
@@ -311,19 +567,17 @@ public:
         ChannelRequester::shared_pointer const & channelRequester,
         short /*priority*/)
     {
-        RPCServiceAsync::shared_pointer service;
-
-        RPCServiceMap::const_iterator iter;
+        RPCServiceState::shared_pointer service;
         {
             Lock guard(m_mutex);
-            iter = m_services.find(channelName);
-        }
-        if (iter != m_services.end())
-            service = iter->second;
+            RPCServiceMap::const_iterator iter = m_services.find(channelName);
+            if (iter != m_services.end())
+                service = iter->second;
 
-        // check for wild services
-        if (!service)
-            service = findWildService(channelName);
+            // check for wild services
+            if (!service)
+                service = findWildService(channelName);
+        }
 
         if (!service)
         {
@@ -338,7 +592,8 @@ public:
                 shared_from_this(),
                 channelName,
                 channelRequester,
-                service));
+                service,
+                m_executor));
         Channel::shared_pointer rpcChannel = tp;
         channelRequester->channelCreated(Status::Ok, rpcChannel);
         return rpcChannel;
@@ -354,13 +609,33 @@ public:
         throw std::runtime_error("not supported");
     }
 
-    void registerService(std::string const & serviceName, RPCServiceAsync::shared_pointer const & service)
+    void registerService(std::string const & serviceName, RPCServiceAsync::shared_pointer const & service,
+                         const RPCServer::ServiceLimits& limits)
     {
+        RPCServiceState::shared_pointer state(new RPCServiceState(serviceName, service, limits));
+
         Lock guard(m_mutex);
-        m_services[serviceName] = service;
+        m_services[serviceName] = state;
 
         if (isWildcardPattern(serviceName))
-            m_wildServices.push_back(std::make_pair(serviceName, service));
+            m_wildServices.push_back(std::make_pair(serviceName, state));
+    }
+
+    void getStats(std::vector<RPCServer::ServiceStats>& stats) const
+    {
+        std::vector<RPCServiceState::shared_pointer> states;
+        {
+            Lock guard(m_mutex);
+            states.reserve(m_services.size());
+            for (RPCServiceMap::const_iterator iter = m_services.begin();
+                    iter != m_services.end();
+                    iter++)
+                states.push_back(iter->second);
+        }
+
+        stats.resize(states.size());
+        for(size_t i=0u; i<states.size(); i++)
+            states[i]->getStats(stats[i]);
     }
 
     void unregisterService(std::string const & serviceName)
@@ -383,7 +658,7 @@ public:
 
 private:
     // assumes sync on services
-    RPCServiceAsync::shared_pointer findWildService(string const & wildcard)
+    RPCServiceState::shared_pointer findWildService(string const & wildcard)
     {
         if (!m_wildServices.empty())
             for (RPCWildServiceList::iterator iter = m_wildServices.begin();
@@ -392,7 +667,7 @@ private:
                 if (Wildcard::wildcardfit(iter->first.c_str(), wildcard.c_str()))
                     return iter->second;
 
-        return RPCServiceAsync::shared_pointer();
+        return RPCServiceState::shared_pointer();
     }
 
     // (too) simple check
@@ -404,21 +679,24 @@ private:
              (pattern.find('[') != string::npos && pattern.find(']') != string::npos));
     }
 
-    typedef std::map<string, RPCServiceAsync::shared_pointer> RPCServiceMap;
+    typedef std::map<string, RPCServiceState::shared_pointer> RPCServiceMap;
     RPCServiceMap m_services;
 
-    typedef std::vector<std::pair<string, RPCServiceAsync::shared_pointer> > RPCWildServiceList;
+    typedef std::vector<std::pair<string, RPCServiceState::shared_pointer> > RPCWildServiceList;
     RPCWildServiceList m_wildServices;
 
-    epics::pvData::Mutex m_mutex;
+    // NULL to call services from the server thread
+    ServerExecutor::shared_pointer m_executor;
+
+    mutable epics::pvData::Mutex m_mutex;
 };
 
 const string RPCChannelProvider::PROVIDER_NAME("rpcService");
 const Status RPCChannelProvider::noSuchChannelStatus(Status::STATUSTYPE_ERROR, "no such channel");
 
 
-RPCServer::RPCServer(const Configuration::const_shared_pointer &conf)
-    :m_channelProviderImpl(new RPCChannelProvider)
+RPCServer::RPCServer(const Configuration::const_shared_pointer &conf, size_t nworkers)
+    :m_channelProviderImpl(new RPCChannelProvider(nworkers))
 {
     m_serverContext = ServerContext::create(ServerContext::Config()
                                             .config(conf)
@@ -435,6 +713,20 @@ void RPCServer::printInfo()
 {
     std::cout << m_serverContext->getVersion().getVersionString() << std::endl;
     m_serverContext->printInfo();
+
+    std::vector<ServiceStats> stats;
+    getStats(stats);
+    for(size_t i=0u; i<stats.size(); i++) {
+        const ServiceStats& S = stats[i];
+        std::cout<<"RPC service "<<S.name<<" completed "<<S.completed<<" rejected "<<S.rejected
+                 <<" active "<<S.active<<" queued "<<S.queued
+                 <<" latency (sec) p50 "<<S.p50<<" p90 "<<S.p90<<" p99 "<<S.p99<<" max "<<S.max<<"\n";
+    }
+}
+
+void RPCServer::getStats(std::vector<ServiceStats>& stats) const
+{
+    m_channelProviderImpl->getStats(stats);
 }
 
 void RPCServer::run(int seconds)
@@ -476,11 +768,18 @@ void RPCServer::runInNewThread(int seconds)
 void RPCServer::destroy()
 {
     m_serverContext->shutdown();
+    m_channelProviderImpl->close();
 }
 
 void RPCServer::registerService(std::string const & serviceName, RPCServiceAsync::shared_pointer const & service)
 {
-    m_channelProviderImpl->registerService(serviceName, service);
+    m_channelProviderImpl->registerService(serviceName, service, ServiceLimits());
+}
+
+void RPCServer::registerService(std::string const & serviceName, RPCServiceAsync::shared_pointer const & service,
+                                const ServiceLimits& limits)
+{
+    m_channelProviderImpl->registerService(serviceName, service, limits);
 }
 
 void RPCServer::unregisterService(std::string const & serviceName)
@@ -35,7 +35,8 @@ BaseChannelRequester::BaseChannelRequester(
     _transport(transport),
     _channel(channel),
     _context(context),
-    _pendingRequest(BaseChannelRequester::NULL_REQUEST)
+    _pendingRequest(BaseChannelRequester::NULL_REQUEST),
+    _dropCount(0u)
 {
 
 }
@@ -57,6 +58,16 @@ void BaseChannelRequester::stopRequest()
     _pendingRequest = NULL_REQUEST;
 }
 
+void BaseChannelRequester::dropQueued()
+{
+    epics::atomic::increment(_dropCount);
+}
+
+size_t BaseChannelRequester::getDropCount() const
+{
+    return epics::atomic::get(_dropCount);
+}
+
 int32 BaseChannelRequester::getPendingRequest()
 {
     Lock guard(_mutex);
@@ -33,6 +33,13 @@ public:
     bool startRequest(epics::pvData::int32 qos);
     void stopRequest();
     epics::pvData::int32 getPendingRequest();
+    /**
+     * Drop work queued by ServerChannel::execute() before this call, instead of running it.
+     * Called on cancel, and on destroy.
+     */
+    void dropQueued();
+    //! Number of calls to dropQueued()
+    size_t getDropCount() const;
     //! The Operation associated with this Requester, except for GetField and Monitor (which are special snowflakes...)
     virtual std::tr1::shared_ptr<ChannelRequest> getOperation() =0;
     virtual std::string getRequesterName() OVERRIDE FINAL;
@@ -59,6 +66,7 @@ private:
     ServerContextImpl::shared_pointer _context;
     static const epics::pvData::int32 NULL_REQUEST;
     epics::pvData::int32 _pendingRequest;
+    size_t _dropCount;
 };
 
 class BaseChannelRequesterMessageTransportSender : public TransportSender
@@ -131,6 +131,61 @@ public:
 };
 
 
+/**
+ * Gathers the results of all channel names of one search request
+ * (same search sequence ID and reply address) so that they are answered
+ * with as few CMD_SEARCH_RESPONSE datagrams as possible.
+ *
+ * Results arriving while the request is still being dispatched to providers
+ * are collected and sent once all names have been answered.
+ * Late (asynchronous) results are sent after a short gather window.
+ */
+class ServerSearchResponseBatch:
+    public TransportSender,
+    public epics::pvData::TimerCallback,
+    public std::tr1::enable_shared_from_this<ServerSearchResponseBatch>
+{
+public:
+    POINTER_DEFINITIONS(ServerSearchResponseBatch);
+
+    //! Time (in seconds) to wait for further asynchronous results before sending.
+    static const double GATHER_WINDOW;
+
+    ServerSearchResponseBatch(ServerContextImpl::shared_pointer const & context,
+                              epics::pvData::int32 searchSequenceId,
+                              osiSockAddr const & sendTo);
+    virtual ~ServerSearchResponseBatch() {}
+
+    //! Note that one more channel name awaits a result.
+    void addPending();
+    //! Record the result for one channel name.
+    void result(epics::pvData::int32 cid, bool wasFound, bool responseRequired);
+    //! All channel names of the request have been passed to the providers.
+    void dispatched();
+
+    virtual void send(epics::pvData::ByteBuffer* buffer, TransportSendControl* control) OVERRIDE FINAL;
+
+    virtual void callback() OVERRIDE FINAL;
+    virtual void timerStopped() OVERRIDE FINAL;
+
+private:
+    bool startGather();
+    void complete(bool sendNow, bool schedule);
+    void flush();
+
+    const ServerGUID _guid;
+    const epics::pvData::int32 _searchSequenceId;
+    const osiSockAddr _sendTo;
+    const ServerContextImpl::shared_pointer _context;
+    mutable epics::pvData::Mutex _mutex;
+    std::vector<epics::pvData::int32> _found, _notFound;
+    size_t _pending;
+    // dispatched() called
+    bool _dispatched;
+    // waiting for callback()
+    bool _scheduled;
+};
+
 class ServerChannelFindRequesterImpl:
     public ChannelFindRequester,
     public TransportSender,
@@ -145,6 +200,8 @@ public:
     void clear();
     ServerChannelFindRequesterImpl* set(std::string _name, epics::pvData::int32 searchSequenceId,
                                         epics::pvData::int32 cid, osiSockAddr const & sendTo, bool responseRequired, bool serverSearch);
+    //! Report name search results through 'batch' instead of sending a response per channel.
+    ServerChannelFindRequesterImpl* setBatch(ServerSearchResponseBatch::shared_pointer const & batch);
     virtual void channelFindResult(const epics::pvData::Status& status, ChannelFind::shared_pointer const & channelFind, bool wasFound) OVERRIDE FINAL;
 
     virtual std::tr1::shared_ptr<const PeerInfo> getPeerInfo() OVERRIDE FINAL;
@@ -161,12 +218,15 @@ private:
     osiSockAddr _sendTo;
     bool _responseRequired;
     bool _wasFound;
+    bool _reported; // result passed to _batch
     const ServerContextImpl::shared_pointer _context;
     const PeerInfo::const_shared_pointer _peer;
     mutable epics::pvData::Mutex _mutex;
     const epics::pvData::int32 _expectedResponseCount;
     epics::pvData::int32 _responseCount;
     bool _serverSearch;
+    ServerSearchResponseBatch::shared_pointer _batch;
+    const size_t _cacheGeneration;
 };
 
 /****************************************************************************************/
@@ -190,6 +250,8 @@ private:
     static const std::string SERVER_CHANNEL_NAME;
 
     void disconnect(Transport::shared_pointer const & transport);
+
+    void createChannel(Transport::shared_pointer const & transport, const pvAccessID cid, const std::string& channelName);
 };
 
 namespace detail {
@@ -511,6 +573,10 @@ private:
     window_t _window_closed;
     bool _unlisten;
     bool _pipeline; // const after activate()
+    bool _trace; // const after activate()
+#ifdef WITH_MICROBENCH
+    epics::pvData::uint64 _mbId; // auto ID of the last monitorEvent().  cf. pvAccessMB.h
+#endif
 };
 
 
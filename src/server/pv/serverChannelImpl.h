@@ -11,6 +11,7 @@
 #include <pv/remote.h>
 #include <pv/security.h>
 #include <pv/baseChannelRequester.h>
+#include <pv/serverExecutor.h>
 
 namespace epics {
 namespace pvAccess {
@@ -52,6 +53,17 @@ public:
     //! may return NULL
     std::tr1::shared_ptr<BaseChannelRequester> getRequest(pvAccessID id);
 
+    //! Append all registered requests
+    void getRequests(std::vector<std::tr1::shared_ptr<BaseChannelRequester> >& requests) const;
+
+    /**
+     * Run provider operation for this channel.
+     * Immediately if executor is NULL.  Otherwise by a worker,
+     * after any work previously queued for this channel.
+     */
+    void execute(const ServerExecutor::shared_pointer& executor,
+                 const ServerExecutor::Work::shared_pointer& work);
+
     void destroy();
 
     void printInfo() const;
@@ -72,6 +84,9 @@ private:
 
     bool _destroyed;
 
+    //! created on first use by execute()
+    ServerExecutor::Strand::shared_pointer _strand;
+
     mutable epics::pvData::Mutex _mutex;
 };
 
@@ -128,6 +128,14 @@ public:
      * @returns shared_ptr<ServerContext> which will automatically shutdown() when the last reference is released.
      */
     static ServerContext::shared_pointer create(const Config& conf = Config());
+
+    /** Discard negative search results cached by all ServerContext s of this process.
+     *
+     * Only relevant when $EPICS_PVAS_SEARCH_NEGATIVE_CACHE_TMO is set.
+     * ChannelProviders call this when a previously unknown channel name becomes available.
+     * eg. pvas::StaticProvider::add() does so.
+     */
+    static void invalidateSearchCache();
 };
 
 // Caller must store the returned pointer to keep the server alive.
@@ -6,6 +6,13 @@
 #   undef epicsExportSharedSymbols
 #endif
 
+#include <vector>
+#include <string>
+#include <utility>
+
+#include <epicsMutex.h>
+#include <epicsTime.h>
+
 #include <pv/thread.h>
 
 #ifdef serverContextImplEpicsExportSharedSymbols
@@ -16,12 +23,77 @@
 #include <pv/blockingUDP.h>
 #include <pv/blockingTCP.h>
 #include <pv/beaconEmitter.h>
+#include <pv/serverExecutor.h>
+#include <pv/serverMetrics.h>
 
 #include "serverContext.h"
 
 namespace epics {
 namespace pvAccess {
 
+/** Time bounded set of channel names which no provider hosts.
+ *
+ * Entries are kept for between one and two timeout periods,
+ * and are discarded by ServerContext::invalidateSearchCache().
+ *
+ * Only providers which call invalidateSearchCache() (eg. pvas::StaticProvider)
+ * have new names found immediately.  A name which appears in any other provider
+ * may go unanswered for up to twice the timeout.
+ */
+class epicsShareClass SearchNegativeCache
+{
+    EPICS_NOT_COPYABLE(SearchNegativeCache)
+public:
+    //! Maximum number of names added during one timeout period.
+    static const size_t MAX_ENTRIES = 65536;
+
+    SearchNegativeCache();
+
+    //! @param timeout in seconds.  <=0 disables caching
+    void configure(double timeout);
+    double getTimeout() const;
+    bool enabled() const;
+
+    //! Current invalidation generation.  To be passed to add()
+    static size_t generation();
+
+    //! true if name is known to be missing.  Called for each name searched.
+    bool missing(const std::string& name);
+    //! Remember that no provider has name.  Ignored if invalidated since generation() was called.
+    void add(const std::string& name, size_t generation);
+
+    size_t size() const;
+
+private:
+    void expire();
+
+    mutable epicsMutex _mutex;
+    // _timeout>0.0, read without _mutex on the search path
+    int _enabled;
+    double _timeout;
+    /* Hashed set of names, as std::tr1::unordered_set is not available with all of our targets.
+     * A lookup hashes the name once, then compares strings only of entries with the same hash.
+     */
+    class Names {
+        typedef std::vector<std::pair<size_t, std::string> > bucket_t;
+        std::vector<bucket_t> _buckets; // allocated by first insert()
+        size_t _count;
+    public:
+        // MAX_ENTRIES/16 buckets, so a few entries per bucket when full
+        static const size_t NBUCKETS = 4096;
+        Names() :_count(0u) {}
+        static size_t hash(const std::string& name);
+        bool has(size_t hash, const std::string& name) const;
+        void insert(size_t hash, const std::string& name);
+        void clear();
+        void swap(Names& o);
+        size_t size() const { return _count; }
+    };
+    Names _current, _previous;
+    epicsTimeStamp _rotated;
+    size_t _generation;
+};
+
 class ServerContextImpl :
     public ServerContext,
     public Context,
@@ -70,6 +142,12 @@ public:
      */
     float getBeaconPeriod();
 
+    /**
+     * Workers which call provider operations (get, put, process, rpc, ...)
+     * @return NULL if operations are called from the TCP receive thread.
+     */
+    const ServerExecutor::shared_pointer& getExecutor() const { return _executor; }
+
     /**
      * Get receiver buffer (payload) size.
      * @return max payload size.
@@ -121,6 +199,12 @@ public:
     // used by ServerChannelFindRequesterImpl
     typedef std::map<std::string, std::tr1::weak_ptr<ChannelProvider> > s_channelNameToProvider_t;
     s_channelNameToProvider_t s_channelNameToProvider;
+
+    // used by ServerSearchHandler and ServerChannelFindRequesterImpl
+    SearchNegativeCache _searchNegativeCache;
+
+    // incremented by ServerSearchHandler
+    size_t _searchRequests;
 private:
 
     /**
@@ -172,6 +256,40 @@ private:
      */
     epics::pvData::int32 _receiveBufferSize;
 
+    /**
+     * Number of UDP sockets (and receive threads) bound to each search listening address.
+     */
+    epics::pvData::int32 _searchThreads;
+
+    /**
+     * Length of the queue of TCP connections waiting to be accepted.
+     */
+    epics::pvData::int32 _tcpBacklog;
+
+    /**
+     * Number of acceptors (and accept threads) listening on the server port with SO_REUSEPORT.
+     */
+    epics::pvData::int32 _acceptThreads;
+
+    /**
+     * Number of workers calling provider operations.  0 to call from TCP receive threads.
+     */
+    epics::pvData::int32 _workerThreads;
+
+    ServerExecutor::shared_pointer _executor;
+
+    /**
+     * Prefix of server metrics PV names.  Empty to disable.
+     */
+    std::string _metricsPrefix;
+
+    /**
+     * Period in seconds between updates of server metrics PVs.
+     */
+    double _metricsPeriod;
+
+    ServerMetrics::shared_pointer _metrics;
+
     epics::pvData::Timer::shared_pointer _timer;
 
     /**
@@ -187,9 +305,9 @@ private:
     BeaconEmitter::shared_pointer _beaconEmitter;
 
     /**
-     * PVAS acceptor (accepts PVA virtual circuit).
+     * PVAS acceptors (accept PVA virtual circuit).  All listen on the same port.
      */
-    BlockingTCPAcceptor::shared_pointer _acceptor;
+    std::vector<BlockingTCPAcceptor::shared_pointer> _acceptors;
 
     /**
      * PVA transport (virtual circuit) registry.
@@ -0,0 +1,102 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * pvAccessCPP is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#ifndef SERVEREXECUTOR_H
+#define SERVEREXECUTOR_H
+
+#include <deque>
+#include <list>
+#include <vector>
+
+#include <epicsEvent.h>
+
+#include <pv/noDefaultMethods.h>
+#include <pv/sharedPtr.h>
+#include <pv/lock.h>
+#include <pv/thread.h>
+
+#include <shareLib.h>
+
+namespace epics {
+namespace pvAccess {
+
+/**
+ * Pool of worker threads which call into providers on behalf of
+ * the server, so that the TCP receive thread of a connection
+ * only deserializes requests and dispatches them.
+ *
+ * Work is queued to a Strand.  Work of one Strand is run in the order queued,
+ * and never concurrently.  Different Strands run concurrently.
+ * The server uses one Strand per ServerChannel.
+ */
+class epicsShareClass ServerExecutor
+{
+public:
+    POINTER_DEFINITIONS(ServerExecutor);
+
+    struct Work {
+        POINTER_DEFINITIONS(Work);
+        virtual ~Work() {}
+        virtual void run() = 0;
+    };
+
+    class Strand {
+        friend class ServerExecutor;
+        // guarded by ServerExecutor::mutex
+        std::list<Work::shared_pointer> queue;
+        bool scheduled; // on ServerExecutor::ready, or being run
+    public:
+        POINTER_DEFINITIONS(Strand);
+        Strand() :scheduled(false) {}
+    };
+
+    //! Start nworkers threads.
+    explicit ServerExecutor(size_t nworkers);
+    ~ServerExecutor();
+
+    /**
+     * Queue work to be run by a worker after all work previously queued to this Strand.
+     * Work queued after close() is dropped.
+     */
+    void execute(const Strand::shared_pointer& strand, const Work::shared_pointer& work);
+
+    //! Stop and join workers.  Queued work not yet started is dropped.
+    void close();
+
+    size_t workerCount() const { return workers.size(); }
+
+    struct Stats {
+        //! Work completed
+        size_t executed;
+        //! Work queued, but not yet completed
+        size_t pending;
+        //! Largest value of pending
+        size_t pendingPeak;
+        Stats() :executed(0u), pending(0u), pendingPeak(0u) {}
+    };
+
+    void getStats(Stats& stats) const;
+
+private:
+    void worker();
+
+    mutable epics::pvData::Mutex mutex;
+    //! Strands with work queued, and not being run
+    std::deque<Strand::shared_pointer> ready;
+    bool closed;
+    Stats stats;
+
+    epicsEvent wakeup;
+
+    std::vector<std::tr1::shared_ptr<epics::pvData::Thread> > workers;
+
+    EPICS_NOT_COPYABLE(ServerExecutor)
+};
+
+}
+}
+
+#endif // SERVEREXECUTOR_H
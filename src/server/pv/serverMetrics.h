@@ -0,0 +1,113 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * pvAccessCPP is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#ifndef SERVERMETRICS_H
+#define SERVERMETRICS_H
+
+#include <map>
+#include <string>
+
+#include <epicsTime.h>
+
+#include <pv/timer.h>
+#include <pv/pvData.h>
+#include <pv/sharedPtr.h>
+#include <pv/noDefaultMethods.h>
+
+#include <pva/sharedstate.h>
+#include <pva/server.h>
+
+namespace epics {
+namespace pvAccess {
+
+class ServerContextImpl;
+
+/**
+ * Publishes statistics of a ServerContext as PVs of the same server.
+ *
+ * Enabled by setting $EPICS_PVAS_METRICS_PREFIX, which is prepended to the PV names.
+ *
+ * - \<prefix\>connections  NTScalar  number of client connections
+ * - \<prefix\>channels     NTScalar  number of channels, all connections
+ * - \<prefix\>rxRate       NTScalar  bytes/s received, all connections
+ * - \<prefix\>txRate       NTScalar  bytes/s sent, all connections
+ * - \<prefix\>searchRate   NTScalar  search requests/s received
+ * - \<prefix\>workQueue    NTScalar  provider operations waiting for a worker ($EPICS_PVAS_WORKER_THREADS)
+ * - \<prefix\>clients      NTTable   one row per connection
+ *
+ * Values are updated every $EPICS_PVAS_METRICS_PERIOD seconds,
+ * but only while some client is connected to one of these PVs.
+ */
+class ServerMetrics :
+    public epics::pvData::TimerCallback,
+    public std::tr1::enable_shared_from_this<ServerMetrics>
+{
+public:
+    POINTER_DEFINITIONS(ServerMetrics);
+
+    static const char providerName[];
+
+    ServerMetrics(const std::string& prefix, double period,
+                  const std::tr1::shared_ptr<ServerContextImpl>& context);
+    virtual ~ServerMetrics();
+
+    //! Begin counting subscribers.  Call once after construction.
+    void start();
+
+    //! Provider to be added to those of the server.
+    std::tr1::shared_ptr<ChannelProvider> getProvider() const { return provider.provider(); }
+
+    //! Stop updates, and disconnect clients.
+    void close();
+
+    virtual void callback() OVERRIDE FINAL;
+    virtual void timerStopped() OVERRIDE FINAL;
+
+private:
+    struct Handler;
+    friend struct Handler;
+
+    //! Handler callbacks.  Updates run while subscribers>0
+    void subscribe();
+    void unsubscribe();
+
+    void update();
+
+    const double period;
+    const std::tr1::weak_ptr<ServerContextImpl> context;
+    const epics::pvData::Timer::shared_pointer timer;
+
+    pvas::StaticProvider provider;
+
+    pvas::SharedPV::shared_pointer connections, channels, rxRate, txRate, searchRate, workQueue, clients;
+
+    // guarded by mutex
+    epics::pvData::Mutex mutex;
+    size_t subscribers;
+    bool closed;
+    bool restart; // rates are not computed from the first sample after the first subscriber
+
+    // only accessed from timer callback
+
+    struct Sample {
+        size_t rx, tx;
+        Sample() :rx(0u), tx(0u) {}
+    };
+    //! by Transport::getRemoteName()
+    typedef std::map<std::string, Sample> samples_t;
+    samples_t previous;
+    size_t prevSearches;
+    epicsTimeStamp prevTime;
+
+    epics::pvData::PVStructurePtr scalarValue, doubleValue, tableValue;
+
+    EPICS_NOT_COPYABLE(ServerMetrics)
+};
+
+}
+}
+
+#endif // SERVERMETRICS_H
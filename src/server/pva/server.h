@@ -158,6 +158,11 @@ public:
  * Through an associated Handler, this provider sees all searchs, and may claim
  * them.
  *
+ * When $EPICS_PVAS_SEARCH_NEGATIVE_CACHE_TMO is set, names which were not claimed
+ * may not be searched for again until the cache entry times out.
+ * A Handler which begins to claim a previously unclaimed name should call
+ * epics::pvAccess::ServerContext::invalidateSearchCache() .
+ *
  * @see @ref pvas_sharedptr
  */
 class epicsShareClass DynamicProvider {
@@ -12,7 +12,9 @@
 #include <pv/sharedPtr.h>
 #include <pv/noDefaultMethods.h>
 #include <pv/bitSet.h>
+#include <pv/sharedVector.h>
 #include <pv/createRequest.h>
+#include <pv/monitor.h>
 
 #include <pva/server.h>
 
@@ -159,6 +161,8 @@ public:
     //! Update the cached PVStructure in this SharedPV.
     //! Only those fields marked as changed will be copied in.
     //! Makes a light-weight copy.
+    //! Array values are shared by reference with the cached PVStructure,
+    //! subscriber queues, and the network send.  @see wrapBuffer()
     //! @pre isOpen()==true
     //! @throws std::logic_error if !isOpen()
     //! @note Provider locking rules apply (@see provider_roles_requester_locking).
@@ -281,6 +285,52 @@ public:
 #endif
 };
 
+/** Notification that the last reference to a buffer wrapped by wrapBuffer() has been released.
+ */
+struct epicsShareClass BufferReleaser {
+    POINTER_DEFINITIONS(BufferReleaser);
+    virtual ~BufferReleaser();
+    //! Called from the thread which drops the last reference.  eg. a server send thread.
+    //! Must not block, or call SharedPV methods.
+    virtual void release(const void* buffer) = 0;
+};
+
+namespace detail {
+template<typename E>
+struct BufferReleaseDeleter {
+    BufferReleaser::shared_pointer releaser;
+    explicit BufferReleaseDeleter(const BufferReleaser::shared_pointer& releaser) :releaser(releaser) {}
+    void operator()(const E* buffer) {
+        epics::pvAccess::detail::wrappedBufferRemove();
+        releaser->release(buffer);
+    }
+};
+} // namespace detail
+
+/** Wrap an externally owned buffer as an array value for SharedPV::post(), without copying.
+ *
+ * The buffer must not be modified until released.
+ * releaser->release(buffer) is called once the buffer is no longer referenced.
+ * That is, after a later post() has replaced it, and each subscriber has finished sending it.
+ *
+ @code
+   pvd::PVStructurePtr value(pv->build());
+   pvd::BitSet changed;
+   pvd::PVDoubleArrayPtr arr(value->getSubFieldT<pvd::PVDoubleArray>("value"));
+   arr->replace(pvas::wrapBuffer(frame->data, frame->count, pool));
+   changed.set(arr->getFieldOffset());
+   pv->post(*value, changed);
+ @endcode
+ */
+template<typename E>
+epics::pvData::shared_vector<const E> wrapBuffer(const E* buffer, size_t count,
+                                                  const BufferReleaser::shared_pointer& releaser)
+{
+    // count first, the deleter is also called if construction fails
+    epics::pvAccess::detail::wrappedBufferAdd();
+    return epics::pvData::shared_vector<const E>(buffer, detail::BufferReleaseDeleter<E>(releaser), 0u, count);
+}
+
 } // namespace pvas
 
 //! @}
@@ -5,6 +5,7 @@
  */
 
 #include <sstream>
+#include <algorithm>
 #include <time.h>
 #include <stdlib.h>
 
@@ -83,6 +84,145 @@ static PVField::shared_pointer reuseOrCreatePVField(
         return pvDataCreate->createPVField(field);
 }
 
+namespace {
+/* Calls to provider operations, run through ServerChannel::execute().
+ * Requests are deserialized by the receive thread before queuing.
+ * Work is dropped if its operation is cancelled or destroyed while queued.
+ */
+
+struct RequestWork : public ServerExecutor::Work {
+    const BaseChannelRequester::shared_pointer request;
+    const size_t dropCount;
+    const bool lastRequest;
+#ifdef WITH_MICROBENCH
+    pvData::uint64 mbId; // continue sample of the receiving thread
+#endif
+    RequestWork(const BaseChannelRequester::shared_pointer& request, bool lastRequest)
+        :request(request), dropCount(request->getDropCount()), lastRequest(lastRequest)
+    {
+        MB_GET_AUTO_ID(pvAccessMB, mbId);
+    }
+    virtual ~RequestWork() {}
+    virtual void run() OVERRIDE FINAL {
+        MB_SET_AUTO_ID(pvAccessMB, mbId);
+        if (request->getDropCount() != dropCount)
+        {
+            // the client no longer waits for a reply
+            request->stopRequest();
+            if (lastRequest)
+                request->destroy();
+            return;
+        }
+        call();
+    }
+    virtual void call() =0;
+};
+
+struct GetWork : public RequestWork {
+    const ChannelGet::shared_pointer op;
+    GetWork(const BaseChannelRequester::shared_pointer& request, const ChannelGet::shared_pointer& op, bool lastRequest)
+        :RequestWork(request, lastRequest), op(op) {}
+    virtual ~GetWork() {}
+    virtual void call() OVERRIDE FINAL {
+        if (lastRequest)
+            op->lastRequest();
+        op->get();
+    }
+};
+
+struct PutWork : public RequestWork {
+    const ChannelPut::shared_pointer op;
+    const bool get;
+    const PVStructure::shared_pointer value;
+    const BitSet::shared_pointer changed;
+    PutWork(const BaseChannelRequester::shared_pointer& request, const ChannelPut::shared_pointer& op, bool lastRequest, bool get,
+            const PVStructure::shared_pointer& value = PVStructure::shared_pointer(),
+            const BitSet::shared_pointer& changed = BitSet::shared_pointer())
+        :RequestWork(request, lastRequest), op(op), get(get), value(value), changed(changed) {}
+    virtual ~PutWork() {}
+    virtual void call() OVERRIDE FINAL {
+        if (lastRequest)
+            op->lastRequest();
+        if (get)
+            op->get();
+        else
+            op->put(value, changed);
+    }
+};
+
+struct PutGetWork : public RequestWork {
+    const ChannelPutGet::shared_pointer op;
+    const bool getGet, getPut;
+    const PVStructure::shared_pointer value;
+    const BitSet::shared_pointer changed;
+    PutGetWork(const BaseChannelRequester::shared_pointer& request, const ChannelPutGet::shared_pointer& op, bool lastRequest, bool getGet, bool getPut,
+               const PVStructure::shared_pointer& value = PVStructure::shared_pointer(),
+               const BitSet::shared_pointer& changed = BitSet::shared_pointer())
+        :RequestWork(request, lastRequest), op(op), getGet(getGet), getPut(getPut), value(value), changed(changed) {}
+    virtual ~PutGetWork() {}
+    virtual void call() OVERRIDE FINAL {
+        if (lastRequest)
+            op->lastRequest();
+        if (getGet)
+            op->getGet();
+        else if (getPut)
+            op->getPut();
+        else
+            op->putGet(value, changed);
+    }
+};
+
+struct ArrayWork : public RequestWork {
+    enum action_t {GetArray, SetLength, GetLength, PutArray};
+    const ChannelArray::shared_pointer op;
+    const action_t action;
+    const size_t offset, count, stride;
+    const PVArray::shared_pointer value;
+    ArrayWork(const BaseChannelRequester::shared_pointer& request, const ChannelArray::shared_pointer& op, bool lastRequest, action_t action,
+              size_t offset = 0u, size_t count = 0u, size_t stride = 0u,
+              const PVArray::shared_pointer& value = PVArray::shared_pointer())
+        :RequestWork(request, lastRequest), op(op), action(action)
+        ,offset(offset), count(count), stride(stride), value(value) {}
+    virtual ~ArrayWork() {}
+    virtual void call() OVERRIDE FINAL {
+        if (lastRequest)
+            op->lastRequest();
+        switch(action) {
+        case GetArray:  op->getArray(offset, count, stride); break;
+        case SetLength: op->setLength(count); break;
+        case GetLength: op->getLength(); break;
+        case PutArray:  op->putArray(value, offset, count, stride); break;
+        }
+    }
+};
+
+struct ProcessWork : public RequestWork {
+    const ChannelProcess::shared_pointer op;
+    ProcessWork(const BaseChannelRequester::shared_pointer& request, const ChannelProcess::shared_pointer& op, bool lastRequest)
+        :RequestWork(request, lastRequest), op(op) {}
+    virtual ~ProcessWork() {}
+    virtual void call() OVERRIDE FINAL {
+        if (lastRequest)
+            op->lastRequest();
+        op->process();
+    }
+};
+
+struct RPCWork : public RequestWork {
+    const ChannelRPC::shared_pointer op;
+    const PVStructure::shared_pointer argument;
+    RPCWork(const BaseChannelRequester::shared_pointer& request, const ChannelRPC::shared_pointer& op, bool lastRequest, const PVStructure::shared_pointer& argument)
+        :RequestWork(request, lastRequest), op(op), argument(argument) {}
+    virtual ~RPCWork() {}
+    virtual void call() OVERRIDE FINAL {
+        if (lastRequest)
+            op->lastRequest();
+        op->request(argument);
+    }
+};
+
+} // namespace
+
 
 
 void ServerBadResponse::handleResponse(osiSockAddr* responseFrom,
@@ -331,6 +471,8 @@ void ServerSearchHandler::handleResponse(osiSockAddr* responseFrom,
         }
     }
 
+    atomic::increment(_context->_searchRequests);
+
     PeerInfo::shared_pointer info;
     if(allowed) {
         info.reset(new PeerInfo);
@@ -342,25 +484,50 @@ void ServerSearchHandler::handleResponse(osiSockAddr* responseFrom,
     if (count > 0)
     {
         // regular name search
-        for (int32 i = 0; i < count; i++)
-        {
-            transport->ensureData(4);
-            const int32 cid = payloadBuffer->getInt();
-            const string name = SerializeHelper::deserializeString(payloadBuffer, transport.get());
-            // no name check here...
+        // all names of this request share one (or a few) response message(s)
+        ServerSearchResponseBatch::shared_pointer batch;
+        if (allowed)
+            batch.reset(new ServerSearchResponseBatch(_context, searchSequenceId, responseAddress));
 
-            if (allowed)
+        try {
+            for (int32 i = 0; i < count; i++)
             {
-                const std::vector<ChannelProvider::shared_pointer>& _providers = _context->getChannelProviders();
+                transport->ensureData(4);
+                const int32 cid = payloadBuffer->getInt();
+                const string name = SerializeHelper::deserializeString(payloadBuffer, transport.get());
+                // no name check here...
+
+                if (allowed)
+                {
+                    if (_context->_searchNegativeCache.missing(name))
+                    {
+                        // recently searched for, and no provider has it
+                        batch->addPending();
+                        batch->result(cid, false, responseRequired);
+                        continue;
+                    }
 
-                int providerCount = _providers.size();
-                std::tr1::shared_ptr<ServerChannelFindRequesterImpl> tp(new ServerChannelFindRequesterImpl(_context, info, providerCount));
-                tp->set(name, searchSequenceId, cid, responseAddress, responseRequired, false);
+                    const std::vector<ChannelProvider::shared_pointer>& _providers = _context->getChannelProviders();
 
-                for (int i = 0; i < providerCount; i++)
-                    _providers[i]->channelFind(name, tp);
+                    int providerCount = _providers.size();
+                    std::tr1::shared_ptr<ServerChannelFindRequesterImpl> tp(new ServerChannelFindRequesterImpl(_context, info, providerCount));
+                    tp->set(name, searchSequenceId, cid, responseAddress, responseRequired, false);
+                    tp->setBatch(batch);
+
+                    batch->addPending();
+                    for (int i = 0; i < providerCount; i++)
+                        _providers[i]->channelFind(name, tp);
+                }
             }
+        } catch(...) {
+            // truncated request, still answer the names already found
+            if (batch)
+                batch->dispatched();
+            throw;
         }
+
+        if (batch)
+            batch->dispatched();
     }
     else
     {
@@ -381,22 +548,183 @@ void ServerSearchHandler::handleResponse(osiSockAddr* responseFrom,
     }
 }
 
+const double ServerSearchResponseBatch::GATHER_WINDOW = 0.01;
+
+ServerSearchResponseBatch::ServerSearchResponseBatch(ServerContextImpl::shared_pointer const & context,
+        int32 searchSequenceId, osiSockAddr const & sendTo) :
+    _guid(context->getGUID()),
+    _searchSequenceId(searchSequenceId),
+    _sendTo(sendTo),
+    _context(context),
+    _pending(1u), // released by dispatched()
+    _dispatched(false),
+    _scheduled(false)
+{}
+
+void ServerSearchResponseBatch::addPending()
+{
+    Lock guard(_mutex);
+    _pending++;
+}
+
+void ServerSearchResponseBatch::dispatched()
+{
+    bool sendNow, schedule;
+    {
+        Lock guard(_mutex);
+        assert(_pending>0u);
+        _pending--;
+        _dispatched = true;
+        sendNow = _pending==0u;
+        schedule = !sendNow && startGather();
+    }
+    complete(sendNow, schedule);
+}
+
+void ServerSearchResponseBatch::result(int32 cid, bool wasFound, bool responseRequired)
+{
+    bool sendNow = false, schedule = false;
+    {
+        Lock guard(_mutex);
+        if (wasFound)
+            _found.push_back(cid);
+        else if (responseRequired)
+            _notFound.push_back(cid);
+
+        if (_pending>0u)
+            _pending--;
+
+        if (_pending==0u) {
+            // all names answered (also the case for late results)
+            sendNow = true;
+        } else if (_dispatched) {
+            // while dispatching, dispatched() decides
+            schedule = startGather();
+        }
+    }
+
+    complete(sendNow, schedule);
+}
+
+// caller holds _mutex
+bool ServerSearchResponseBatch::startGather()
+{
+    if (_scheduled || (_found.empty() && _notFound.empty()))
+        return false;
+    // asynchronous provider(s), wait a little while for others
+    _scheduled = true;
+    return true;
+}
+
+void ServerSearchResponseBatch::complete(bool sendNow, bool schedule)
+{
+    if (sendNow) {
+        flush();
+    } else if (schedule) {
+        Timer::shared_pointer timer(_context->getTimer());
+        if (timer) {
+            TimerCallback::shared_pointer tc(shared_from_this());
+            timer->scheduleAfterDelay(tc, GATHER_WINDOW);
+        }
+    }
+}
+
+void ServerSearchResponseBatch::callback()
+{
+    {
+        Lock guard(_mutex);
+        _scheduled = false;
+    }
+    flush();
+}
+
+void ServerSearchResponseBatch::timerStopped()
+{
+    // noop
+}
+
+void ServerSearchResponseBatch::flush()
+{
+    BlockingUDPTransport::shared_pointer bt = _context->getBroadcastTransport();
+    TransportSender::shared_pointer thisSender = shared_from_this();
+
+    while (true)
+    {
+        {
+            Lock guard(_mutex);
+            if (_found.empty() && _notFound.empty())
+                break;
+            if (!bt) {
+                // shutting down
+                _found.clear();
+                _notFound.clear();
+                break;
+            }
+        }
+        // each call consumes as many CIDs as fit in one datagram
+        bt->enqueueSendRequest(thisSender);
+    }
+}
+
+void ServerSearchResponseBatch::send(ByteBuffer* buffer, TransportSendControl* control)
+{
+    Lock guard(_mutex);
+
+    // already sent by a concurrent flush()
+    if (_found.empty() && _notFound.empty())
+        return;
+
+    // found channels first, negative responses are only sent on request
+    const bool wasFound = !_found.empty();
+    std::vector<int32>& cids = wasFound ? _found : _notFound;
+
+    // header (8) + GUID (12) + seq. ID (4) + address (16) + port (2) + "tcp" (1+3) + found (1) + count (2)
+    const size_t fixedSize = PVA_MESSAGE_HEADER_SIZE + 12 + 4 + 16 + 2
+                             + 1 + ServerSearchHandler::SUPPORTED_PROTOCOL.size() + 1 + 2;
+    const size_t maxCount = (MAX_UDP_UNFRAGMENTED_SEND - fixedSize) / 4u;
+    const size_t count = std::min(cids.size(), maxCount);
+
+    control->startMessage(CMD_SEARCH_RESPONSE, 12+4+16+2);
+
+    buffer->put(_guid.value, 0, sizeof(_guid.value));
+    buffer->putInt(_searchSequenceId);
+
+    // NOTE: is it possible (very likely) that address is any local address ::ffff:0.0.0.0
+    encodeAsIPv6Address(buffer, _context->getServerInetAddress());
+    buffer->putShort((int16)_context->getServerPort());
+
+    SerializeHelper::serializeString(ServerSearchHandler::SUPPORTED_PROTOCOL, buffer, control);
+
+    control->ensureBuffer(1);
+    buffer->putByte(wasFound ? (int8)1 : (int8)0);
+
+    buffer->putShort((int16)count);
+    for (size_t i = 0; i < count; i++)
+        buffer->putInt(cids[i]);
+    cids.erase(cids.begin(), cids.begin()+count);
+
+    control->setRecipient(_sendTo);
+}
+
 ServerChannelFindRequesterImpl::ServerChannelFindRequesterImpl(ServerContextImpl::shared_pointer const & context, const PeerInfo::const_shared_pointer &peer,
         int32 expectedResponseCount) :
     _guid(context->getGUID()),
     _sendTo(),
     _wasFound(false),
+    _reported(false),
     _context(context),
     _peer(peer),
     _expectedResponseCount(expectedResponseCount),
     _responseCount(0),
-    _serverSearch(false)
+    _serverSearch(false),
+    _cacheGeneration(SearchNegativeCache::generation())
 {}
 
 void ServerChannelFindRequesterImpl::clear()
 {
     Lock guard(_mutex);
     _wasFound = false;
+    _reported = false;
     _responseCount = 0;
     _serverSearch = false;
 }
@@ -424,6 +752,13 @@ ServerChannelFindRequesterImpl* ServerChannelFindRequesterImpl::set(std::string
     return this;
 }
 
+ServerChannelFindRequesterImpl* ServerChannelFindRequesterImpl::setBatch(ServerSearchResponseBatch::shared_pointer const & batch)
+{
+    Lock guard(_mutex);
+    _batch = batch;
+    return this;
+}
+
 void ServerChannelFindRequesterImpl::channelFindResult(const Status& /*status*/, ChannelFind::shared_pointer const & channelFind, bool wasFound)
 {
     // TODO status
@@ -445,13 +780,34 @@ void ServerChannelFindRequesterImpl::channelFindResult(const Status& /*status*/,
         return;
     }
 
-    if (wasFound || (_responseRequired && (_responseCount == _expectedResponseCount)))
+    if (wasFound && _expectedResponseCount > 1)
     {
-        if (wasFound && _expectedResponseCount > 1)
+        Lock L(_context->_mutex);
+        _context->s_channelNameToProvider[_name] = channelFind->getChannelProvider();
+    }
+
+    if (_batch)
+    {
+        // report exactly once per name: when first found, or when all providers have answered.
+        // The batch counts one result per name.
+        if (!_reported && (wasFound || _responseCount == _expectedResponseCount))
         {
-            Lock L(_context->_mutex);
-            _context->s_channelNameToProvider[_name] = channelFind->getChannelProvider();
+            if (!wasFound)
+                _context->_searchNegativeCache.add(_name, _cacheGeneration);
+
+            _reported = true;
+            _wasFound = wasFound;
+            ServerSearchResponseBatch::shared_pointer batch(_batch);
+            int32 cid = _cid;
+            bool responseRequired = _responseRequired;
+            epicsGuardRelease<epicsMutex> U(guard);
+            batch->result(cid, wasFound, responseRequired);
         }
+        return;
+    }
+
+    if (wasFound || (_responseRequired && (_responseCount == _expectedResponseCount)))
+    {
         _wasFound = wasFound;
 
         BlockingUDPTransport::shared_pointer bt = _context->getBroadcastTransport();
@@ -487,7 +843,7 @@ void ServerChannelFindRequesterImpl::send(ByteBuffer* buffer, TransportSendContr
 
     if (!_serverSearch)
     {
-        // TODO for now we do not gather search responses
+        // single name response (name searches are normally gathered by ServerSearchResponseBatch)
         buffer->putShort((int16)1);
         buffer->putInt(_cid);
     }
@@ -729,29 +1085,34 @@ void ServerCreateChannelHandler::handleResponse(osiSockAddr* responseFrom,
     AbstractServerResponseHandler::handleResponse(responseFrom,
             transport, version, command, payloadSize, payloadBuffer);
 
-    // TODO for not only one request at the time is supported, i.e. dataCount == 1
-    transport->ensureData((sizeof(int32)+sizeof(int16))/sizeof(int8));
+    // clients may create many channels with one message.  See PVA_SERVER_FEATURE_MULTI_CREATE
+    transport->ensureData(2);
     const int16 count = payloadBuffer->getShort();
-    if (count != 1)
+    for (int16 i = 0; i < count; i++)
     {
-        THROW_BASE_EXCEPTION("only 1 supported for now");
-    }
-    const pvAccessID cid = payloadBuffer->getInt();
+        transport->ensureData(4);
+        const pvAccessID cid = payloadBuffer->getInt();
 
-    string channelName = SerializeHelper::deserializeString(payloadBuffer, transport.get());
-    if (channelName.size() == 0)
-    {
-        LOG(logLevelDebug,"Zero length channel name, disconnecting client: %s", transport->getRemoteName().c_str());
-        disconnect(transport);
-        return;
-    }
-    else if (channelName.size() > MAX_CHANNEL_NAME_LENGTH)
-    {
-        LOG(logLevelDebug,"Unreasonable channel name length, disconnecting client: %s", transport->getRemoteName().c_str());
-        disconnect(transport);
-        return;
+        string channelName = SerializeHelper::deserializeString(payloadBuffer, transport.get());
+        if (channelName.size() == 0)
+        {
+            LOG(logLevelDebug,"Zero length channel name, disconnecting client: %s", transport->getRemoteName().c_str());
+            disconnect(transport);
+            return;
+        }
+        else if (channelName.size() > MAX_CHANNEL_NAME_LENGTH)
+        {
+            LOG(logLevelDebug,"Unreasonable channel name length, disconnecting client: %s", transport->getRemoteName().c_str());
+            disconnect(transport);
+            return;
+        }
+
+        createChannel(transport, cid, channelName);
     }
+}
 
+void ServerCreateChannelHandler::createChannel(Transport::shared_pointer const & transport, const pvAccessID cid, const string& channelName)
+{
     if (channelName == SERVER_CHANNEL_NAME)
     {
         // TODO singleton!!!
@@ -1057,10 +1418,8 @@ void ServerGetHandler::handleResponse(osiSockAddr* responseFrom,
             return;
         }
 
-        ChannelGet::shared_pointer channelGet = request->getChannelGet();
-        if (lastRequest)
-            channelGet->lastRequest();
-        channelGet->get();
+        ServerExecutor::Work::shared_pointer work(new GetWork(request, request->getChannelGet(), lastRequest));
+        channel->execute(_context->getExecutor(), work);
     }
 }
 
@@ -1296,12 +1655,10 @@ void ServerPutHandler::handleResponse(osiSockAddr* responseFrom,
 
         ChannelPut::shared_pointer channelPut = request->getChannelPut();
 
-        if (lastRequest)
-            channelPut->lastRequest();
-
+        ServerExecutor::Work::shared_pointer work;
         if (get)
         {
-            channelPut->get();
+            work.reset(new PutWork(request, channelPut, lastRequest, true));
         }
         else
         {
@@ -1319,9 +1676,12 @@ void ServerPutHandler::handleResponse(osiSockAddr* responseFrom,
 
                 lock.unlock();
 
-                channelPut->put(putPVStructure, putBitSet);
+                MB_POINT(pvAccessMB, 3, "deserialize");
+
+                work.reset(new PutWork(request, channelPut, lastRequest, false, putPVStructure, putBitSet));
             }
         }
+        channel->execute(_context->getExecutor(), work);
     }
 }
 
@@ -1535,16 +1895,11 @@ void ServerPutGetHandler::handleResponse(osiSockAddr* responseFrom,
         }
 
         ChannelPutGet::shared_pointer channelPutGet = request->getChannelPutGet();
-        if (lastRequest)
-            channelPutGet->lastRequest();
 
-        if (getGet)
+        ServerExecutor::Work::shared_pointer work;
+        if (getGet || getPut)
         {
-            channelPutGet->getGet();
-        }
-        else if(getPut)
-        {
-            channelPutGet->getPut();
+            work.reset(new PutGetWork(request, channelPutGet, lastRequest, getGet, getPut));
         }
         else
         {
@@ -1561,9 +1916,10 @@ void ServerPutGetHandler::handleResponse(osiSockAddr* responseFrom,
 
                 lock.unlock();
 
-                channelPutGet->putGet(putPVStructure, putBitSet);
+                work.reset(new PutGetWork(request, channelPutGet, lastRequest, false, false, putPVStructure, putBitSet));
             }
         }
+        channel->execute(_context->getExecutor(), work);
     }
 }
 
@@ -1866,6 +2222,10 @@ ServerMonitorRequesterImpl::ServerMonitorRequesterImpl(
     ,_window_open(0u)
     ,_unlisten(false)
     ,_pipeline(false)
+    ,_trace(false)
+#ifdef WITH_MICROBENCH
+    ,_mbId(0u)
+#endif
 {}
 
 ServerMonitorRequesterImpl::shared_pointer ServerMonitorRequesterImpl::create(
@@ -1889,6 +2249,16 @@ void ServerMonitorRequesterImpl::activate(PVStructure::shared_pointer const & pv
             message(strm.str(), epics::pvData::errorMessage);
         }
     }
+    O = pvRequest->getSubField<epics::pvData::PVScalar>("record._options.trace");
+    if(O) {
+        try{
+            _trace = O->getAs<epics::pvData::boolean>();
+        }catch(std::exception& e){
+            std::ostringstream strm;
+            strm<<"Ignoring invalid trace= : "<<e.what();
+            message(strm.str(), epics::pvData::errorMessage);
+        }
+    }
     startRequest(QOS_INIT);
     shared_pointer thisPointer(shared_from_this());
     _channel->registerRequest(_ioid, thisPointer);
@@ -1925,6 +2295,14 @@ void ServerMonitorRequesterImpl::unlisten(Monitor::shared_pointer const & /*moni
 
 void ServerMonitorRequesterImpl::monitorEvent(Monitor::shared_pointer const & /*monitor*/)
 {
+#ifdef WITH_MICROBENCH
+    {
+        Lock guard(_mutex);
+        MB_GET_AUTO_ID(pvAccessMB, _mbId);
+    }
+#endif
+    MB_POINT(pvAccessMB, 5, "send-queue enqueue");
+
     TransportSender::shared_pointer thisSender = shared_from_this();
     _transport->enqueueSendRequest(thisSender);
 }
@@ -2004,12 +2382,14 @@ void ServerMonitorRequesterImpl::send(ByteBuffer* buffer, TransportSendControl*
         }
         if (element)
         {
+            // changedBitSet and data, if not notify only (i.e. queueSize == -1)
+            const BitSet::shared_pointer& changedBitSet = element->changedBitSet;
+            const bool trace = _trace && !!changedBitSet;
+
             control->startMessage((int8)CMD_MONITOR, sizeof(int32)/sizeof(int8) + 1);
             buffer->putInt(_ioid);
-            buffer->putByte((int8)request);
+            buffer->putByte((int8)(trace ? (request | MONITOR_UPDATE_TRACE) : request));
 
-            // changedBitSet and data, if not notify only (i.e. queueSize == -1)
-            const BitSet::shared_pointer& changedBitSet = element->changedBitSet;
             if (changedBitSet)
             {
                 changedBitSet->serialize(buffer, control);
@@ -2019,6 +2399,20 @@ void ServerMonitorRequesterImpl::send(ByteBuffer* buffer, TransportSendControl*
                 element->overrunBitSet->serialize(buffer, control);
             }
 
+            if (trace)
+            {
+                const MonitorElement::Trace& T = element->trace;
+                epicsTimeStamp sent;
+                epicsTimeGetCurrent(&sent);
+
+                control->ensureBuffer(24);
+                buffer->putLong((int64)T.id);
+                buffer->putInt((int32)T.posted.secPastEpoch);
+                buffer->putInt((int32)T.posted.nsec);
+                buffer->putInt((int32)sent.secPastEpoch);
+                buffer->putInt((int32)sent.nsec);
+            }
+
             {
                 Lock guard(_mutex);
                 if(!_pipeline) {
@@ -2032,7 +2426,12 @@ void ServerMonitorRequesterImpl::send(ByteBuffer* buffer, TransportSendControl*
                     _window_closed.push_back(element.letGo());
                     _window_open--;
                 }
+#ifdef WITH_MICROBENCH
+                // continue the sample of the thread which enqueued us
+                MB_SET_AUTO_ID(pvAccessMB, _mbId);
+#endif
             }
+            MB_POINT(pvAccessMB, 6, "serialize");
 
             element.reset(); // calls Monitor::release() if not swap()'d
 
@@ -2164,26 +2563,25 @@ void ServerArrayHandler::handleResponse(osiSockAddr* responseFrom,
         }
 
         ChannelArray::shared_pointer channelArray = request->getChannelArray();
-        if (lastRequest)
-            channelArray->lastRequest();
 
+        ServerExecutor::Work::shared_pointer work;
         if (get)
         {
             size_t offset = SerializeHelper::readSize(payloadBuffer, transport.get());
             size_t count = SerializeHelper::readSize(payloadBuffer, transport.get());
             size_t stride = SerializeHelper::readSize(payloadBuffer, transport.get());
 
-            request->getChannelArray()->getArray(offset, count, stride);
+            work.reset(new ArrayWork(request, channelArray, lastRequest, ArrayWork::GetArray, offset, count, stride));
         }
         else if (setLength)
         {
             size_t length = SerializeHelper::readSize(payloadBuffer, transport.get());
 
-            request->getChannelArray()->setLength(length);
+            work.reset(new ArrayWork(request, channelArray, lastRequest, ArrayWork::SetLength, 0u, length));
         }
         else if (getLength)
         {
-            request->getChannelArray()->getLength();
+            work.reset(new ArrayWork(request, channelArray, lastRequest, ArrayWork::GetLength));
         }
         else
         {
@@ -2201,8 +2599,9 @@ void ServerArrayHandler::handleResponse(osiSockAddr* responseFrom,
                 );
             }
 
-            channelArray->putArray(array, offset, array->getLength(), stride);
+            work.reset(new ArrayWork(request, channelArray, lastRequest, ArrayWork::PutArray, offset, array->getLength(), stride, array));
         }
+        channel->execute(_context->getExecutor(), work);
     }
 }
 
@@ -2411,7 +2810,7 @@ void ServerDestroyRequestHandler::handleResponse(osiSockAddr* responseFrom,
         return;
     }
 
-    Destroyable::shared_pointer request = channel->getRequest(ioid);
+    BaseChannelRequester::shared_pointer request = channel->getRequest(ioid);
     if (!request.get())
     {
         failureResponse(transport, ioid, BaseChannelRequester::badIOIDStatus);
@@ -2419,7 +2818,8 @@ void ServerDestroyRequestHandler::handleResponse(osiSockAddr* responseFrom,
     }
     // atomic::add(request->bytesRX, payloadSize);
 
-    // destroy
+    // destroy, and drop any queued work
+    request->dropQueued();
     request->destroy();
 
     // ... and remove from channel
@@ -2467,6 +2867,8 @@ void ServerCancelRequestHandler::handleResponse(osiSockAddr* responseFrom,
         return;
     }
 
+    // cancel queued work, and any in progress
+    request->dropQueued();
     cr->cancel();
 }
 
@@ -2526,10 +2928,8 @@ void ServerProcessHandler::handleResponse(osiSockAddr* responseFrom,
             return;
         }
 
-        if (lastRequest)
-            request->getChannelProcess()->lastRequest();
-
-        request->getChannelProcess()->process();
+        ServerExecutor::Work::shared_pointer work(new ProcessWork(request, request->getChannelProcess(), lastRequest));
+        channel->execute(_context->getExecutor(), work);
     }
 }
 
@@ -2776,10 +3176,8 @@ void ServerRPCHandler::handleResponse(osiSockAddr* responseFrom,
             pvArgument = SerializationHelper::deserializeStructureFull(payloadBuffer, transport.get());
         );
 
-        if (lastRequest)
-            channelRPC->lastRequest();
-
-        channelRPC->request(pvArgument);
+        ServerExecutor::Work::shared_pointer work(new RPCWork(request, channelRPC, lastRequest, pvArgument));
+        channel->execute(_context->getExecutor(), work);
     }
 }
 
@@ -5,6 +5,7 @@
 
 #include <epicsMutex.h>
 #include <epicsGuard.h>
+#include <epicsString.h>
 
 #include <pv/sharedPtr.h>
 #include <pv/sharedVector.h>
@@ -18,6 +19,7 @@
 #include "pva/server.h"
 #include "pv/pvAccess.h"
 #include "pv/security.h"
+#include "pv/serverContext.h"
 #include "pv/reftrack.h"
 
 namespace pvd = epics::pvData;
@@ -28,6 +30,94 @@ typedef epicsGuardRelease<epicsMutex> UnGuard;
 
 namespace pvas {
 
+namespace {
+/* Name -> ChannelBuilder lookup table used for search and create channel.
+ * Names are hashed into independently locked shards,
+ * so concurrent lookups rarely contend with each other or with add()/remove().
+ */
+struct NameIndex {
+    typedef StaticProvider::ChannelBuilder::shared_pointer value_type;
+    typedef std::vector<std::pair<std::string, value_type> > bucket_t;
+
+    enum {nshards = 64};
+
+    static unsigned hash(const std::string& name) {
+        return epicsStrHash(name.c_str(), 0u);
+    }
+
+    struct Shard {
+        epicsMutex lock;
+        std::vector<bucket_t> buckets;
+        size_t count;
+        Shard() :buckets(8u), count(0u) {}
+
+        bucket_t& bucketOf(unsigned h) {
+            return buckets[(h/nshards) % buckets.size()];
+        }
+
+        void rehash(size_t nbuckets) {
+            std::vector<bucket_t> temp(nbuckets);
+            temp.swap(buckets);
+            for(size_t b=0u; b<temp.size(); b++) {
+                for(size_t i=0u; i<temp[b].size(); i++) {
+                    bucketOf(hash(temp[b][i].first)).push_back(temp[b][i]);
+                }
+            }
+        }
+    } shards[nshards];
+
+    value_type find(const std::string& name) {
+        const unsigned h = hash(name);
+        Shard& S = shards[h%nshards];
+        Guard G(S.lock);
+        const bucket_t& B = S.bucketOf(h);
+        for(size_t i=0u; i<B.size(); i++) {
+            if(B[i].first==name)
+                return B[i].second;
+        }
+        return value_type();
+    }
+
+    // caller ensures name is not already present
+    void insert(const std::string& name, const value_type& value) {
+        const unsigned h = hash(name);
+        Shard& S = shards[h%nshards];
+        Guard G(S.lock);
+        S.bucketOf(h).push_back(std::make_pair(name, value));
+        if(++S.count > 2u*S.buckets.size())
+            S.rehash(4u*S.buckets.size());
+    }
+
+    void erase(const std::string& name) {
+        const unsigned h = hash(name);
+        Shard& S = shards[h%nshards];
+        Guard G(S.lock);
+        bucket_t& B = S.bucketOf(h);
+        for(size_t i=0u; i<B.size(); i++) {
+            if(B[i].first==name) {
+                B[i] = B.back();
+                B.pop_back();
+                S.count--;
+                break;
+            }
+        }
+    }
+
+    void clear() {
+        for(size_t i=0u; i<nshards; i++) {
+            Shard& S = shards[i];
+            std::vector<bucket_t> temp(8u);
+            {
+                Guard G(S.lock);
+                temp.swap(S.buckets);
+                S.count = 0u;
+            }
+            // release references without lock
+        }
+    }
+};
+} // namespace
+
 struct StaticProvider::Impl : public pva::ChannelProvider
 {
     POINTER_DEFINITIONS(Impl);
@@ -41,7 +131,10 @@ struct StaticProvider::Impl : public pva::ChannelProvider
     mutable epicsMutex mutex;
 
     typedef StaticProvider::builders_t builders_t;
+    // guarded by mutex.  Used to iterate, and to serialize add()/remove()
     builders_t builders;
+    // copy of builders used for lookups, not guarded by mutex
+    NameIndex index;
 
     Impl(const std::string& name)
         :name(name)
@@ -58,13 +151,8 @@ struct StaticProvider::Impl : public pva::ChannelProvider
     virtual pva::ChannelFind::shared_pointer channelFind(std::string const & name,
                                                          pva::ChannelFindRequester::shared_pointer const & requester) OVERRIDE FINAL
     {
-        bool found;
-
-        {
-            Guard G(mutex);
+        bool found = !!index.find(name);
 
-            found =  builders.find(name)!=builders.end();
-        }
         requester->channelFindResult(pvd::Status(), finder, found);
         return finder;
     }
@@ -88,15 +176,7 @@ struct StaticProvider::Impl : public pva::ChannelProvider
         pva::Channel::shared_pointer ret;
         pvd::Status sts;
 
-        builders_t::mapped_type builder;
-        {
-            Guard G(mutex);
-            builders_t::const_iterator it(builders.find(name));
-            if(it!=builders.end()) {
-                UnGuard U(G);
-                builder = it->second;
-            }
-        }
+        builders_t::mapped_type builder(index.find(name));
         if(builder)
             ret = builder->connect(Impl::shared_pointer(internal_self), name, requester);
 
@@ -133,6 +213,7 @@ void StaticProvider::close(bool destroy)
         Guard G(impl->mutex);
         if(destroy) {
             pvs.swap(impl->builders); // consume
+            impl->index.clear();
         } else {
             pvs = impl->builders; // just copy, close() is a relatively rare action
         }
@@ -150,10 +231,15 @@ std::tr1::shared_ptr<epics::pvAccess::ChannelProvider> StaticProvider::provider(
 void StaticProvider::add(const std::string& name,
          const std::tr1::shared_ptr<ChannelBuilder>& builder)
 {
-    Guard G(impl->mutex);
-    if(impl->builders.find(name)!=impl->builders.end())
-        throw std::logic_error("Duplicate PV name");
-    impl->builders[name] = builder;
+    {
+        Guard G(impl->mutex);
+        if(impl->builders.find(name)!=impl->builders.end())
+            throw std::logic_error("Duplicate PV name");
+        impl->builders[name] = builder;
+        impl->index.insert(name, builder);
+    }
+    // name may have been cached as missing
+    pva::ServerContext::invalidateSearchCache();
 }
 
 std::tr1::shared_ptr<StaticProvider::ChannelBuilder> StaticProvider::remove(const std::string& name)
@@ -165,6 +251,7 @@ std::tr1::shared_ptr<StaticProvider::ChannelBuilder> StaticProvider::remove(cons
         if(it!=impl->builders.end()) {
             ret = it->second;
             impl->builders.erase(it);
+            impl->index.erase(name);
         }
     }
     if(ret)
@@ -60,6 +60,31 @@ std::tr1::shared_ptr<BaseChannelRequester> ServerChannel::getRequest(const pvAcc
     return BaseChannelRequester::shared_pointer();
 }
 
+void ServerChannel::getRequests(std::vector<std::tr1::shared_ptr<BaseChannelRequester> >& requests) const
+{
+    Lock guard(_mutex);
+    for(_requests_t::const_iterator it(_requests.begin()), end(_requests.end()); it!=end; ++it)
+        requests.push_back(it->second);
+}
+
+void ServerChannel::execute(const ServerExecutor::shared_pointer& executor,
+                            const ServerExecutor::Work::shared_pointer& work)
+{
+    if(!executor) {
+        work->run();
+        return;
+    }
+
+    ServerExecutor::Strand::shared_pointer strand;
+    {
+        Lock guard(_mutex);
+        if(!_strand)
+            _strand.reset(new ServerExecutor::Strand);
+        strand = _strand;
+    }
+    executor->execute(strand, work);
+}
+
 void ServerChannel::destroy()
 {
     _requests_t reqs;
@@ -84,6 +109,7 @@ void ServerChannel::destroy()
     for(_requests_t::const_iterator it=reqs.begin(), end=reqs.end(); it!=end; ++it)
     {
         const _requests_t::mapped_type& req = it->second;
+        req->dropQueued();
         // will call unregisterRequest() which is now a no-op
         req->destroy();
         // May still be in the send queue
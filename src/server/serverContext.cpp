@@ -4,7 +4,10 @@
  * in file LICENSE that is included with this distribution.
  */
 
+#include <set>
+
 #include <epicsSignal.h>
+#include <epicsAtomic.h>
 
 #include <pv/lock.h>
 #include <pv/timer.h>
@@ -31,7 +34,153 @@ const Version ServerContextImpl::VERSION("pvAccess Server", "cpp",
 
 size_t ServerContextImpl::num_instances;
 
+namespace {
+// incremented by ServerContext::invalidateSearchCache()
+size_t searchCacheGeneration;
+}
+
+void ServerContext::invalidateSearchCache()
+{
+    atomic::increment(searchCacheGeneration);
+}
+
+SearchNegativeCache::SearchNegativeCache()
+    :_enabled(0)
+    ,_timeout(0.0)
+    ,_generation(0u)
+{
+    epicsTimeGetCurrent(&_rotated);
+}
+
+void SearchNegativeCache::configure(double timeout)
+{
+    Lock G(_mutex);
+    _timeout = timeout;
+    _current.clear();
+    _previous.clear();
+    atomic::set(_enabled, timeout>0.0 ? 1 : 0);
+}
+
+double SearchNegativeCache::getTimeout() const
+{
+    Lock G(_mutex);
+    return _timeout;
+}
+
+bool SearchNegativeCache::enabled() const
+{
+    return atomic::get(_enabled)!=0;
+}
+
+size_t SearchNegativeCache::generation()
+{
+    return atomic::get(searchCacheGeneration);
+}
+
+void SearchNegativeCache::expire()
+{
+    const size_t gen = generation();
+    if(gen!=_generation) {
+        // some provider has added a channel
+        _current.clear();
+        _previous.clear();
+        _generation = gen;
+    }
+
+    epicsTimeStamp now;
+    epicsTimeGetCurrent(&now);
+    double age = epicsTimeDiffInSeconds(&now, &_rotated);
+
+    if(age >= 2.0*_timeout || age < 0.0) {
+        _current.clear();
+        _previous.clear();
+        _rotated = now;
+
+    } else if(age >= _timeout || _current.size() >= MAX_ENTRIES) {
+        _previous.swap(_current);
+        _current.clear();
+        _rotated = now;
+    }
+}
+
+bool SearchNegativeCache::missing(const std::string& name)
+{
+    if(!enabled())
+        return false;
+
+    const size_t hash = Names::hash(name);
+    Lock G(_mutex);
+    expire();
+    return _current.has(hash, name) || _previous.has(hash, name);
+}
+
+void SearchNegativeCache::add(const std::string& name, size_t generation)
+{
+    if(!enabled())
+        return;
+
+    Lock G(_mutex);
+    expire();
+    if(generation==_generation)
+        _current.insert(Names::hash(name), name);
+}
+
+size_t SearchNegativeCache::Names::hash(const std::string& name)
+{
+    // FNV-1a
+    size_t H = 2166136261u;
+    for(size_t i=0, N=name.size(); i<N; i++) {
+        H ^= (unsigned char)name[i];
+        H *= 16777619u;
+    }
+    return H;
+}
+
+bool SearchNegativeCache::Names::has(size_t hash, const std::string& name) const
+{
+    if(_count==0u)
+        return false;
+    const bucket_t& B = _buckets[hash%NBUCKETS];
+    for(size_t i=0, N=B.size(); i<N; i++) {
+        if(B[i].first==hash && B[i].second==name)
+            return true;
+    }
+    return false;
+}
+
+void SearchNegativeCache::Names::insert(size_t hash, const std::string& name)
+{
+    if(has(hash, name))
+        return;
+    if(_buckets.empty())
+        _buckets.resize(NBUCKETS);
+    _buckets[hash%NBUCKETS].push_back(std::make_pair(hash, name));
+    _count++;
+}
+
+void SearchNegativeCache::Names::clear()
+{
+    if(_count==0u)
+        return;
+    for(size_t i=0; i<_buckets.size(); i++)
+        _buckets[i].clear();
+    _count = 0u;
+}
+
+void SearchNegativeCache::Names::swap(Names& o)
+{
+    _buckets.swap(o._buckets);
+    std::swap(_count, o._count);
+}
+
+size_t SearchNegativeCache::size() const
+{
+    Lock G(_mutex);
+    return _current.size() + _previous.size();
+}
+
 ServerContextImpl::ServerContextImpl():
+    _searchRequests(0u),
     _beaconAddressList(),
     _ignoreAddressList(),
     _autoBeaconAddressList(true),
@@ -39,9 +188,14 @@ ServerContextImpl::ServerContextImpl():
     _broadcastPort(PVA_BROADCAST_PORT),
     _serverPort(PVA_SERVER_PORT),
     _receiveBufferSize(MAX_TCP_RECV),
+    _searchThreads(1),
+    _tcpBacklog(BlockingTCPAcceptor::DEFAULT_BACKLOG),
+    _acceptThreads(1),
+    _workerThreads(0),
+    _metricsPeriod(1.0),
     _timer(new Timer("PVAS timers", lowerPriority)),
     _beaconEmitter(),
-    _acceptor(),
+    _acceptors(),
     _transportRegistry(),
     _channelProviders(),
     _beaconServerStatusProvider(),
@@ -146,6 +300,35 @@ void ServerContextImpl::loadConfiguration()
     _receiveBufferSize = config->getPropertyAsInteger("EPICS_PVA_MAX_ARRAY_BYTES", _receiveBufferSize);
     _receiveBufferSize = config->getPropertyAsInteger("EPICS_PVAS_MAX_ARRAY_BYTES", _receiveBufferSize);
 
+    _searchThreads = config->getPropertyAsInteger("EPICS_PVAS_SEARCH_THREADS", _searchThreads);
+    if(_searchThreads < 1)
+        _searchThreads = 1;
+
+    _tcpBacklog = config->getPropertyAsInteger("EPICS_PVAS_TCP_BACKLOG", _tcpBacklog);
+    if(_tcpBacklog < 1)
+        _tcpBacklog = BlockingTCPAcceptor::DEFAULT_BACKLOG;
+
+    _acceptThreads = config->getPropertyAsInteger("EPICS_PVAS_ACCEPT_THREADS", _acceptThreads);
+    if(_acceptThreads < 1)
+        _acceptThreads = 1;
+#ifndef SO_REUSEPORT
+    if(_acceptThreads > 1) {
+        LOG(logLevelWarn, "SO_REUSEPORT not supported, using one TCP acceptor.");
+        _acceptThreads = 1;
+    }
+#endif
+
+    _workerThreads = config->getPropertyAsInteger("EPICS_PVAS_WORKER_THREADS", _workerThreads);
+    if(_workerThreads < 0)
+        _workerThreads = 0;
+
+    _searchNegativeCache.configure(config->getPropertyAsDouble("EPICS_PVAS_SEARCH_NEGATIVE_CACHE_TMO", 0.0));
+
+    _metricsPrefix = config->getPropertyAsString("EPICS_PVAS_METRICS_PREFIX", _metricsPrefix);
+    _metricsPeriod = config->getPropertyAsDouble("EPICS_PVAS_METRICS_PERIOD", _metricsPeriod);
+    if(_metricsPeriod <= 0.0)
+        _metricsPeriod = 1.0;
+
     if(_channelProviders.empty()) {
         std::string providers = config->getPropertyAsString("EPICS_PVAS_PROVIDER_NAMES", PVACCESS_DEFAULT_PROVIDER);
 
@@ -215,6 +398,8 @@ ServerContextImpl::getCurrentConfig()
 
     std::ostringstream providerName;
     for(size_t i=0; i<_channelProviders.size(); i++) {
+        if(_metrics && _channelProviders[i]==_metrics->getProvider())
+            continue; // not a registered provider
         if(i>0)
             providerName<<" ";
         providerName<<_channelProviders[i]->getProviderName();
@@ -251,6 +436,20 @@ ServerContextImpl::getCurrentConfig()
 
     SET("EPICS_PVAS_PROVIDER_NAMES", providerName.str());
 
+    SET("EPICS_PVAS_SEARCH_THREADS", _searchThreads);
+
+    SET("EPICS_PVAS_TCP_BACKLOG", _tcpBacklog);
+
+    SET("EPICS_PVAS_ACCEPT_THREADS", _acceptThreads);
+
+    SET("EPICS_PVAS_WORKER_THREADS", _workerThreads);
+
+    SET("EPICS_PVAS_SEARCH_NEGATIVE_CACHE_TMO", _searchNegativeCache.getTimeout());
+
+    SET("EPICS_PVAS_METRICS_PREFIX", _metricsPrefix);
+
+    SET("EPICS_PVAS_METRICS_PERIOD", _metricsPeriod);
+
 #undef SET
 
     return B.push_map().build();
@@ -273,12 +472,35 @@ void ServerContextImpl::initialize()
     // we create reference cycles here which are broken by our shutdown() method,
     _responseHandler.reset(new ServerResponseHandler(thisServerContext));
 
-    _acceptor.reset(new BlockingTCPAcceptor(thisServerContext, _responseHandler, _ifaceAddr, _receiveBufferSize));
-    _serverPort = ntohs(_acceptor->getBindAddress()->ia.sin_port);
+    if(_workerThreads > 0)
+        _executor.reset(new ServerExecutor(_workerThreads));
+
+    if(!_metricsPrefix.empty()) {
+        // before searches are answered, so _channelProviders is effectively still const
+        _metrics.reset(new ServerMetrics(_metricsPrefix, _metricsPeriod, thisServerContext));
+        _metrics->start();
+        _channelProviders.push_back(_metrics->getProvider());
+    }
+
+    {
+        // with several acceptors, the first selects the port (maybe dynamically)
+        // and the others listen on the same port
+        BlockingTCPAcceptor::ReusePort reuse = _acceptThreads>1 ? BlockingTCPAcceptor::ReuseFirst : BlockingTCPAcceptor::ReuseNone;
+        osiSockAddr bindAddr(_ifaceAddr);
+        for(int32 i=0; i<_acceptThreads; i++) {
+            BlockingTCPAcceptor::shared_pointer acceptor(new BlockingTCPAcceptor(thisServerContext, _responseHandler, bindAddr,
+                                                                                 _receiveBufferSize, _tcpBacklog, reuse));
+            _acceptors.push_back(acceptor);
+            bindAddr = *acceptor->getBindAddress();
+            reuse = BlockingTCPAcceptor::ReuseShared;
+        }
+    }
+    _serverPort = ntohs(_acceptors[0]->getBindAddress()->ia.sin_port);
 
     // setup broadcast UDP transport
     initializeUDPTransports(true, _udpTransports, _ifaceList, _responseHandler, _broadcastTransport,
-                            _broadcastPort, _autoBeaconAddressList, _beaconAddressList, _ignoreAddressList);
+                            _broadcastPort, _autoBeaconAddressList, _beaconAddressList, _ignoreAddressList,
+                            _searchThreads);
 
     _beaconEmitter.reset(new BeaconEmitter("tcp", _broadcastTransport, thisServerContext));
 
@@ -305,6 +527,10 @@ void ServerContextImpl::shutdown()
     if(!_timer)
         return; // already shutdown
 
+    // stop updating metrics, and disconnect metrics clients
+    if (_metrics)
+        _metrics->close();
+
     // abort pending timers and prevent new timers from starting
     _timer->close();
 
@@ -339,16 +565,26 @@ void ServerContextImpl::shutdown()
     }
 
     // stop accepting connections
-    if (_acceptor)
+    for(size_t i=0; i<_acceptors.size(); i++)
     {
-        _acceptor->destroy();
-        LEAK_CHECK(_acceptor, "_acceptor")
-        _acceptor.reset();
+        _acceptors[i]->destroy();
+        LEAK_CHECK(_acceptors[i], "_acceptor")
     }
+    _acceptors.clear();
 
     // this will also destroy all channels
     _transportRegistry.clear();
 
+    // drop provider operations not yet started
+    if (_executor)
+    {
+        _executor->close();
+        _executor.reset();
+    }
+
+    // metrics hold a reference to the timer
+    _metrics.reset();
+
     // drop timer queue
     LEAK_CHECK(_timer, "_timer")
     _timer.reset();
@@ -382,11 +618,54 @@ void ServerContextImpl::printInfo(ostream& str, int lvl)
         SHOW(EPICS_PVAS_BROADCAST_PORT)
         SHOW(EPICS_PVAS_SERVER_PORT)
         SHOW(EPICS_PVAS_PROVIDER_NAMES)
+        SHOW(EPICS_PVAS_SEARCH_THREADS)
+        SHOW(EPICS_PVAS_TCP_BACKLOG)
+        SHOW(EPICS_PVAS_ACCEPT_THREADS)
+        SHOW(EPICS_PVAS_WORKER_THREADS)
+        SHOW(EPICS_PVAS_SEARCH_NEGATIVE_CACHE_TMO)
+        SHOW(EPICS_PVAS_METRICS_PREFIX)
+        SHOW(EPICS_PVAS_METRICS_PERIOD)
 #undef SHOW
 
     } else {
         // lvl >= 1
 
+        str<<"UDP:\n";
+        for (BlockingUDPTransportVector::const_iterator it(_udpTransports.begin()), end(_udpTransports.end());
+             it != end; ++it)
+        {
+            BlockingUDPTransport::Stats stats;
+            (*it)->getStats(stats);
+            str<<"  "<<(*it)->getType()<<"://"<<(*it)->getRemoteName()
+               <<" rx "<<stats.recvDatagrams<<" datagrams in "<<stats.recvCalls<<" calls,"
+               <<" tx "<<stats.sendDatagrams<<" datagrams in "<<stats.sendCalls<<" calls\n";
+        }
+        str<<"  search requests "<<atomic::get(_searchRequests)<<"\n";
+
+        str<<"TCP:\n";
+        for(size_t i=0; i<_acceptors.size(); i++)
+        {
+            BlockingTCPAcceptor::Stats stats;
+            _acceptors[i]->getStats(stats);
+            str<<"  tcp://"<<inetAddressToString(*_acceptors[i]->getBindAddress())
+               <<" backlog "<<_acceptors[i]->getBacklog()
+               <<" accepted "<<stats.accepted
+               <<", accept queue peak "<<stats.acceptQueuePeak<<" full "<<stats.acceptQueueFull<<" times"
+               <<", setup queue peak "<<stats.setupQueuePeak<<"\n";
+        }
+        {
+            size_t overflows = 0u, drops = 0u;
+            if(BlockingTCPAcceptor::getListenOverflows(overflows, drops))
+                str<<"  system wide listen queue overflows "<<overflows<<", drops "<<drops<<"\n";
+        }
+
+        if(_executor) {
+            ServerExecutor::Stats stats;
+            _executor->getStats(stats);
+            str<<"Workers: "<<_executor->workerCount()
+               <<" executed "<<stats.executed<<", pending "<<stats.pending<<" peak "<<stats.pendingPeak<<"\n";
+        }
+
         TransportRegistry::transportVector_t transports;
         _transportRegistry.toArray(transports);
 
@@ -492,9 +771,9 @@ BeaconServerStatusProvider::shared_pointer ServerContextImpl::getBeaconServerSta
 
 const osiSockAddr* ServerContextImpl::getServerInetAddress()
 {
-    if(_acceptor.get())
+    if(!_acceptors.empty())
     {
-        return const_cast<osiSockAddr*>(_acceptor->getBindAddress());
+        return const_cast<osiSockAddr*>(_acceptors[0]->getBindAddress());
     }
     return NULL;
 }
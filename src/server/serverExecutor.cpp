@@ -0,0 +1,145 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * pvAccessCPP is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <stdexcept>
+
+#include <epicsThread.h>
+
+#define epicsExportSharedSymbols
+#include <pv/serverExecutor.h>
+#include <pv/logger.h>
+
+namespace pvd = epics::pvData;
+
+namespace epics {
+namespace pvAccess {
+
+ServerExecutor::ServerExecutor(size_t nworkers)
+    :closed(false)
+{
+    if(nworkers==0u)
+        nworkers = 1u;
+
+    workers.reserve(nworkers);
+    try {
+        for(size_t i=0u; i<nworkers; i++) {
+            std::tr1::shared_ptr<pvd::Thread> W(new pvd::Thread(pvd::Thread::Config(this, &ServerExecutor::worker)
+                                                                 .prio(epicsThreadPriorityCAServerLow)
+                                                                 .name("PVAS-worker")
+                                                                 .stack(epicsThreadStackBig)
+                                                                 .autostart(false)));
+            W->start();
+            workers.push_back(W);
+        }
+    } catch(...) {
+        close();
+        throw;
+    }
+}
+
+ServerExecutor::~ServerExecutor()
+{
+    close();
+}
+
+void ServerExecutor::execute(const Strand::shared_pointer& strand, const Work::shared_pointer& work)
+{
+    {
+        pvd::Lock G(mutex);
+        if(closed)
+            return;
+
+        strand->queue.push_back(work);
+        stats.pending++;
+        if(stats.pendingPeak < stats.pending)
+            stats.pendingPeak = stats.pending;
+
+        if(strand->scheduled)
+            return; // already ready, or being run
+
+        strand->scheduled = true;
+        ready.push_back(strand);
+    }
+    wakeup.signal();
+}
+
+void ServerExecutor::close()
+{
+    {
+        pvd::Lock G(mutex);
+        if(closed)
+            return;
+        closed = true;
+    }
+    wakeup.signal();
+
+    for(size_t i=0u; i<workers.size(); i++)
+        workers[i]->exitWait();
+
+    std::list<Work::shared_pointer> dropped;
+    {
+        pvd::Lock G(mutex);
+        for(size_t i=0u; i<ready.size(); i++) {
+            stats.pending -= ready[i]->queue.size();
+            dropped.splice(dropped.end(), ready[i]->queue);
+            ready[i]->scheduled = false;
+        }
+        ready.clear();
+    }
+    // release Work outside of lock
+}
+
+void ServerExecutor::getStats(Stats& stats) const
+{
+    pvd::Lock G(mutex);
+    stats = this->stats;
+}
+
+void ServerExecutor::worker()
+{
+    pvd::Lock G(mutex);
+    while(!closed) {
+        if(ready.empty()) {
+            G.unlock();
+            wakeup.wait();
+            G.lock();
+            continue;
+        }
+
+        // run one Work at a time from each ready Strand, round robin
+        Strand::shared_pointer strand(ready.front());
+        ready.pop_front();
+
+        Work::shared_pointer work(strand->queue.front());
+        strand->queue.pop_front();
+
+        if(!ready.empty())
+            wakeup.signal(); // wake another worker
+
+        G.unlock();
+
+        try {
+            work->run();
+        } catch(std::exception& e) {
+            LOG(logLevelError, "Unhandled exception in server worker: %s", e.what());
+        }
+        work.reset();
+
+        G.lock();
+        stats.executed++;
+        stats.pending--;
+        if(strand->queue.empty() || closed) {
+            strand->scheduled = false;
+        } else {
+            ready.push_back(strand);
+        }
+    }
+    // pass on to the next worker
+    wakeup.signal();
+}
+
+}
+}
@@ -0,0 +1,331 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * pvAccessCPP is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <vector>
+
+#include <epicsAtomic.h>
+#include <epicsTime.h>
+
+#include <pv/standardField.h>
+#include <pv/lock.h>
+
+#define epicsExportSharedSymbols
+#include <pv/serverMetrics.h>
+#include <pv/serverContextImpl.h>
+#include <pv/responseHandlers.h>
+#include <pv/codec.h>
+#include <pv/logger.h>
+
+namespace pvd = epics::pvData;
+
+namespace epics {
+namespace pvAccess {
+
+namespace {
+
+pvd::StructureConstPtr scalarType(pvd::ScalarType stype)
+{
+    return pvd::getFieldCreate()->createFieldBuilder()
+            ->setId("epics:nt/NTScalar:1.0")
+            ->add("value", stype)
+            ->add("timeStamp", pvd::getStandardField()->timeStamp())
+            ->createStructure();
+}
+
+// columns of the clients table.
+struct Column {
+    const char *name;
+    pvd::ScalarType type;
+};
+const Column columns[] = {
+    {"peer", pvd::pvString},
+    {"channels", pvd::pvULong},
+    {"monitors", pvd::pvULong},
+    {"rxRate", pvd::pvDouble},
+    {"txRate", pvd::pvDouble},
+    {"sendQueue", pvd::pvULong},
+    {"monitorQueue", pvd::pvULong},
+    {"monitorOverruns", pvd::pvULong},
+};
+const size_t ncolumns = sizeof(columns)/sizeof(columns[0]);
+
+pvd::StructureConstPtr tableType()
+{
+    pvd::FieldBuilderPtr builder(pvd::getFieldCreate()->createFieldBuilder()
+                                 ->setId("epics:nt/NTTable:1.0")
+                                 ->addArray("labels", pvd::pvString)
+                                 ->addNestedStructure("value"));
+    for(size_t i=0; i<ncolumns; i++)
+        builder = builder->addArray(columns[i].name, columns[i].type);
+    return builder->endNested()
+            ->add("timeStamp", pvd::getStandardField()->timeStamp())
+            ->createStructure();
+}
+
+void stamp(pvd::PVStructure& value, const epicsTimeStamp& now, pvd::BitSet& changed)
+{
+    pvd::PVStructurePtr ts(value.getSubFieldT<pvd::PVStructure>("timeStamp"));
+    ts->getSubFieldT<pvd::PVLong>("secondsPastEpoch")->put(now.secPastEpoch+POSIX_TIME_AT_EPICS_EPOCH);
+    ts->getSubFieldT<pvd::PVInt>("nanoseconds")->put(now.nsec);
+    changed.set(ts->getFieldOffset());
+}
+
+template<typename T>
+void postScalar(const pvas::SharedPV::shared_pointer& pv, pvd::PVStructure& value, T val, const epicsTimeStamp& now)
+{
+    pvd::BitSet changed;
+    pvd::PVScalarPtr field(value.getSubFieldT<pvd::PVScalar>("value"));
+    field->putFrom<T>(val);
+    changed.set(field->getFieldOffset());
+    stamp(value, now, changed);
+    pv->post(value, changed);
+}
+
+} // namespace
+
+struct ServerMetrics::Handler : public pvas::SharedPV::Handler {
+    const ServerMetrics::weak_pointer metrics;
+    explicit Handler(const ServerMetrics::shared_pointer& metrics) :metrics(metrics) {}
+    virtual ~Handler() {}
+    virtual void onFirstConnect(const pvas::SharedPV::shared_pointer& pv) OVERRIDE FINAL
+    {
+        ServerMetrics::shared_pointer M(metrics.lock());
+        if(M)
+            M->subscribe();
+    }
+    virtual void onLastDisconnect(const pvas::SharedPV::shared_pointer& pv) OVERRIDE FINAL
+    {
+        ServerMetrics::shared_pointer M(metrics.lock());
+        if(M)
+            M->unsubscribe();
+    }
+};
+
+const char ServerMetrics::providerName[] = "server-metrics";
+
+ServerMetrics::ServerMetrics(const std::string& prefix, double period,
+                             const std::tr1::shared_ptr<ServerContextImpl>& context)
+    :period(period>0.0 ? period : 1.0)
+    ,context(context)
+    ,timer(context->getTimer())
+    ,provider(providerName)
+    ,subscribers(0u)
+    ,closed(false)
+    ,restart(true)
+    ,prevSearches(0u)
+    ,scalarValue(pvd::getPVDataCreate()->createPVStructure(scalarType(pvd::pvULong)))
+    ,doubleValue(pvd::getPVDataCreate()->createPVStructure(scalarType(pvd::pvDouble)))
+    ,tableValue(pvd::getPVDataCreate()->createPVStructure(tableType()))
+{
+    prevTime.secPastEpoch = prevTime.nsec = 0u;
+
+    pvd::PVStringArray::svector labels(ncolumns);
+    for(size_t i=0; i<ncolumns; i++)
+        labels[i] = columns[i].name;
+    tableValue->getSubFieldT<pvd::PVStringArray>("labels")->replace(pvd::freeze(labels));
+
+    pvas::SharedPV::shared_pointer *pvs[] = {&connections, &channels, &rxRate, &txRate, &searchRate, &workQueue, &clients};
+    const char *names[] = {"connections", "channels", "rxRate", "txRate", "searchRate", "workQueue", "clients"};
+
+    for(size_t i=0; i<sizeof(pvs)/sizeof(pvs[0]); i++) {
+        // Handler is set by start(), once shared_from_this() is valid
+        pvas::SharedPV::shared_pointer pv(pvas::SharedPV::buildReadOnly());
+        if(pvs[i]==&clients)
+            pv->open(*tableValue);
+        else if(pvs[i]==&rxRate || pvs[i]==&txRate || pvs[i]==&searchRate)
+            pv->open(*doubleValue);
+        else
+            pv->open(*scalarValue);
+        provider.add(prefix+names[i], pv);
+        *pvs[i] = pv;
+    }
+}
+
+ServerMetrics::~ServerMetrics() {}
+
+void ServerMetrics::start()
+{
+    std::tr1::shared_ptr<Handler> handler(new Handler(shared_from_this()));
+    const pvas::SharedPV::shared_pointer pvs[] = {connections, channels, rxRate, txRate, searchRate, workQueue, clients};
+    for(size_t i=0; i<sizeof(pvs)/sizeof(pvs[0]); i++)
+        pvs[i]->setHandler(handler);
+}
+
+void ServerMetrics::close()
+{
+    {
+        pvd::Lock G(mutex);
+        if(closed)
+            return;
+        closed = true;
+        subscribers = 0u;
+        timer->cancel(shared_from_this());
+    }
+    provider.close(true);
+}
+
+// Timer calls are made with mutex held, so that a cancel by the last unsubscribe()
+// can not be re-ordered with the schedule of the next first subscribe().
+// The timer does not hold its lock while running callback(), which also locks mutex.
+
+void ServerMetrics::subscribe()
+{
+    pvd::Lock G(mutex);
+    if(closed || subscribers++>0u)
+        return;
+    restart = true;
+    // first subscriber
+    timer->schedulePeriodic(shared_from_this(), 0.0, period);
+}
+
+void ServerMetrics::unsubscribe()
+{
+    pvd::Lock G(mutex);
+    if(closed || subscribers==0u || --subscribers>0u)
+        return;
+    // last subscriber
+    timer->cancel(shared_from_this());
+}
+
+void ServerMetrics::timerStopped() {}
+
+void ServerMetrics::callback()
+{
+    try {
+        update();
+    } catch(std::exception& e) {
+        LOG(logLevelError, "Error updating server metrics: %s", e.what());
+    }
+}
+
+void ServerMetrics::update()
+{
+    std::tr1::shared_ptr<ServerContextImpl> ctx(context.lock());
+    if(!ctx)
+        return;
+
+    bool first;
+    {
+        pvd::Lock G(mutex);
+        if(closed)
+            return;
+        first = restart;
+        restart = false;
+    }
+
+    epicsTimeStamp now;
+    epicsTimeGetCurrent(&now);
+    const double dt = first ? 0.0 : epicsTimeDiffInSeconds(&now, &prevTime);
+
+    TransportRegistry::transportVector_t transports;
+    ctx->getTransportRegistry()->toArray(transports);
+
+    pvd::PVStringArray::svector peer;
+    pvd::PVULongArray::svector nchannels, nmonitors, sendQueue, monitorQueue, monitorOverruns;
+    pvd::PVDoubleArray::svector rx, tx;
+
+    size_t totalChannels = 0u;
+    double totalRX = 0.0, totalTX = 0.0;
+    samples_t current;
+
+    std::vector<ServerChannel::shared_pointer> chans;
+    std::vector<BaseChannelRequester::shared_pointer> requests;
+
+    for(TransportRegistry::transportVector_t::const_iterator it(transports.begin()), end(transports.end());
+        it!=end; ++it)
+    {
+        const Transport::shared_pointer& transport(*it);
+        const detail::BlockingServerTCPTransportCodec *tcp = dynamic_cast<const detail::BlockingServerTCPTransportCodec*>(transport.get());
+        if(!tcp)
+            continue;
+
+        Sample& sample = current[transport->getRemoteName()];
+        sample.rx = epics::atomic::get(transport->_totalBytesRecv);
+        sample.tx = epics::atomic::get(transport->_totalBytesSent);
+
+        double rxRate = 0.0, txRate = 0.0;
+        samples_t::const_iterator prev(previous.find(transport->getRemoteName()));
+        if(dt>0.0 && prev!=previous.end()) {
+            rxRate = (sample.rx - prev->second.rx)/dt;
+            txRate = (sample.tx - prev->second.tx)/dt;
+        }
+
+        chans.clear();
+        tcp->getChannels(chans);
+
+        size_t monitors = 0u, filled = 0u, overruns = 0u;
+        for(size_t c=0; c<chans.size(); c++) {
+            requests.clear();
+            chans[c]->getRequests(requests);
+            for(size_t r=0; r<requests.size(); r++) {
+                ServerMonitorRequesterImpl *mon = dynamic_cast<ServerMonitorRequesterImpl*>(requests[r].get());
+                if(!mon)
+                    continue;
+                Monitor::shared_pointer M(mon->getChannelMonitor());
+                if(!M)
+                    continue;
+                Monitor::Stats stats;
+                M->getStats(stats);
+                monitors++;
+                filled += stats.nfilled;
+                overruns += stats.noverrun;
+            }
+        }
+
+        peer.push_back(transport->getRemoteName());
+        nchannels.push_back(chans.size());
+        nmonitors.push_back(monitors);
+        rx.push_back(rxRate);
+        tx.push_back(txRate);
+        sendQueue.push_back(tcp->sendQueueSize());
+        monitorQueue.push_back(filled);
+        monitorOverruns.push_back(overruns);
+
+        totalChannels += chans.size();
+        totalRX += rxRate;
+        totalTX += txRate;
+    }
+
+    const size_t searches = epics::atomic::get(ctx->_searchRequests);
+    const double searchesPerSec = dt>0.0 ? (searches - prevSearches)/dt : 0.0;
+
+    size_t pending = 0u;
+    if(ctx->getExecutor()) {
+        ServerExecutor::Stats stats;
+        ctx->getExecutor()->getStats(stats);
+        pending = stats.pending;
+    }
+
+    previous.swap(current);
+    prevSearches = searches;
+    prevTime = now;
+
+    postScalar<pvd::uint64>(connections, *scalarValue, peer.size(), now);
+    postScalar<pvd::uint64>(channels, *scalarValue, totalChannels, now);
+    postScalar<pvd::uint64>(workQueue, *scalarValue, pending, now);
+    postScalar<double>(rxRate, *doubleValue, totalRX, now);
+    postScalar<double>(txRate, *doubleValue, totalTX, now);
+    postScalar<double>(searchRate, *doubleValue, searchesPerSec, now);
+
+    {
+        pvd::BitSet changed;
+        pvd::PVStructurePtr value(tableValue->getSubFieldT<pvd::PVStructure>("value"));
+        value->getSubFieldT<pvd::PVStringArray>("peer")->replace(pvd::freeze(peer));
+        value->getSubFieldT<pvd::PVULongArray>("channels")->replace(pvd::freeze(nchannels));
+        value->getSubFieldT<pvd::PVULongArray>("monitors")->replace(pvd::freeze(nmonitors));
+        value->getSubFieldT<pvd::PVDoubleArray>("rxRate")->replace(pvd::freeze(rx));
+        value->getSubFieldT<pvd::PVDoubleArray>("txRate")->replace(pvd::freeze(tx));
+        value->getSubFieldT<pvd::PVULongArray>("sendQueue")->replace(pvd::freeze(sendQueue));
+        value->getSubFieldT<pvd::PVULongArray>("monitorQueue")->replace(pvd::freeze(monitorQueue));
+        value->getSubFieldT<pvd::PVULongArray>("monitorOverruns")->replace(pvd::freeze(monitorOverruns));
+        changed.set(value->getFieldOffset());
+        stamp(*tableValue, now, changed);
+        clients->post(*tableValue, changed);
+    }
+}
+
+}
+}
@@ -7,6 +7,8 @@
 
 #include <epicsMutex.h>
 #include <epicsGuard.h>
+#include <epicsAtomic.h>
+#include <epicsTime.h>
 #include <errlog.h>
 
 #include <shareLib.h>
@@ -24,6 +26,9 @@
 
 
 namespace {
+// source of MonitorElement::Trace::id .  0 is reserved for "not traced"
+size_t traceIds;
+
 struct MailboxHandler : public pvas::SharedPV::Handler {
     virtual ~MailboxHandler() {}
     virtual void onPut(const pvas::SharedPV::shared_pointer& self, pvas::Operation& op) OVERRIDE FINAL
@@ -42,6 +47,8 @@ namespace pvas {
 
 SharedPV::Handler::~Handler() {}
 
+BufferReleaser::~BufferReleaser() {}
+
 void SharedPV::Handler::onPut(const SharedPV::shared_pointer& pv, Operation& op)
 {
     op.complete(pvd::Status::error("Put not supported"));
@@ -349,6 +356,9 @@ void SharedPV::post(const pvd::PVStructure& value,
 
         p_monitor.reserve(monitors.size()); // ick, for lack of a list with thread-safe iteration
 
+        // stamped only if some subscriber asked for tracing
+        pva::MonitorElement::Trace trace;
+
         FOR_EACH(monitors_t::const_iterator, it, end, monitors) {
             std::tr1::shared_ptr<pva::MonitorFIFO> self;
             try {
@@ -356,7 +366,17 @@ void SharedPV::post(const pvd::PVStructure& value,
             }catch(std::tr1::bad_weak_ptr&) {
                 continue; //racing destruction
             }
-            (*it)->post(value, changed);
+            if(!(*it)->traced()) {
+                (*it)->post(value, changed);
+            } else {
+                if(!trace.id) {
+                    do {
+                        trace.id = epics::atomic::increment(traceIds);
+                    } while(!trace.id);
+                    epicsTimeGetCurrent(&trace.posted);
+                }
+                (*it)->post(value, changed, pvd::BitSet(), trace);
+            }
             p_monitor.push_back(self);
         }
     }
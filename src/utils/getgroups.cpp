@@ -5,6 +5,15 @@
 */
 
 #include <set>
+#include <map>
+#include <deque>
+#include <string>
+
+#include <epicsMutex.h>
+#include <epicsGuard.h>
+#include <epicsEvent.h>
+#include <epicsThread.h>
+#include <epicsTime.h>
 
 #if defined(_WIN32)
 #  define USE_LANMAN
@@ -42,6 +51,11 @@ typedef gid_t osi_gid_t;
 
 #define epicsExportSharedSymbols
 #include <pv/security.h>
+#include <pv/configuration.h>
+#include <pv/logger.h>
+
+typedef epicsGuard<epicsMutex> Guard;
+typedef epicsGuardRelease<epicsMutex> UnGuard;
 
 namespace epics {
 namespace pvAccess {
@@ -178,4 +192,196 @@ void osdGetRoles(const std::string& account, PeerInfo::roles_t& roles)
 {}
 #endif
 
+struct RolesCache::Pvt : public epicsThreadRunable {
+    struct Entry {
+        // held while looking up this account.  Concurrent callers wait for one lookup.
+        epicsMutex lookup;
+        // remaining guarded by Pvt::mutex
+        PeerInfo::roles_t roles;
+        epicsTimeStamp fetched;
+        bool valid; // roles and fetched have been set
+        bool refreshing; // on refresh queue, or being refreshed
+        Entry() :valid(false), refreshing(false) {}
+    };
+    typedef std::map<std::string, std::tr1::shared_ptr<Entry> > entries_t;
+
+    const double timeout;
+    const lookup_t lookupFn;
+
+    epicsMutex mutex;
+    entries_t entries;
+    std::deque<std::string> refreshQueue;
+    bool stopping;
+
+    epicsEvent wakeup;
+    // NULL when the cache is disabled
+    epics::auto_ptr<epicsThread> refresher;
+
+    Pvt(double timeout, lookup_t lookupFn)
+        :timeout(timeout)
+        ,lookupFn(lookupFn)
+        ,stopping(false)
+    {
+        if(timeout>0.0) {
+            refresher.reset(new epicsThread(*this, "PVARoles",
+                                            epicsThreadGetStackSize(epicsThreadStackSmall),
+                                            epicsThreadPriorityLow));
+            refresher->start();
+        }
+    }
+    virtual ~Pvt() {
+        if(refresher.get()) {
+            {
+                Guard G(mutex);
+                stopping = true;
+            }
+            wakeup.signal();
+            refresher->exitWait();
+        }
+    }
+
+    // call with E.lookup held, and mutex not held
+    void fetch(const std::string& account, Entry& E)
+    {
+        PeerInfo::roles_t roles;
+        (*lookupFn)(account, roles);
+
+        epicsTimeStamp now;
+        epicsTimeGetCurrent(&now);
+
+        Guard G(mutex);
+        E.roles.swap(roles);
+        E.fetched = now;
+        E.valid = true;
+        E.refreshing = false;
+    }
+
+    // forget accounts which have not been refreshed in a long while.  call with mutex held
+    void prune(const epicsTimeStamp& now)
+    {
+        for(entries_t::iterator it(entries.begin()), end(entries.end()); it!=end;) {
+            const Entry& E = *it->second;
+            if(E.valid && !E.refreshing && epicsTimeDiffInSeconds(&now, &E.fetched) > 4.0*timeout)
+                entries.erase(it++);
+            else
+                ++it;
+        }
+    }
+
+    virtual void run() OVERRIDE FINAL;
+};
+
+void RolesCache::Pvt::run()
+{
+    while(true) {
+        std::string account;
+        std::tr1::shared_ptr<Entry> E;
+        {
+            Guard G(mutex);
+            if(stopping)
+                break;
+            if(refreshQueue.empty()) {
+                UnGuard U(G);
+                wakeup.wait();
+                continue;
+            }
+            account.swap(refreshQueue.front());
+            refreshQueue.pop_front();
+
+            entries_t::iterator it(entries.find(account));
+            if(it==entries.end())
+                continue;
+            E = it->second;
+        }
+
+        Guard L(E->lookup);
+        try {
+            fetch(account, *E);
+        } catch(std::exception& e) {
+            LOG(logLevelError, "Error refreshing roles of '%s': %s", account.c_str(), e.what());
+            // don't keep using roles which can't be confirmed.
+            // the next lookup waits for a new call.
+            Guard G(mutex);
+            entries_t::iterator it(entries.find(account));
+            if(it!=entries.end() && it->second==E)
+                entries.erase(it);
+        }
+    }
+}
+
+RolesCache::RolesCache(double timeout, lookup_t lookup)
+    :pvt(new Pvt(timeout, lookup))
+{}
+
+RolesCache::~RolesCache() {}
+
+void RolesCache::get(const std::string& account, PeerInfo::roles_t& roles)
+{
+    Pvt& C = *pvt;
+
+    if(C.timeout<=0.0) {
+        (*C.lookupFn)(account, roles);
+        return;
+    }
+
+    epicsTimeStamp now;
+    epicsTimeGetCurrent(&now);
+
+    std::tr1::shared_ptr<Pvt::Entry> E;
+    {
+        Guard G(C.mutex);
+        Pvt::entries_t::iterator it(C.entries.find(account));
+        if(it==C.entries.end()) {
+            C.prune(now);
+            it = C.entries.insert(std::make_pair(account, std::tr1::shared_ptr<Pvt::Entry>(new Pvt::Entry))).first;
+        }
+        E = it->second;
+
+        if(E->valid) {
+            roles.insert(E->roles.begin(), E->roles.end());
+
+            if(!E->refreshing && epicsTimeDiffInSeconds(&now, &E->fetched) > C.timeout) {
+                // use stale roles now, and refresh in the background
+                E->refreshing = true;
+                C.refreshQueue.push_back(account);
+                C.wakeup.signal();
+            }
+            return;
+        }
+    }
+
+    // first lookup of this account
+    Guard L(E->lookup);
+    {
+        Guard G(C.mutex);
+        if(E->valid) {
+            // looked up while we waited
+            roles.insert(E->roles.begin(), E->roles.end());
+            return;
+        }
+    }
+
+    C.fetch(account, *E);
+
+    Guard G(C.mutex);
+    roles.insert(E->roles.begin(), E->roles.end());
+}
+
+namespace {
+RolesCache *rolesCache;
+
+epicsThreadOnceId rolesCacheOnce = EPICS_THREAD_ONCE_INIT;
+
+void rolesCacheInit(void *)
+{
+    rolesCache = new RolesCache(ConfigurationEnviron().getPropertyAsDouble("EPICS_PVAS_ROLES_CACHE_TMO", 0.0));
+}
+} // namespace
+
+void cachedGetRoles(const std::string& account, PeerInfo::roles_t& roles)
+{
+    epicsThreadOnce(&rolesCacheOnce, &rolesCacheInit, 0);
+    rolesCache->get(account, roles);
+}
+
 }} // namespace epics::pvAccess
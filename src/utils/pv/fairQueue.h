@@ -137,6 +137,12 @@ public:
         return ellFirst(&list)==NULL;
     }
 
+    //! Number of distinct entries queued
+    size_t size() const {
+        guard_t G(mutex);
+        return size_t(ellCount(&list));
+    }
+
     void push_back(const value_type& ent)
     {
         bool wake;
@@ -5,6 +5,7 @@
  */
 
 #include <pv/pvData.h>
+#include <pv/lock.h>
 #include <pv/pipelineServer.h>
 
 using namespace epics::pvData;
@@ -47,12 +48,23 @@ public:
     }
 
     virtual void request(PipelineControl::shared_pointer const & control, size_t elementCount) {
-        // blocking in this call is not a good thing
-        // but generating a simple counter data is fast
-        // we will generate as much elements as we can
-        size_t count = control->getFreeElementCount();
+        produce(control);
+    }
+
+    virtual void creditsAvailable(PipelineControl::shared_pointer const & control, size_t credits) {
+        produce(control);
+    }
+
+    // blocking in this call is not a good thing
+    // but generating a simple counter data is fast
+    // we will generate as much elements as the client will accept
+    void produce(PipelineControl::shared_pointer const & control) {
+        Lock guard(m_mutex);
+        size_t count = control->getAvailableCredits();
         for (size_t i = 0; i < count; i++) {
             MonitorElement::shared_pointer element = control->getFreeElement();
+            if (!element)
+                break;
             element->pvStructurePtr->getSubField<PVInt>(1 /*"count"*/)->put(m_counter++);
             control->putElement(element);
 
@@ -70,7 +82,9 @@ public:
     }
 
 private:
-    // NOTE: all the request calls will be made from the same thread, so we do not need sync m_counter
+    // request() is called when the client acknowledges elements, and creditsAvailable()
+    // from release() when elements are returned, which may be on different threads.
+    Mutex m_mutex;
     int32 m_counter;
     int32 m_max;
 };
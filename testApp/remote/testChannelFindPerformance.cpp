@@ -0,0 +1,209 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+
+/* Measure pvas::StaticProvider channelFind() rate as a function of
+ * the number of channels hosted, and of the number of searching threads.
+ *
+ * Output is one line per (channels, threads) pair, with
+ * the total number of channelFind() calls per second.
+ */
+
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <algorithm>
+
+#include <stdio.h>
+
+#include <epicsStdlib.h>
+#include <epicsGetopt.h>
+#include <epicsThread.h>
+#include <epicsEvent.h>
+#include <epicsTime.h>
+
+#include <pv/pvAccess.h>
+#include <pva/server.h>
+
+namespace pvd = epics::pvData;
+namespace pva = epics::pvAccess;
+
+namespace {
+
+#define DEFAULT_ITERATIONS 1000000
+#define DEFAULT_MAX_CHANNELS 200000
+#define DEFAULT_MAX_THREADS 4
+
+struct NullBuilder : public pvas::StaticProvider::ChannelBuilder
+{
+    virtual ~NullBuilder() {}
+    virtual std::tr1::shared_ptr<pva::Channel> connect(const std::tr1::shared_ptr<pva::ChannelProvider>& provider,
+                                                       const std::string& name,
+                                                       const std::tr1::shared_ptr<pva::ChannelRequester>& requester) OVERRIDE FINAL
+    {
+        return std::tr1::shared_ptr<pva::Channel>();
+    }
+    virtual void disconnect(bool destroy, const pva::ChannelProvider* provider) OVERRIDE FINAL {}
+};
+
+struct CountingRequester : public pva::ChannelFindRequester
+{
+    size_t found, missing;
+    CountingRequester() :found(0u), missing(0u) {}
+    virtual ~CountingRequester() {}
+    virtual void channelFindResult(const pvd::Status& status,
+                                   pva::ChannelFind::shared_pointer const & channelFind,
+                                   bool wasFound) OVERRIDE FINAL
+    {
+        if(wasFound)
+            found++;
+        else
+            missing++;
+    }
+};
+
+std::string pvName(size_t i)
+{
+    std::ostringstream strm;
+    strm<<"TST:Dev"<<(i/100u)<<":Sig"<<(i%100u);
+    return strm.str();
+}
+
+struct Searcher : public epicsThreadRunable
+{
+    const pva::ChannelProvider::shared_pointer provider;
+    const std::vector<std::string>& names;
+    const size_t iterations;
+    const size_t offset;
+    epicsEvent& start;
+    epicsThread worker;
+    std::tr1::shared_ptr<CountingRequester> requester;
+
+    Searcher(const pva::ChannelProvider::shared_pointer& provider,
+             const std::vector<std::string>& names,
+             size_t iterations, size_t offset,
+             epicsEvent& start)
+        :provider(provider)
+        ,names(names)
+        ,iterations(iterations)
+        ,offset(offset)
+        ,start(start)
+        ,worker(*this, "searcher",
+                epicsThreadGetStackSize(epicsThreadStackSmall),
+                epicsThreadPriorityMedium)
+        ,requester(new CountingRequester)
+    {
+        worker.start();
+    }
+    virtual ~Searcher() {}
+
+    virtual void run() OVERRIDE FINAL
+    {
+        start.wait();
+        start.signal(); // wake the next searcher
+        for(size_t i=0u; i<iterations; i++) {
+            // every other name is missing
+            provider->channelFind(names[(i+offset)%names.size()], requester);
+        }
+    }
+};
+
+void measure(size_t nchannels, size_t nthreads, size_t iterations)
+{
+    pvas::StaticProvider prov("bench");
+    std::tr1::shared_ptr<NullBuilder> builder(new NullBuilder);
+
+    std::vector<std::string> names;
+    names.reserve(2u*nchannels);
+    for(size_t i=0u; i<nchannels; i++) {
+        std::string name(pvName(i));
+        prov.add(name, builder);
+        names.push_back(name);
+        names.push_back(name+":missing");
+    }
+
+    pva::ChannelProvider::shared_pointer provider(prov.provider());
+
+    epicsEvent start;
+    std::vector<std::tr1::shared_ptr<Searcher> > searchers;
+    for(size_t t=0u; t<nthreads; t++)
+        searchers.push_back(std::tr1::shared_ptr<Searcher>(new Searcher(provider, names, iterations/nthreads,
+                                                                         t*(names.size()/nthreads), start)));
+
+    epicsTimeStamp begin, end;
+    epicsTimeGetCurrent(&begin);
+    start.signal();
+
+    size_t found = 0u, missing = 0u;
+    for(size_t t=0u; t<nthreads; t++) {
+        searchers[t]->worker.exitWait();
+        found += searchers[t]->requester->found;
+        missing += searchers[t]->requester->missing;
+    }
+    epicsTimeGetCurrent(&end);
+
+    double duration = epicsTimeDiffInSeconds(&end, &begin);
+    printf("%zu channels %zu threads %zu found %zu missing %.0f finds/s\n",
+           nchannels, nthreads, found, missing, (found+missing)/duration);
+}
+
+void usage(void)
+{
+    fprintf(stderr, "\nUsage: testChannelFindPerformance [options]\n\n"
+            "  -h: Help: Print this message\n"
+            "options:\n"
+            "  -i <iterations>:   number of channelFind() calls per measurement, default is '%d'\n"
+            "  -c <channels>:     maximum number of channels, default is '%d'\n"
+            "  -t <threads>:      maximum number of searching threads, default is '%d'\n\n"
+            , DEFAULT_ITERATIONS, DEFAULT_MAX_CHANNELS, DEFAULT_MAX_THREADS);
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    int iterations = DEFAULT_ITERATIONS;
+    int maxChannels = DEFAULT_MAX_CHANNELS;
+    int maxThreads = DEFAULT_MAX_THREADS;
+
+    int opt;
+    while((opt = getopt(argc, argv, ":hi:c:t:")) != -1) {
+        switch(opt) {
+        case 'h':
+            usage();
+            return 0;
+        case 'i':
+            iterations = atoi(optarg);
+            break;
+        case 'c':
+            maxChannels = atoi(optarg);
+            break;
+        case 't':
+            maxThreads = atoi(optarg);
+            break;
+        default:
+            usage();
+            return 1;
+        }
+    }
+
+    if(iterations<=0 || maxChannels<=0 || maxThreads<=0) {
+        usage();
+        return 1;
+    }
+
+    // 1000, 10000, ... and finally the maximum (eg. 200000)
+    size_t nchannels = std::min(size_t(1000u), size_t(maxChannels));
+    while(true) {
+        for(size_t nthreads=1u; nthreads<=size_t(maxThreads); nthreads*=2u) {
+            measure(nchannels, nthreads, iterations);
+        }
+        if(nchannels==size_t(maxChannels))
+            break;
+        nchannels = std::min(10u*nchannels, size_t(maxChannels));
+    }
+
+    return 0;
+}
@@ -0,0 +1,499 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+
+/* Monitor throughput and latency benchmark.
+ *
+ * Starts an in-process server with a number of SharedPVs, bound to the loopback interface,
+ * and a number of client contexts each subscribing to every PV.
+ * A producer thread post()s to each PV at a fixed rate for a fixed duration.
+ *
+ * Latency is measured with monitor tracing (pvRequest option record._options.trace=true),
+ * from SharedPV::post() until received by the client.
+ *
+ * The result is printed to stdout as one JSON object, to be compared between releases.
+ */
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <algorithm>
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef __linux__
+#  include <unistd.h>
+#endif
+
+#include <epicsStdlib.h>
+#include <epicsStdio.h>
+#include <epicsGetopt.h>
+#include <epicsGuard.h>
+#include <epicsMutex.h>
+#include <epicsThread.h>
+#include <epicsTime.h>
+
+#include <pv/pvData.h>
+#include <pv/standardField.h>
+#include <pv/createRequest.h>
+
+#include <pva/client.h>
+#include <pva/sharedstate.h>
+#include <pva/server.h>
+#include <pv/serverContext.h>
+#include <pv/configuration.h>
+#include <pv/pvaVersion.h>
+
+#include "testServerConfig.h"
+
+namespace pvd = epics::pvData;
+namespace pva = epics::pvAccess;
+
+typedef epicsGuard<epicsMutex> Guard;
+
+namespace {
+
+#define DEFAULT_PVS 10
+#define DEFAULT_TYPE "scalar"
+#define DEFAULT_ELEMENTS 1024
+#define DEFAULT_RATE 100.0
+#define DEFAULT_CLIENTS 1
+#define DEFAULT_DURATION 5.0
+#define DEFAULT_QUEUE_SIZE 4
+
+pvd::StructureConstPtr buildType(const std::string& type)
+{
+    pvd::FieldCreatePtr create(pvd::getFieldCreate());
+    pvd::StandardFieldPtr standard(pvd::getStandardField());
+
+    if(type=="scalar") {
+        return create->createFieldBuilder()
+                ->setId("epics:nt/NTScalar:1.0")
+                ->add("value", pvd::pvULong)
+                ->add("timeStamp", standard->timeStamp())
+                ->createStructure();
+
+    } else if(type=="array") {
+        return create->createFieldBuilder()
+                ->setId("epics:nt/NTScalarArray:1.0")
+                ->addArray("value", pvd::pvDouble)
+                ->add("timeStamp", standard->timeStamp())
+                ->createStructure();
+
+    } else if(type=="image") {
+        // the parts of NTNDArray which change with each frame
+        return create->createFieldBuilder()
+                ->setId("epics:nt/NTNDArray:1.0")
+                ->addNestedUnion("value")
+                    ->addArray("ubyteValue", pvd::pvUByte)
+                    ->addArray("ushortValue", pvd::pvUShort)
+                    ->addArray("doubleValue", pvd::pvDouble)
+                ->endNested()
+                ->add("compressedSize", pvd::pvLong)
+                ->add("uncompressedSize", pvd::pvLong)
+                ->addNestedStructureArray("dimension")
+                    ->add("size", pvd::pvInt)
+                    ->add("offset", pvd::pvInt)
+                    ->add("fullSize", pvd::pvInt)
+                    ->add("binning", pvd::pvInt)
+                    ->add("reverse", pvd::pvBoolean)
+                ->endNested()
+                ->add("uniqueId", pvd::pvInt)
+                ->add("dataTimeStamp", standard->timeStamp())
+                ->add("timeStamp", standard->timeStamp())
+                ->createStructure();
+
+    } else {
+        throw std::runtime_error("Unknown type '"+type+"'");
+    }
+}
+
+void fillInitial(pvd::PVStructure& root, const std::string& type, size_t elements)
+{
+    if(type=="array") {
+        pvd::PVDoubleArray::svector arr(elements);
+        for(size_t i=0; i<elements; i++)
+            arr[i] = double(i);
+        root.getSubFieldT<pvd::PVDoubleArray>("value")->replace(pvd::freeze(arr));
+
+    } else if(type=="image") {
+        pvd::PVUByteArray::svector pixels(elements);
+        for(size_t i=0; i<elements; i++)
+            pixels[i] = pvd::uint8(i);
+        pvd::PVUnionPtr value(root.getSubFieldT<pvd::PVUnion>("value"));
+        value->select<pvd::PVUByteArray>("ubyteValue")->replace(pvd::freeze(pixels));
+        root.getSubFieldT<pvd::PVLong>("compressedSize")->put(elements);
+        root.getSubFieldT<pvd::PVLong>("uncompressedSize")->put(elements);
+
+        pvd::PVStructureArrayPtr dims(root.getSubFieldT<pvd::PVStructureArray>("dimension"));
+        pvd::PVStructureArray::svector D(1);
+        D[0] = pvd::getPVDataCreate()->createPVStructure(dims->getStructureArray()->getStructure());
+        D[0]->getSubFieldT<pvd::PVInt>("size")->put(elements);
+        D[0]->getSubFieldT<pvd::PVInt>("fullSize")->put(elements);
+        D[0]->getSubFieldT<pvd::PVInt>("binning")->put(1);
+        dims->replace(pvd::freeze(D));
+    }
+}
+
+// Process CPU time in seconds
+double cpuTime()
+{
+    return double(clock())/CLOCKS_PER_SEC;
+}
+
+// Resident set size in bytes.  0 if not known.
+size_t residentBytes()
+{
+#ifdef __linux__
+    FILE *fp = fopen("/proc/self/statm", "r");
+    if(!fp)
+        return 0u;
+    unsigned long size = 0u, resident = 0u;
+    int n = fscanf(fp, "%lu %lu", &size, &resident);
+    fclose(fp);
+    return n==2 ? size_t(resident)*size_t(sysconf(_SC_PAGESIZE)) : 0u;
+#else
+    return 0u;
+#endif
+}
+
+struct Subscriber : public pvac::ClientChannel::MonitorCallback
+{
+    epicsMutex mutex;
+    pvac::Monitor mon;
+    bool connected;
+    bool counting;
+    size_t updates;
+    std::vector<double> latencies;
+
+    Subscriber(pvac::ClientChannel& chan, const pvd::PVStructure::const_shared_pointer& pvRequest)
+        :connected(false)
+        ,counting(false)
+        ,updates(0u)
+    {
+        Guard G(mutex);
+        mon = chan.monitor(this, pvRequest);
+    }
+    virtual ~Subscriber()
+    {
+        mon.cancel();
+    }
+
+    virtual void monitorEvent(const pvac::MonitorEvent& evt) OVERRIDE FINAL
+    {
+        Guard G(mutex);
+        if(evt.event==pvac::MonitorEvent::Fail) {
+            fprintf(stderr, "Error: %s %s\n", mon.name().c_str(), evt.message.c_str());
+            return;
+        } else if(evt.event!=pvac::MonitorEvent::Data) {
+            return;
+        }
+
+        while(mon.poll()) {
+            connected = true;
+            if(!counting)
+                continue;
+            updates++;
+            double latency = mon.trace.latency();
+            if(mon.trace.id && latency>=0.0)
+                latencies.push_back(latency);
+        }
+    }
+
+    //! Begin counting (true), or stop
+    void count(bool start)
+    {
+        Guard G(mutex);
+        counting = start;
+    }
+};
+
+struct Producer : public epicsThreadRunable
+{
+    const std::vector<pvas::SharedPV::shared_pointer>& pvs;
+    pvd::PVStructurePtr value;
+    pvd::BitSet changed;
+    const double rate;
+    const double duration;
+    size_t posted;
+    epicsThread worker;
+
+    Producer(const std::vector<pvas::SharedPV::shared_pointer>& pvs,
+             const pvd::PVStructurePtr& value,
+             double rate, double duration)
+        :pvs(pvs)
+        ,value(value)
+        ,rate(rate)
+        ,duration(duration)
+        ,posted(0u)
+        ,worker(*this, "producer",
+                epicsThreadGetStackSize(epicsThreadStackBig),
+                epicsThreadPriorityMedium)
+    {
+        // scalar counter, or array, marked as changed.  Array contents are re-sent as-is.
+        pvd::PVFieldPtr fld(value->getSubFieldT<pvd::PVField>("value"));
+        changed.set(fld->getFieldOffset());
+        pvd::PVStructurePtr ts(value->getSubFieldT<pvd::PVStructure>("timeStamp"));
+        changed.set(ts->getFieldOffset());
+    }
+
+    virtual void run() OVERRIDE FINAL
+    {
+        pvd::PVULongPtr counter(value->getSubField<pvd::PVULong>("value"));
+        pvd::PVIntPtr uniqueId(value->getSubField<pvd::PVInt>("uniqueId"));
+        pvd::PVStructurePtr ts(value->getSubFieldT<pvd::PVStructure>("timeStamp"));
+        pvd::PVLongPtr sec(ts->getSubFieldT<pvd::PVLong>("secondsPastEpoch"));
+        pvd::PVIntPtr nsec(ts->getSubFieldT<pvd::PVInt>("nanoseconds"));
+        if(uniqueId)
+            changed.set(uniqueId->getFieldOffset());
+
+        epicsTimeStamp start, now;
+        epicsTimeGetCurrent(&start);
+
+        for(size_t tick=0u; ; tick++) {
+            epicsTimeGetCurrent(&now);
+            double elapsed = epicsTimeDiffInSeconds(&now, &start);
+            if(elapsed >= duration)
+                break;
+
+            if(rate>0.0) {
+                double ahead = tick/rate - elapsed;
+                if(ahead>0.0)
+                    epicsThreadSleep(ahead);
+            }
+
+            if(counter)
+                counter->put(tick);
+            if(uniqueId)
+                uniqueId->put(pvd::int32(tick));
+            sec->put(now.secPastEpoch+POSIX_TIME_AT_EPICS_EPOCH);
+            nsec->put(now.nsec);
+
+            for(size_t i=0; i<pvs.size(); i++) {
+                pvs[i]->post(*value, changed);
+                posted++;
+            }
+        }
+    }
+
+    void start() { worker.start(); }
+    void join() { worker.exitWait(); }
+};
+
+double percentile(const std::vector<double>& sorted, double p)
+{
+    if(sorted.empty())
+        return 0.0;
+    size_t idx = size_t(p*(sorted.size()-1u) + 0.5);
+    return sorted[std::min(idx, sorted.size()-1u)];
+}
+
+void usage(void)
+{
+    fprintf(stderr, "\nUsage: testMonitorBenchmark [options]\n\n"
+            "  -h: Help: Print this message\n"
+            "options:\n"
+            "  -p <pvs>:          number of SharedPVs, default is '%d'\n"
+            "  -t <type>:         scalar, array, or image (NTNDArray), default is '%s'\n"
+            "  -n <elements>:     number of array elements, or image pixels, default is '%d'\n"
+            "  -r <rate>:         updates per second of each PV (0 means as fast as possible), default is '%.0f'\n"
+            "  -c <clients>:      number of client contexts, each subscribing to all PVs, default is '%d'\n"
+            "  -d <seconds>:      measurement duration, default is '%.0f'\n"
+            "  -q <queueSize>:    monitor queueSize, default is '%d'\n"
+            "  -l:                connect clients in-process ($EPICS_PVA_LOOPBACK) instead of through TCP\n\n"
+            , DEFAULT_PVS, DEFAULT_TYPE, DEFAULT_ELEMENTS, DEFAULT_RATE, DEFAULT_CLIENTS,
+            DEFAULT_DURATION, DEFAULT_QUEUE_SIZE);
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    int npvs = DEFAULT_PVS;
+    std::string type(DEFAULT_TYPE);
+    int elements = DEFAULT_ELEMENTS;
+    double rate = DEFAULT_RATE;
+    int nclients = DEFAULT_CLIENTS;
+    double duration = DEFAULT_DURATION;
+    int queueSize = DEFAULT_QUEUE_SIZE;
+    bool loopback = false;
+
+    int opt;
+    while((opt = getopt(argc, argv, ":hp:t:n:r:c:d:q:l")) != -1) {
+        switch(opt) {
+        case 'h':
+            usage();
+            return 0;
+        case 'p':
+            npvs = atoi(optarg);
+            break;
+        case 't':
+            type = optarg;
+            break;
+        case 'n':
+            elements = atoi(optarg);
+            break;
+        case 'r':
+            if(epicsScanDouble(optarg, &rate)!=1) {
+                usage();
+                return 1;
+            }
+            break;
+        case 'c':
+            nclients = atoi(optarg);
+            break;
+        case 'd':
+            if(epicsScanDouble(optarg, &duration)!=1) {
+                usage();
+                return 1;
+            }
+            break;
+        case 'q':
+            queueSize = atoi(optarg);
+            break;
+        case 'l':
+            loopback = true;
+            break;
+        default:
+            usage();
+            return 1;
+        }
+    }
+
+    if(npvs<=0 || elements<0 || rate<0.0 || nclients<=0 || duration<=0.0 || queueSize<=0) {
+        usage();
+        return 1;
+    }
+
+    try {
+        pvd::StructureConstPtr ptype(buildType(type));
+        pvd::PVStructurePtr value(pvd::getPVDataCreate()->createPVStructure(ptype));
+        fillInitial(*value, type, elements);
+
+        std::tr1::shared_ptr<pvas::StaticProvider> prov(new pvas::StaticProvider("bench"));
+        std::vector<pvas::SharedPV::shared_pointer> pvs(npvs);
+        std::vector<std::string> names(npvs);
+        for(int i=0; i<npvs; i++) {
+            char name[32];
+            epicsSnprintf(name, sizeof(name), "bench:%d", i);
+            names[i] = name;
+            pvs[i] = pvas::SharedPV::buildReadOnly();
+            pvs[i]->open(*value);
+            prov->add(names[i], pvs[i]);
+        }
+
+        pva::ServerContext::shared_pointer serv(pva::ServerContext::create(pva::ServerContext::Config()
+                                                    .config(TestServerConfig()
+                                                            .push_map()
+                                                            .build())
+                                                    .provider(prov->provider())));
+
+        char req[64];
+        epicsSnprintf(req, sizeof(req), "record[queueSize=%d,trace=true]field()", queueSize);
+        pvd::PVStructure::const_shared_pointer pvRequest(pvd::createRequest(req));
+
+        // each ClientProvider is a separate client context, with its own connection to the server
+        std::vector<pvac::ClientProvider> clients;
+        std::vector<std::tr1::shared_ptr<Subscriber> > subscribers;
+        for(int c=0; c<nclients; c++) {
+            clients.push_back(pvac::ClientProvider("pva", pva::ConfigurationBuilder()
+                                                   .push_config(serv->getCurrentConfig())
+                                                   .add("EPICS_PVA_LOOPBACK", loopback ? "YES" : "NO")
+                                                   .push_map()
+                                                   .build()));
+            for(int i=0; i<npvs; i++) {
+                pvac::ClientChannel chan(clients.back().connect(names[i]));
+                subscribers.push_back(std::tr1::shared_ptr<Subscriber>(new Subscriber(chan, pvRequest)));
+            }
+        }
+
+        // wait for the initial update of all subscriptions
+        size_t nconnected = 0u;
+        for(unsigned wait=0u; nconnected<subscribers.size() && wait<100u; wait++) {
+            epicsThreadSleep(0.1);
+            nconnected = 0u;
+            for(size_t s=0; s<subscribers.size(); s++) {
+                Guard G(subscribers[s]->mutex);
+                if(subscribers[s]->connected)
+                    nconnected++;
+            }
+        }
+        if(nconnected<subscribers.size()) {
+            fprintf(stderr, "Error: only %zu of %zu subscriptions connected\n", nconnected, subscribers.size());
+            return 1;
+        }
+
+        for(size_t s=0; s<subscribers.size(); s++)
+            subscribers[s]->count(true);
+
+        const size_t rss0 = residentBytes();
+        const double cpu0 = cpuTime();
+        epicsTimeStamp begin, end;
+        epicsTimeGetCurrent(&begin);
+
+        Producer producer(pvs, value, rate, duration);
+        producer.start();
+        producer.join();
+
+        // allow queued updates to drain
+        epicsThreadSleep(0.5);
+
+        for(size_t s=0; s<subscribers.size(); s++)
+            subscribers[s]->count(false);
+
+        epicsTimeGetCurrent(&end);
+        const double cpu = cpuTime() - cpu0;
+        const size_t rss = residentBytes();
+        const double elapsed = epicsTimeDiffInSeconds(&end, &begin);
+
+        size_t received = 0u;
+        std::vector<double> latencies;
+        for(size_t s=0; s<subscribers.size(); s++) {
+            Guard G(subscribers[s]->mutex);
+            received += subscribers[s]->updates;
+            latencies.insert(latencies.end(), subscribers[s]->latencies.begin(), subscribers[s]->latencies.end());
+        }
+        std::sort(latencies.begin(), latencies.end());
+
+        printf("{\n"
+               "  \"version\": \"%d.%d.%d\",\n"
+               "  \"pvs\": %d,\n"
+               "  \"type\": \"%s\",\n"
+               "  \"elements\": %d,\n"
+               "  \"rate\": %g,\n"
+               "  \"clients\": %d,\n"
+               "  \"queueSize\": %d,\n"
+               "  \"loopback\": %s,\n"
+               "  \"duration\": %g,\n"
+               "  \"posted\": %zu,\n"
+               "  \"received\": %zu,\n"
+               "  \"dropped\": %zu,\n"
+               "  \"throughput\": %g,\n"
+               "  \"latency\": {\"samples\": %zu, \"p50\": %g, \"p99\": %g, \"p999\": %g, \"max\": %g},\n"
+               "  \"cpuPerUpdate\": %g,\n"
+               "  \"rssStart\": %zu,\n"
+               "  \"rssEnd\": %zu\n"
+               "}\n",
+               EPICS_PVA_MAJOR_VERSION, EPICS_PVA_MINOR_VERSION, EPICS_PVA_MAINTENANCE_VERSION,
+               npvs, type.c_str(), elements, rate, nclients, queueSize, loopback ? "true" : "false", elapsed,
+               producer.posted, received,
+               producer.posted*nclients > received ? producer.posted*nclients - received : 0u,
+               received/elapsed,
+               latencies.size(), percentile(latencies, 0.5), percentile(latencies, 0.99),
+               percentile(latencies, 0.999), latencies.empty() ? 0.0 : latencies.back(),
+               received ? cpu/received : 0.0,
+               rss0, rss);
+
+        subscribers.clear();
+        clients.clear();
+
+    } catch(std::exception& e) {
+        fprintf(stderr, "Error: %s\n", e.what());
+        return 1;
+    }
+
+    return 0;
+}
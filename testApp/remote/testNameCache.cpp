@@ -0,0 +1,126 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+
+#include <fstream>
+
+#include <stdio.h>
+#include <string.h>
+
+#include <osiSock.h>
+#include <testMain.h>
+#include <epicsUnitTest.h>
+
+#include <pv/nameCache.h>
+
+namespace pva = epics::pvAccess;
+
+namespace {
+
+const char cacheFile[] = "testNameCache.cache";
+
+pva::ServerGUID makeGUID(char fill)
+{
+    pva::ServerGUID guid;
+    memset(guid.value, fill, sizeof(guid.value));
+    return guid;
+}
+
+osiSockAddr makeAddr(const char *str)
+{
+    osiSockAddr addr;
+    memset(&addr, 0, sizeof(addr));
+    if(aToIPAddr(str, 0, &addr.ia))
+        testAbort("Bad address %s", str);
+    return addr;
+}
+
+bool sameGUID(const pva::ServerGUID& a, const pva::ServerGUID& b)
+{
+    return memcmp(a.value, b.value, sizeof(a.value))==0;
+}
+
+void testLookup()
+{
+    testDiag("%s", __FUNCTION__);
+
+    pva::NameCache cache(cacheFile);
+    pva::NameCache::Entry entry;
+
+    testOk1(!cache.lookup("pv:a", entry));
+
+    cache.update("pv:a", makeGUID(1), makeAddr("10.0.0.1:5075"));
+    cache.update("pv:b", makeGUID(1), makeAddr("10.0.0.1:5075"));
+    cache.update("pv:c", makeGUID(2), makeAddr("10.0.0.2:5075"));
+    testOk1(cache.size()==3u);
+
+    testOk1(cache.lookup("pv:a", entry));
+    testOk1(sameGUID(entry.guid, makeGUID(1)));
+    osiSockAddr expect(makeAddr("10.0.0.1:5075"));
+    testOk1(sockAddrAreIdentical(&entry.address, &expect));
+
+    cache.remove("pv:a");
+    testOk1(!cache.lookup("pv:a", entry));
+
+    // same server seen again
+    cache.serverDetected(makeGUID(1), makeAddr("10.0.0.1:5075"));
+    testOk1(cache.lookup("pv:b", entry));
+
+    // server restarted
+    cache.serverDetected(makeGUID(3), makeAddr("10.0.0.1:5075"));
+    testOk1(!cache.lookup("pv:b", entry));
+    testOk1(cache.lookup("pv:c", entry));
+    testOk1(cache.size()==1u);
+
+    // unknown server is ignored
+    cache.serverDetected(makeGUID(4), makeAddr("10.0.0.4:5075"));
+    testOk1(cache.size()==1u);
+}
+
+void testPersist()
+{
+    testDiag("%s", __FUNCTION__);
+
+    {
+        pva::NameCache cache(cacheFile);
+        cache.update("pv:a", makeGUID(1), makeAddr("10.0.0.1:5075"));
+        cache.update("pv:with space", makeGUID(2), makeAddr("10.0.0.2:5076"));
+        testOk1(cache.save());
+    }
+
+    {
+        // append some garbage
+        std::ofstream strm(cacheFile, std::ios::app);
+        strm<<"not a valid line\n";
+        strm<<"0101 10.0.0.1:5075 pv:shortguid\n";
+    }
+
+    pva::NameCache cache(cacheFile);
+    testOk1(cache.load());
+    testOk(cache.size()==2u, "size %u", (unsigned)cache.size());
+
+    pva::NameCache::Entry entry;
+    testOk1(cache.lookup("pv:with space", entry));
+    testOk1(sameGUID(entry.guid, makeGUID(2)));
+    osiSockAddr expect(makeAddr("10.0.0.2:5076"));
+    testOk1(sockAddrAreIdentical(&entry.address, &expect));
+
+    remove(cacheFile);
+
+    pva::NameCache missing(cacheFile);
+    testOk(missing.load(), "missing file is not an error");
+    testOk1(missing.size()==0u);
+}
+
+} // namespace
+
+MAIN(testNameCache)
+{
+    testPlan(19);
+    osiSockAttach();
+    testLookup();
+    testPersist();
+    osiSockRelease();
+    return testDone();
+}
@@ -0,0 +1,200 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * pvAccessCPP is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <vector>
+
+#include <epicsUnitTest.h>
+#include <testMain.h>
+#include <epicsThread.h>
+#include <epicsEvent.h>
+#include <epicsTime.h>
+
+#include <pv/pvData.h>
+#include <pv/createRequest.h>
+#include <pv/pipelineServer.h>
+
+namespace pvd = epics::pvData;
+namespace pva = epics::pvAccess;
+
+namespace {
+
+pvd::StructureConstPtr type(pvd::getFieldCreate()->createFieldBuilder()
+                            ->add("count", pvd::pvInt)
+                            ->createStructure());
+
+struct TestSession : public pva::PipelineSession
+{
+    pva::PipelineControl::shared_pointer control;
+    size_t requested, creditsCalls, lastCredits;
+    bool cancelled;
+
+    TestSession() :requested(0u), creditsCalls(0u), lastCredits(0u), cancelled(false) {}
+    virtual ~TestSession() {}
+
+    virtual size_t getMinQueueSize() const OVERRIDE FINAL { return 4u; }
+    virtual pvd::StructureConstPtr getStructure() const OVERRIDE FINAL { return type; }
+
+    virtual void request(pva::PipelineControl::shared_pointer const & control, size_t elementCount) OVERRIDE FINAL
+    {
+        this->control = control;
+        requested += elementCount;
+    }
+
+    virtual void creditsAvailable(pva::PipelineControl::shared_pointer const & control, size_t credits) OVERRIDE FINAL
+    {
+        creditsCalls++;
+        lastCredits = credits;
+    }
+
+    virtual void cancel() OVERRIDE FINAL { cancelled = true; }
+};
+
+struct TestService : public pva::PipelineService
+{
+    std::tr1::shared_ptr<TestSession> session;
+
+    virtual pva::PipelineSession::shared_pointer createPipeline(pvd::PVStructure::shared_pointer const & pvRequest) OVERRIDE FINAL
+    {
+        session.reset(new TestSession);
+        return session;
+    }
+};
+
+struct TestRequester : public pva::ChannelRequester, public pva::MonitorRequester
+{
+    size_t events;
+    bool unlistened;
+    TestRequester() :events(0u), unlistened(false) {}
+    virtual ~TestRequester() {}
+
+    virtual std::string getRequesterName() OVERRIDE FINAL { return "TestRequester"; }
+
+    virtual void channelCreated(const pvd::Status& status, pva::Channel::shared_pointer const & channel) OVERRIDE FINAL {}
+    virtual void channelStateChange(pva::Channel::shared_pointer const & channel, pva::Channel::ConnectionState connectionState) OVERRIDE FINAL {}
+
+    virtual void monitorConnect(pvd::Status const & status,
+                                pva::MonitorPtr const & monitor, pvd::StructureConstPtr const & structure) OVERRIDE FINAL {}
+    virtual void monitorEvent(pva::MonitorPtr const & monitor) OVERRIDE FINAL { events++; }
+    virtual void unlisten(pva::MonitorPtr const & monitor) OVERRIDE FINAL { unlistened = true; }
+};
+
+// wakes waitForCredits(), without adding credits, until destroyed
+struct Poker : public epicsThreadRunable
+{
+    const pva::Monitor::shared_pointer mon;
+    epicsEvent stop;
+    epicsThread thread;
+    explicit Poker(const pva::Monitor::shared_pointer& mon)
+        :mon(mon)
+        ,thread(*this, "poker", epicsThreadGetStackSize(epicsThreadStackSmall))
+    {
+        thread.start();
+    }
+    virtual ~Poker() {
+        stop.signal();
+        thread.exitWait();
+    }
+    virtual void run() OVERRIDE FINAL {
+        while(!stop.wait(0.01))
+            mon->reportRemoteQueueStatus(0);
+    }
+};
+
+void testCredits()
+{
+    testDiag("testCredits");
+
+    std::tr1::shared_ptr<TestService> service(new TestService);
+    std::tr1::shared_ptr<TestRequester> req(new TestRequester);
+
+    pva::Channel::shared_pointer chan(pva::createPipelineChannel(pva::ChannelProvider::shared_pointer(),
+                                                                 "pipe", req, service));
+    pva::Monitor::shared_pointer mon(chan->createMonitor(req, pvd::createRequest("record[queueSize=4,pipeline=true]field()")));
+    if(!mon || !service->session)
+        testAbort("Pipeline monitor not created");
+    TestSession& session = *service->session;
+
+    testOk1(mon->start().isSuccess());
+
+    testDiag("Client window of 3");
+    mon->reportRemoteQueueStatus(3);
+    if(!session.control)
+        testAbort("request() not called");
+    pva::PipelineControl& ctrl = *session.control;
+
+    testOk(session.requested==3u, "requested %u", unsigned(session.requested));
+    testOk(ctrl.getFreeElementCount()==4u, "free %u", unsigned(ctrl.getFreeElementCount()));
+    testOk(ctrl.getAvailableCredits()==3u, "credits %u", unsigned(ctrl.getAvailableCredits()));
+    testOk1(ctrl.waitForCredits(3u, 0.1));
+    testOk(!ctrl.waitForCredits(5u, 0.0), "more credits than the queue size never become available");
+
+    for(size_t i=0; i<3u; i++) {
+        pva::MonitorElementPtr elem(ctrl.getFreeElement());
+        if(!elem)
+            testAbort("No free element");
+        ctrl.putElement(elem);
+    }
+    testOk(ctrl.getAvailableCredits()==0u, "window full.  credits %u", unsigned(ctrl.getAvailableCredits()));
+    testOk1(!ctrl.waitForCredits(1u, 0.1));
+
+    testDiag("Client takes the elements, and opens a new window of 3");
+    std::vector<pva::MonitorElementPtr> taken;
+    for(pva::MonitorElementPtr elem; !!(elem = mon->poll());)
+        taken.push_back(elem);
+    testOk(taken.size()==3u, "polled %u", unsigned(taken.size()));
+
+    mon->reportRemoteQueueStatus(3);
+    // only one free element remains
+    testOk(ctrl.getAvailableCredits()==1u, "credits %u", unsigned(ctrl.getAvailableCredits()));
+
+    {
+        pva::MonitorElementPtr elem(ctrl.getFreeElement());
+        ctrl.putElement(elem);
+    }
+    testOk(ctrl.getAvailableCredits()==0u, "no free elements.  credits %u", unsigned(ctrl.getAvailableCredits()));
+    testOk1(session.creditsCalls==0u);
+
+    {
+        testDiag("Wakeups which add no credits don't extend the timeout");
+        Poker poke(mon);
+        epicsTimeStamp start, end;
+        epicsTimeGetCurrent(&start);
+        testOk1(!ctrl.waitForCredits(1u, 0.1));
+        epicsTimeGetCurrent(&end);
+        double elapsed = epicsTimeDiffInSeconds(&end, &start);
+        testOk(elapsed < 2.0, "waited %f seconds", elapsed);
+    }
+
+    testDiag("Return elements");
+    mon->release(taken[0]);
+    testOk(session.creditsCalls==1u && session.lastCredits==1u, "creditsAvailable() calls %u credits %u",
+           unsigned(session.creditsCalls), unsigned(session.lastCredits));
+    mon->release(taken[1]);
+    mon->release(taken[2]);
+    testOk(session.creditsCalls==1u, "only notified when free queue was empty.  calls %u", unsigned(session.creditsCalls));
+    testOk(ctrl.getAvailableCredits()==2u, "credits %u", unsigned(ctrl.getAvailableCredits()));
+
+    testDiag("Extra release()s do not grow the free queue");
+    mon->release(pva::MonitorElementPtr(new pva::MonitorElement(pvd::getPVDataCreate()->createPVStructure(type))));
+    mon->release(pva::MonitorElementPtr(new pva::MonitorElement(pvd::getPVDataCreate()->createPVStructure(type))));
+    testOk(ctrl.getFreeElementCount()==4u, "free %u", unsigned(ctrl.getFreeElementCount()));
+
+    testDiag("done()");
+    ctrl.done();
+    testOk1(!ctrl.waitForCredits(1u, 0.0));
+
+    mon->destroy();
+    testOk1(!session.cancelled);
+}
+
+} // namespace
+
+MAIN(testPipeline)
+{
+    testPlan(20);
+    testCredits();
+    return testDone();
+}
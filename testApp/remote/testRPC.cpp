@@ -9,6 +9,10 @@
 
 #include <epicsUnitTest.h>
 #include <testMain.h>
+#include <epicsEvent.h>
+#include <epicsMutex.h>
+#include <epicsGuard.h>
+#include <epicsThread.h>
 
 namespace pvd = epics::pvData;
 namespace pva = epics::pvAccess;
@@ -106,11 +110,261 @@ void testRPCFail(const pva::ChannelProvider::shared_pointer& cli_prov)
     }
 }
 
+struct CountCallback : public pva::RPCClient::AsyncCallback
+{
+    epicsMutex lock;
+    size_t ok, failed;
+    CountCallback() :ok(0u), failed(0u) {}
+    virtual ~CountCallback() {}
+    virtual void requestDone(const pvd::Status& status,
+                             pvd::PVStructure::shared_pointer const & response) OVERRIDE FINAL
+    {
+        epicsGuard<epicsMutex> G(lock);
+        if(status.isSuccess() && response)
+            ok++;
+        else
+            failed++;
+    }
+};
+
+void testAsync(const pva::ChannelProvider::shared_pointer& cli_prov)
+{
+    testDiag("Async");
+
+    pva::RPCClient client("sum", pvd::createRequest("field()"), cli_prov);
+    client.setMaxInFlight(4);
+    testOk1(client.getMaxInFlight()==4u);
+
+    std::tr1::shared_ptr<CountCallback> counter(new CountCallback);
+    std::vector<pva::RPCClient::AsyncResponse::shared_pointer> responses;
+
+    // more requests than operations, issued before connecting
+    for(int i=0; i<20; i++) {
+        pvd::ValueBuilder args("epics:nt/NTURI:1.0");
+        args.add<pvd::pvString>("scheme", "pva")
+            .add<pvd::pvString>("path", "sum");
+        responses.push_back(client.requestAsync(args.addNested("query")
+                                                    .add<pvd::pvDouble>("lhs", i)
+                                                    .add<pvd::pvDouble>("rhs", 1.0)
+                                                .endNested()
+                                                .buildPVStructure(),
+                                                counter));
+    }
+
+    bool allok = true;
+    for(int i=0; i<20; i++) {
+        try {
+            pvd::PVStructurePtr reply(responses[i]->get(5.0));
+            pvd::int32 value = reply->getSubFieldT<pvd::PVScalar>("value")->getAs<pvd::int32>();
+            if(value!=i+1) {
+                testDiag("Request %d reply value = %d", i, (int)value);
+                allok = false;
+            }
+        } catch(std::exception& e) {
+            testDiag("Request %d error: %s", i, e.what());
+            allok = false;
+        }
+    }
+    testOk(allok, "All async replies correct");
+
+    {
+        epicsGuard<epicsMutex> G(counter->lock);
+        testOk(counter->ok==20u && counter->failed==0u, "callbacks ok %u failed %u",
+               (unsigned)counter->ok, (unsigned)counter->failed);
+    }
+
+    pva::RPCClient fail("fail", pvd::createRequest("field()"), cli_prov);
+    pvd::ValueBuilder args("epics:nt/NTURI:1.0");
+    args.add<pvd::pvString>("scheme", "pva")
+        .add<pvd::pvString>("path", "fail");
+    pva::RPCClient::AsyncResponse::shared_pointer resp(fail.requestAsync(args.buildPVStructure()));
+    try{
+        (void)resp->get(5.0);
+        testFail("Missing expected exception");
+    }catch(pva::RPCRequestException& e){
+        testPass("caught expected rpc exception: %s", e.what());
+    }
+}
+
+// holds each request until release()
+struct HoldService : public pva::RPCServiceAsync
+{
+    epicsMutex lock;
+    pva::RPCResponseCallback::shared_pointer pending;
+    epicsEvent called;
+
+    virtual void request(epics::pvData::PVStructure::shared_pointer const & args,
+                         pva::RPCResponseCallback::shared_pointer const & callback) OVERRIDE FINAL
+    {
+        {
+            epicsGuard<epicsMutex> G(lock);
+            pending = callback;
+        }
+        called.signal();
+    }
+
+    void release()
+    {
+        pva::RPCResponseCallback::shared_pointer cb;
+        {
+            epicsGuard<epicsMutex> G(lock);
+            cb.swap(pending);
+        }
+        if(cb)
+            cb->requestDone(pvd::Status::Ok, pvd::getPVDataCreate()->createPVStructure(reply_type));
+    }
+};
+
+void testLimits(const pva::ChannelProvider::shared_pointer& cli_prov,
+                pva::RPCServer& serv,
+                const std::tr1::shared_ptr<HoldService>& hold)
+{
+    testDiag("Limits");
+
+    pva::RPCClient A("hold", pvd::createRequest("field()"), cli_prov),
+                   B("hold", pvd::createRequest("field()"), cli_prov);
+
+    pvd::ValueBuilder args("epics:nt/NTURI:1.0");
+    args.add<pvd::pvString>("scheme", "pva")
+        .add<pvd::pvString>("path", "hold");
+    pvd::PVStructurePtr arg(args.buildPVStructure());
+
+    A.issueRequest(arg);
+    testOk1(hold->called.wait(5.0));
+
+    // limited to one in progress, and none waiting
+    try{
+        (void)B.request(arg, 5.0);
+        testFail("Missing expected rejection");
+    }catch(pva::RPCRequestException& e){
+        testPass("rejected: %s", e.what());
+    }
+
+    hold->release();
+    pvd::PVStructurePtr reply(A.waitResponse(5.0));
+    testOk1(!!reply);
+
+    std::vector<pva::RPCServer::ServiceStats> stats;
+    serv.getStats(stats);
+    bool found = false;
+    for(size_t i=0; i<stats.size(); i++) {
+        if(stats[i].name!="hold")
+            continue;
+        found = true;
+        testOk(stats[i].completed==1u && stats[i].rejected==1u && stats[i].active==0u,
+               "completed %u rejected %u active %u",
+               (unsigned)stats[i].completed, (unsigned)stats[i].rejected, (unsigned)stats[i].active);
+    }
+    if(!found)
+        testFail("No stats for 'hold'");
+}
+
+// holds the first request until release(), then replies to each from within request()
+struct GateService : public pva::RPCServiceAsync
+{
+    epicsMutex lock;
+    bool open;
+    pva::RPCResponseCallback::shared_pointer first;
+    epicsEvent called;
+
+    GateService() :open(false) {}
+
+    virtual void request(epics::pvData::PVStructure::shared_pointer const & args,
+                         pva::RPCResponseCallback::shared_pointer const & callback) OVERRIDE FINAL
+    {
+        {
+            epicsGuard<epicsMutex> G(lock);
+            if(!open && !first) {
+                first = callback;
+                called.signal();
+                return;
+            }
+        }
+        callback->requestDone(pvd::Status::Ok, pvd::getPVDataCreate()->createPVStructure(reply_type));
+    }
+
+    void release()
+    {
+        pva::RPCResponseCallback::shared_pointer cb;
+        {
+            epicsGuard<epicsMutex> G(lock);
+            open = true;
+            cb.swap(first);
+        }
+        if(cb)
+            cb->requestDone(pvd::Status::Ok, pvd::getPVDataCreate()->createPVStructure(reply_type));
+    }
+};
+
+bool getStats(pva::RPCServer& serv, const char *name, pva::RPCServer::ServiceStats& out)
+{
+    std::vector<pva::RPCServer::ServiceStats> stats;
+    serv.getStats(stats);
+    for(size_t i=0; i<stats.size(); i++) {
+        if(stats[i].name==name) {
+            out = stats[i];
+            return true;
+        }
+    }
+    return false;
+}
+
+// requests wait for the one slot, then run one after another as each completes
+void testQueued(const pva::ChannelProvider::shared_pointer& cli_prov,
+                pva::RPCServer& serv,
+                const std::tr1::shared_ptr<GateService>& gate)
+{
+    testDiag("Queued");
+    const size_t nreq = 50u;
+
+    pva::RPCClient client("gate", pvd::createRequest("field()"), cli_prov);
+    client.setMaxInFlight(nreq);
+
+    pvd::ValueBuilder args("epics:nt/NTURI:1.0");
+    args.add<pvd::pvString>("scheme", "pva")
+        .add<pvd::pvString>("path", "gate");
+    pvd::PVStructurePtr arg(args.buildPVStructure());
+
+    std::vector<pva::RPCClient::AsyncResponse::shared_pointer> responses;
+    for(size_t i=0; i<nreq; i++)
+        responses.push_back(client.requestAsync(arg));
+
+    testOk1(gate->called.wait(5.0));
+
+    // wait for all others to reach the server
+    pva::RPCServer::ServiceStats stats;
+    for(unsigned n=0; n<50u; n++) {
+        if(getStats(serv, "gate", stats) && stats.queued==nreq-1u)
+            break;
+        epicsThreadSleep(0.1);
+    }
+    testOk(stats.active==1u && stats.queued==nreq-1u, "active %u queued %u",
+           (unsigned)stats.active, (unsigned)stats.queued);
+
+    gate->release();
+
+    bool allok = true;
+    for(size_t i=0; i<nreq; i++) {
+        try {
+            (void)responses[i]->get(5.0);
+        } catch(std::exception& e) {
+            testDiag("Request %u error: %s", (unsigned)i, e.what());
+            allok = false;
+        }
+    }
+    testOk(allok, "All queued requests complete");
+
+    getStats(serv, "gate", stats);
+    testOk(stats.completed==nreq && stats.active==0u && stats.queued==0u,
+           "completed %u active %u queued %u",
+           (unsigned)stats.completed, (unsigned)stats.active, (unsigned)stats.queued);
+}
+
 } // namespace
 
 MAIN(testRPC)
 {
-    testPlan(3);
+    testPlan(21);
     try {
         pva::Configuration::shared_pointer conf(pva::ConfigurationBuilder()
                                                 //.push_env()
@@ -137,6 +391,10 @@ MAIN(testRPC)
             std::tr1::shared_ptr<pva::RPCService> service(new FailService);
             serv.registerService("fail", service);
         }
+        std::tr1::shared_ptr<HoldService> hold(new HoldService);
+        serv.registerService("hold", hold, pva::RPCServer::ServiceLimits(1, 0));
+        std::tr1::shared_ptr<GateService> gate(new GateService);
+        serv.registerService("gate", gate, pva::RPCServer::ServiceLimits(1, 100));
 
         testDiag("Client Setup");
         pva::ClientFactory::start();
@@ -148,6 +406,27 @@ MAIN(testRPC)
 
         testSum(cli_prov);
         testRPCFail(cli_prov);
+        testAsync(cli_prov);
+        testLimits(cli_prov, serv, hold);
+        testQueued(cli_prov, serv, gate);
+
+        testDiag("Server with workers");
+        // call services from a pool of workers
+        pva::RPCServer wserv(conf, 2);
+        {
+            std::tr1::shared_ptr<pva::RPCService> service(new SumService);
+            wserv.registerService("sum", service);
+        }
+        std::tr1::shared_ptr<GateService> wgate(new GateService);
+        wserv.registerService("gate", wgate, pva::RPCServer::ServiceLimits(1, 100));
+
+        pva::ChannelProvider::shared_pointer wcli_prov(pva::ChannelProviderRegistry::clients()->createProvider("pva",
+                                                                                                               wserv.getServer()->getCurrentConfig()));
+        if(!wcli_prov)
+            testAbort("No pva provider");
+
+        testSum(wcli_prov);
+        testQueued(wcli_prov, wserv, wgate);
 
     }catch(std::exception& e){
         PRINT_EXCEPTION(e);
@@ -0,0 +1,160 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+
+/* Measure RPC throughput against a running rpcServiceExample ("sum" service).
+ *
+ * First with RPCClient::request(), one request at a time,
+ * then with RPCClient::requestAsync() and an increasing number of requests in flight.
+ *
+ * Output is one line per pipeline depth, with the number of requests per second.
+ */
+
+#include <iostream>
+#include <deque>
+#include <string>
+
+#include <stdio.h>
+
+#include <epicsStdlib.h>
+#include <epicsGetopt.h>
+#include <epicsTime.h>
+
+#include <pv/pvData.h>
+#include <pv/rpcClient.h>
+
+namespace pvd = epics::pvData;
+namespace pva = epics::pvAccess;
+
+namespace {
+
+#define DEFAULT_ITERATIONS 100000
+#define DEFAULT_MAX_DEPTH 64
+#define DEFAULT_SERVICE "sum"
+
+pvd::PVStructure::shared_pointer makeArgs()
+{
+    pvd::PVStructure::shared_pointer args(pvd::getPVDataCreate()->createPVStructure(
+        pvd::getFieldCreate()->createFieldBuilder()
+            ->add("a", pvd::pvDouble)
+            ->add("b", pvd::pvDouble)
+            ->createStructure()));
+    args->getSubFieldT<pvd::PVDouble>("a")->put(3.14);
+    args->getSubFieldT<pvd::PVDouble>("b")->put(2.71);
+    return args;
+}
+
+void report(const char *mode, size_t depth, size_t iterations, const epicsTimeStamp& begin)
+{
+    epicsTimeStamp end;
+    epicsTimeGetCurrent(&end);
+    double duration = epicsTimeDiffInSeconds(&end, &begin);
+    printf("%s depth %zu %zu requests %.0f requests/s\n",
+           mode, depth, iterations, iterations/duration);
+}
+
+void measureSync(pva::RPCClient& client, const pvd::PVStructure::shared_pointer& args, size_t iterations)
+{
+    epicsTimeStamp begin;
+    epicsTimeGetCurrent(&begin);
+
+    for(size_t i=0u; i<iterations; i++)
+        client.request(args);
+
+    report("sync", 1u, iterations, begin);
+}
+
+void measureAsync(pva::RPCClient& client, const pvd::PVStructure::shared_pointer& args,
+                  size_t iterations, size_t depth)
+{
+    client.setMaxInFlight(depth);
+
+    std::deque<pva::RPCClient::AsyncResponse::shared_pointer> outstanding;
+
+    epicsTimeStamp begin;
+    epicsTimeGetCurrent(&begin);
+
+    for(size_t i=0u; i<iterations; i++) {
+        // keep enough queued that the pipeline never drains
+        while(outstanding.size() >= 2u*depth) {
+            outstanding.front()->get();
+            outstanding.pop_front();
+        }
+        outstanding.push_back(client.requestAsync(args));
+    }
+
+    while(!outstanding.empty()) {
+        outstanding.front()->get();
+        outstanding.pop_front();
+    }
+
+    report("async", depth, iterations, begin);
+}
+
+void usage(void)
+{
+    fprintf(stderr, "\nUsage: testRPCPerformance [options]\n\n"
+            "  -h: Help: Print this message\n"
+            "options:\n"
+            "  -s <service>:      RPC service name, default is '%s'\n"
+            "  -i <iterations>:   number of requests per measurement, default is '%d'\n"
+            "  -d <depth>:        maximum number of requests in flight, default is '%d'\n\n"
+            , DEFAULT_SERVICE, DEFAULT_ITERATIONS, DEFAULT_MAX_DEPTH);
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    std::string service(DEFAULT_SERVICE);
+    int iterations = DEFAULT_ITERATIONS;
+    int maxDepth = DEFAULT_MAX_DEPTH;
+
+    int opt;
+    while((opt = getopt(argc, argv, ":hs:i:d:")) != -1) {
+        switch(opt) {
+        case 'h':
+            usage();
+            return 0;
+        case 's':
+            service = optarg;
+            break;
+        case 'i':
+            iterations = atoi(optarg);
+            break;
+        case 'd':
+            maxDepth = atoi(optarg);
+            break;
+        default:
+            usage();
+            return 1;
+        }
+    }
+
+    if(iterations<=0 || maxDepth<=0) {
+        usage();
+        return 1;
+    }
+
+    try {
+        pva::RPCClient client(service, pvd::PVStructure::shared_pointer());
+        if(!client.connect()) {
+            fprintf(stderr, "Unable to connect to '%s'\n", service.c_str());
+            return 1;
+        }
+
+        pvd::PVStructure::shared_pointer args(makeArgs());
+
+        measureSync(client, args, iterations);
+
+        for(size_t depth=1u; depth<=size_t(maxDepth); depth*=2u)
+            measureAsync(client, args, iterations, depth);
+
+    } catch(std::exception& e) {
+        fprintf(stderr, "Error: %s\n", e.what());
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,29 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+#ifndef TESTSERVERCONFIG_H
+#define TESTSERVERCONFIG_H
+
+#include <pv/configuration.h>
+
+/* Configuration of a test server (and of clients built from its getCurrentConfig())
+ * which is isolated to the loopback interface, with TCP and UDP ports chosen by the OS.
+ *
+ * Further settings may be added before push_map().  eg.
+ *
+ *   TestServerConfig().add("EPICS_PVAS_METRICS_PREFIX", "tst:").push_map().build()
+ */
+struct TestServerConfig : public epics::pvAccess::ConfigurationBuilder
+{
+    TestServerConfig()
+    {
+        add("EPICS_PVAS_INTF_ADDR_LIST", "127.0.0.1");
+        add("EPICS_PVA_ADDR_LIST", "127.0.0.1");
+        add("EPICS_PVA_AUTO_ADDR_LIST", "0");
+        add("EPICS_PVA_SERVER_PORT", "0");
+        add("EPICS_PVA_BROADCAST_PORT", "0");
+    }
+};
+
+#endif // TESTSERVERCONFIG_H
@@ -2,12 +2,28 @@
  * testServerContext.cpp
  */
 
-#include <pv/serverContext.h>
+#include <vector>
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+
+#include <osiSock.h>
 #include <epicsExit.h>
+#include <epicsGuard.h>
+#include <epicsMutex.h>
+#include <epicsThread.h>
 #include <testMain.h>
 
 #include <epicsUnitTest.h>
 
+#include <pv/serverContext.h>
+#include <pv/configuration.h>
+#include <pv/pvaConstants.h>
+#include <pv/remote.h>
+#include <pv/serverContextImpl.h>
+
+#include "testServerConfig.h"
+
 namespace {
 
 using namespace epics::pvAccess;
@@ -63,11 +79,301 @@ public:
     }
 };
 
+/* Answers channelFind() according to the name prefix.
+ *  "found..."   found, synchronously
+ *  "missing..." not found, synchronously
+ *  "late..."    held until answerLate(), then found
+ *  other        never answered
+ */
+class SearchProvider : public TestChannelProvider
+{
+public:
+    epicsMutex lock;
+    std::vector<ChannelFindRequester::shared_pointer> late;
+
+    ChannelFind::shared_pointer channelFind(std::string const & channelName,
+                                            ChannelFindRequester::shared_pointer const & channelFindRequester)
+    {
+        ChannelFind::shared_pointer nullCF;
+        if(channelName.compare(0, 5, "found")==0) {
+            channelFindRequester->channelFindResult(Status::Ok, nullCF, true);
+        } else if(channelName.compare(0, 7, "missing")==0) {
+            channelFindRequester->channelFindResult(Status::Ok, nullCF, false);
+        } else if(channelName.compare(0, 4, "late")==0) {
+            epicsGuard<epicsMutex> G(lock);
+            late.push_back(channelFindRequester);
+        }
+        return nullCF;
+    }
+
+    size_t answerLate()
+    {
+        std::vector<ChannelFindRequester::shared_pointer> todo;
+        {
+            epicsGuard<epicsMutex> G(lock);
+            todo.swap(late);
+        }
+        for(size_t i=0; i<todo.size(); i++)
+            todo[i]->channelFindResult(Status::Ok, ChannelFind::shared_pointer(), true);
+        return todo.size();
+    }
+};
+
+// UDP socket to send CMD_SEARCH and receive the responses
+struct Searcher {
+    SOCKET sock;
+    osiSockAddr server;
+
+    explicit Searcher(unsigned short port)
+        :sock(epicsSocketCreate(AF_INET, SOCK_DGRAM, IPPROTO_UDP))
+    {
+        if(sock==INVALID_SOCKET)
+            testAbort("Unable to create socket");
+        osiSockAddr addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.ia.sin_family = AF_INET;
+        addr.ia.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if(::bind(sock, &addr.sa, sizeof(addr.ia)))
+            testAbort("Unable to bind socket");
+
+        memset(&server, 0, sizeof(server));
+        server.ia.sin_family = AF_INET;
+        server.ia.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        server.ia.sin_port = htons(port);
+    }
+    ~Searcher() {
+        epicsSocketDestroy(sock);
+    }
+
+    void search(int32 seq, const std::vector<std::string>& names)
+    {
+        std::vector<char> buf(4096);
+        ByteBuffer B(&buf[0], buf.size(), EPICS_ENDIAN_BIG);
+
+        B.putByte(PVA_MAGIC);
+        B.putByte(PVA_CLIENT_PROTOCOL_REVISION);
+        B.putByte((int8)0x80); // client, big endian
+        B.putByte(CMD_SEARCH);
+        B.putInt(0); // payload size, filled in below
+
+        B.putInt(seq);
+        B.putByte(QOS_REPLY_REQUIRED);
+        B.putByte(0);
+        B.putShort(0);
+        for(size_t i=0; i<16; i++)
+            B.putByte(0); // reply to sender
+        B.putShort(0);  // port, 0 is sender's
+        B.putByte(1);
+        B.putByte(3);
+        B.put("tcp", 0, 3);
+        B.putShort((int16)names.size());
+        for(size_t i=0; i<names.size(); i++) {
+            B.putInt((int32)i);
+            B.putByte((int8)names[i].size());
+            B.put(names[i].c_str(), 0, names[i].size());
+        }
+        B.putInt(4, int32(B.getPosition()-PVA_MESSAGE_HEADER_SIZE));
+
+        if(::sendto(sock, &buf[0], B.getPosition(), 0, &server.sa, sizeof(server.ia))<0)
+            testAbort("Unable to send search");
+    }
+
+    /* Wait for one CMD_SEARCH_RESPONSE.
+     * @returns false on timeout
+     */
+    bool response(double timeout, bool& found, std::vector<int32>& cids)
+    {
+        fd_set fds;
+        FD_ZERO(&fds);
+        FD_SET(sock, &fds);
+        timeval tmo;
+        tmo.tv_sec = long(timeout);
+        tmo.tv_usec = long((timeout-tmo.tv_sec)*1e6);
+        if(::select(int(sock+1), &fds, 0, 0, &tmo)<=0)
+            return false;
+
+        std::vector<char> buf(0x10000);
+        int n = ::recv(sock, &buf[0], buf.size(), 0);
+        if(n < int(PVA_MESSAGE_HEADER_SIZE))
+            return false;
+
+        ByteBuffer B(&buf[0], n);
+        B.setPosition(2);
+        const int8 flags = B.getByte();
+        B.setEndianess((flags&0x80) ? EPICS_ENDIAN_BIG : EPICS_ENDIAN_LITTLE);
+        if(B.getByte()!=CMD_SEARCH_RESPONSE)
+            return false;
+        B.getInt();
+        B.setPosition(B.getPosition()+12+4+16+2); // GUID, seq, address, port
+        B.setPosition(B.getPosition()+1+B.getByte()); // protocol
+        found = B.getByte()!=0;
+        const size_t count = B.getShort()&0xffff;
+        cids.clear();
+        for(size_t i=0; i<count; i++)
+            cids.push_back(B.getInt());
+        return true;
+    }
+};
+
+ServerContext::shared_pointer startSearchServer(const ChannelProvider::shared_pointer& prov)
+{
+    return ServerContext::create(ServerContext::Config()
+                                 .config(TestServerConfig()
+                                         .push_map()
+                                         .build())
+                                 .provider(prov));
+}
+
+// all names of one search are answered with one response per result
+void testSearchBatch()
+{
+    testDiag("testSearchBatch");
+
+    std::tr1::shared_ptr<SearchProvider> prov(new SearchProvider);
+    ServerContext::shared_pointer ctx(startSearchServer(prov));
+    Searcher S(ctx->getBroadcastPort());
+
+    std::vector<std::string> names;
+    for(size_t i=0; i<100; i++) {
+        char buf[16];
+        sprintf(buf, i%2 ? "found%u" : "missing%u", unsigned(i));
+        names.push_back(buf);
+    }
+    S.search(1, names);
+
+    size_t nfound = 0u, nmissing = 0u, nresponse = 0u;
+    bool found;
+    std::vector<int32> cids;
+    while(S.response(1.0, found, cids)) {
+        nresponse++;
+        testDiag("response found=%c count=%u", found ? 'Y' : 'N', unsigned(cids.size()));
+        for(size_t i=0; i<cids.size(); i++) {
+            if(cids[i]<0 || cids[i]>=int32(names.size()) || (names[cids[i]][0]=='f')!=found)
+                testDiag("wrong result for cid %d", cids[i]);
+            else if(found)
+                nfound++;
+            else
+                nmissing++;
+        }
+    }
+    testOk(nresponse==2u, "%u responses", unsigned(nresponse));
+    testOk(nfound==50u && nmissing==50u, "found %u missing %u", unsigned(nfound), unsigned(nmissing));
+
+    ctx->shutdown();
+}
+
+// results gathered while other names are outstanding are sent after the gather window
+void testSearchGather()
+{
+    testDiag("testSearchGather");
+
+    std::tr1::shared_ptr<SearchProvider> prov(new SearchProvider);
+    ServerContext::shared_pointer ctx(startSearchServer(prov));
+    Searcher S(ctx->getBroadcastPort());
+
+    std::vector<std::string> names;
+    names.push_back("found0");
+    names.push_back("late1");
+    names.push_back("never2");
+    names.push_back("found3");
+    S.search(2, names);
+
+    bool found = false;
+    std::vector<int32> cids;
+    testOk(S.response(1.0, found, cids) && found && cids.size()==2u,
+           "synchronous results after gather window.  found=%c count=%u", found ? 'Y' : 'N', unsigned(cids.size()));
+
+    // wait for the late name to reach the provider
+    size_t nlate = 0u;
+    for(unsigned n=0; n<10u && !nlate; n++) {
+        epicsThreadSleep(0.01);
+        nlate = prov->answerLate();
+    }
+    testOk(nlate==1u, "answered %u late", unsigned(nlate));
+
+    testOk(S.response(1.0, found, cids) && found && cids.size()==1u && cids[0]==1,
+           "late result.  found=%c count=%u", found ? 'Y' : 'N', unsigned(cids.size()));
+
+    testOk(!S.response(0.1, found, cids), "no empty or duplicate responses");
+
+    ctx->shutdown();
+}
+
+// a name answered by several providers is reported once
+void testSearchProviders()
+{
+    testDiag("testSearchProviders");
+
+    std::vector<ChannelProvider::shared_pointer> provs;
+    provs.push_back(ChannelProvider::shared_pointer(new SearchProvider));
+    provs.push_back(ChannelProvider::shared_pointer(new TestChannelProvider)); // never found
+    provs.push_back(ChannelProvider::shared_pointer(new SearchProvider));
+
+    ServerContext::shared_pointer ctx(ServerContext::create(ServerContext::Config()
+                                                            .config(TestServerConfig()
+                                                                    .push_map()
+                                                                    .build())
+                                                            .providers(provs)));
+    Searcher S(ctx->getBroadcastPort());
+
+    std::vector<std::string> names;
+    names.push_back("found0");
+    names.push_back("missing1");
+    names.push_back("found2");
+    S.search(3, names);
+
+    std::vector<int32> found, missing;
+    bool isFound;
+    std::vector<int32> cids;
+    while(S.response(1.0, isFound, cids)) {
+        std::vector<int32>& dest = isFound ? found : missing;
+        dest.insert(dest.end(), cids.begin(), cids.end());
+    }
+
+    std::sort(found.begin(), found.end());
+    testOk(found.size()==2u && found[0]==0 && found[1]==2, "found %u names", unsigned(found.size()));
+    testOk(missing.size()==1u && missing[0]==1, "missing %u names", unsigned(missing.size()));
+
+    ctx->shutdown();
+}
+
+void testSearchNegativeCache()
+{
+    testDiag("testSearchNegativeCache");
+
+    SearchNegativeCache cache;
+
+    testOk1(!cache.enabled());
+    cache.add("a", SearchNegativeCache::generation());
+    testOk1(!cache.missing("a"));
+    testOk1(cache.size()==0u);
+
+    cache.configure(100.0);
+    testOk1(cache.enabled());
+    testOk1(cache.getTimeout()==100.0);
+    cache.add("a", SearchNegativeCache::generation());
+    testOk1(cache.missing("a"));
+    testOk1(!cache.missing("b"));
+
+    // a provider gains a name while a search is in progress
+    size_t gen = SearchNegativeCache::generation();
+    ServerContext::invalidateSearchCache();
+    testOk(!cache.missing("a"), "invalidate clears entries");
+    cache.add("b", gen);
+    testOk(!cache.missing("b"), "add() with stale generation ignored");
+    cache.add("b", SearchNegativeCache::generation());
+    testOk1(cache.missing("b"));
+
+    cache.configure(0.0);
+    testOk1(!cache.enabled());
+    testOk1(!cache.missing("b"));
+}
+
 } // namespace
 
 MAIN(testServerContext)
 {
-    testPlan(2);
+    testPlan(22);
 
     ChannelProvider::shared_pointer prov(new TestChannelProvider);
     ServerContext::shared_pointer ctx(ServerContext::create(ServerContext::Config()
@@ -84,5 +390,10 @@ MAIN(testServerContext)
 
     testOk(!wctx.lock(), "# ServerContext cleanup leaves use_count=%u", (unsigned)wctx.use_count());
 
+    testSearchBatch();
+    testSearchGather();
+    testSearchProviders();
+    testSearchNegativeCache();
+
     return testDone();
 }
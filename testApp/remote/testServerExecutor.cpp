@@ -0,0 +1,167 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+
+#include <vector>
+
+#include <epicsEvent.h>
+#include <epicsThread.h>
+#include <epicsAtomic.h>
+#include <testMain.h>
+#include <epicsUnitTest.h>
+
+#include <pv/lock.h>
+#include <pv/serverExecutor.h>
+
+namespace pvd = epics::pvData;
+namespace pva = epics::pvAccess;
+
+namespace {
+
+// records the order in which Work of one Strand is run
+struct Recorder {
+    pvd::Mutex mutex;
+    std::vector<int> order;
+    size_t running, maxRunning;
+    Recorder() :running(0u), maxRunning(0u) {}
+};
+
+struct RecordWork : public pva::ServerExecutor::Work {
+    Recorder& rec;
+    const int id;
+    RecordWork(Recorder& rec, int id) :rec(rec), id(id) {}
+    virtual ~RecordWork() {}
+    virtual void run() OVERRIDE FINAL {
+        {
+            pvd::Lock G(rec.mutex);
+            rec.order.push_back(id);
+            if(++rec.running > rec.maxRunning)
+                rec.maxRunning = rec.running;
+        }
+        epicsThreadSleep(0.001);
+        {
+            pvd::Lock G(rec.mutex);
+            rec.running--;
+        }
+    }
+};
+
+// blocks until released
+struct BlockWork : public pva::ServerExecutor::Work {
+    epicsEvent started, release;
+    virtual ~BlockWork() {}
+    virtual void run() OVERRIDE FINAL {
+        started.signal();
+        release.wait();
+    }
+};
+
+struct SignalWork : public pva::ServerExecutor::Work {
+    epicsEvent done;
+    virtual ~SignalWork() {}
+    virtual void run() OVERRIDE FINAL {
+        done.signal();
+    }
+};
+
+void waitIdle(pva::ServerExecutor& exec)
+{
+    for(unsigned i=0; i<1000; i++) {
+        pva::ServerExecutor::Stats stats;
+        exec.getStats(stats);
+        if(stats.pending==0u)
+            return;
+        epicsThreadSleep(0.01);
+    }
+    testFail("Timeout waiting for executor");
+}
+
+void testOrdering()
+{
+    testDiag("%s", __FUNCTION__);
+
+    pva::ServerExecutor exec(4);
+    testOk1(exec.workerCount()==4u);
+
+    pva::ServerExecutor::Strand::shared_pointer A(new pva::ServerExecutor::Strand),
+                                                B(new pva::ServerExecutor::Strand);
+    Recorder recA, recB;
+
+    for(int i=0; i<20; i++) {
+        exec.execute(A, pva::ServerExecutor::Work::shared_pointer(new RecordWork(recA, i)));
+        exec.execute(B, pva::ServerExecutor::Work::shared_pointer(new RecordWork(recB, i)));
+    }
+
+    waitIdle(exec);
+
+    bool inorder = recA.order.size()==20u && recB.order.size()==20u;
+    for(int i=0; inorder && i<20; i++)
+        inorder = recA.order[i]==i && recB.order[i]==i;
+    testOk(inorder, "Work of each strand runs in order");
+    testOk(recA.maxRunning==1u && recB.maxRunning==1u, "Work of each strand runs one at a time");
+
+    pva::ServerExecutor::Stats stats;
+    exec.getStats(stats);
+    testOk(stats.executed==40u, "executed %u", (unsigned)stats.executed);
+}
+
+void testNoHeadOfLineBlocking()
+{
+    testDiag("%s", __FUNCTION__);
+
+    pva::ServerExecutor exec(2);
+
+    pva::ServerExecutor::Strand::shared_pointer slow(new pva::ServerExecutor::Strand),
+                                                fast(new pva::ServerExecutor::Strand);
+
+    std::tr1::shared_ptr<BlockWork> block(new BlockWork);
+    std::tr1::shared_ptr<SignalWork> after(new SignalWork), other(new SignalWork);
+
+    exec.execute(slow, block);
+    testOk1(block->started.wait(5.0));
+
+    exec.execute(slow, after);
+    exec.execute(fast, other);
+
+    testOk(other->done.wait(5.0), "Other strand not blocked");
+    testOk(!after->done.tryWait(), "Same strand waits");
+
+    block->release.signal();
+    testOk1(after->done.wait(5.0));
+}
+
+void testClose()
+{
+    testDiag("%s", __FUNCTION__);
+
+    pva::ServerExecutor exec(1);
+    pva::ServerExecutor::Strand::shared_pointer S(new pva::ServerExecutor::Strand);
+
+    std::tr1::shared_ptr<BlockWork> block(new BlockWork);
+    std::tr1::shared_ptr<SignalWork> never(new SignalWork);
+
+    exec.execute(S, block);
+    testOk1(block->started.wait(5.0));
+    exec.execute(S, never);
+
+    block->release.signal();
+    exec.close();
+
+    // may or may not have run before close().  Must not run after.
+    never->done.tryWait();
+    exec.execute(S, never);
+    epicsThreadSleep(0.1);
+    testOk(!never->done.tryWait(), "No work run after close()");
+}
+
+} // namespace
+
+MAIN(testServerExecutor)
+{
+    testPlan(10);
+    testOrdering();
+    testNoHeadOfLineBlocking();
+    testClose();
+    return testDone();
+}
@@ -0,0 +1,61 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+#ifndef TESTSERVERFIXTURE_H
+#define TESTSERVERFIXTURE_H
+
+#include <pva/client.h>
+#include <pva/sharedstate.h>
+#include <pv/serverContext.h>
+#include <pv/configuration.h>
+
+#include "testServerConfig.h"
+
+/* A server of one StaticProvider, isolated as by TestServerConfig,
+ * and a client connected to it over the network.
+ *
+ *   TestServer S(prov);
+ *   pvac::MonitorSync mon(S.cli.connect("pv:name").monitor());
+ */
+struct TestServer
+{
+    const epics::pvAccess::ServerContext::shared_pointer serv;
+    pvac::ClientProvider cli;
+
+    explicit TestServer(const std::tr1::shared_ptr<pvas::StaticProvider>& prov)
+        :serv(epics::pvAccess::ServerContext::create(epics::pvAccess::ServerContext::Config()
+                                                     .config(TestServerConfig()
+                                                             .push_map()
+                                                             .build())
+                                                     .provider(prov->provider())))
+        ,cli("pva", serv->getCurrentConfig())
+    {}
+
+    //! @param conf eg. TestServerConfig().add(...).push_map().build()
+    TestServer(const std::tr1::shared_ptr<pvas::StaticProvider>& prov,
+               const epics::pvAccess::Configuration::shared_pointer& conf)
+        :serv(epics::pvAccess::ServerContext::create(epics::pvAccess::ServerContext::Config()
+                                                     .config(conf)
+                                                     .provider(prov->provider())))
+        ,cli("pva", serv->getCurrentConfig())
+    {}
+};
+
+/* Extract the next update of a subscription into mon.root , waiting if none is queued.
+ * Gives up after 'timeout' seconds without an event, or after 20 events without data.
+ *
+ *   while(!seen && testNextUpdate(mon)) { seen = ... mon.root ...; }
+ */
+inline bool testNextUpdate(pvac::MonitorSync& mon, double timeout = 5.0)
+{
+    if(mon.poll())
+        return true; // remaining from a previous Data event
+    for(unsigned i=0; i<20 && mon.wait(timeout); i++) {
+        if(mon.event.event==pvac::MonitorEvent::Data && mon.poll())
+            return true;
+    }
+    return false;
+}
+
+#endif // TESTSERVERFIXTURE_H
@@ -0,0 +1,104 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+
+#include <vector>
+#include <algorithm>
+
+#include <pv/pvUnitTest.h>
+#include <testMain.h>
+#include <epicsMutex.h>
+#include <epicsGuard.h>
+
+#include <pva/client.h>
+#include <pva/sharedstate.h>
+#include <pv/current_function.h>
+
+#include "testServerFixture.h"
+
+namespace pvd = epics::pvData;
+namespace pva = epics::pvAccess;
+
+namespace {
+
+// allocates new storage for each call, and remembers where
+struct TrackingAllocator : public pva::ArrayAllocator
+{
+    epicsMutex lock;
+    std::vector<const void*> allocated;
+    virtual ~TrackingAllocator() {}
+    virtual pvd::shared_vector<void> allocate(pvd::ScalarType type, size_t) OVERRIDE FINAL
+    {
+        if(type!=pvd::pvDouble)
+            return pvd::shared_vector<void>();
+        // not kept here, so that the caller has the only reference
+        pvd::shared_vector<double> storage(16u);
+        epicsGuard<epicsMutex> G(lock);
+        allocated.push_back(storage.data());
+        return pvd::static_shared_vector_cast<void>(storage);
+    }
+    bool owns(const void *ptr) {
+        epicsGuard<epicsMutex> G(lock);
+        return std::find(allocated.begin(), allocated.end(), ptr)!=allocated.end();
+    }
+    size_t count() {
+        epicsGuard<epicsMutex> G(lock);
+        return allocated.size();
+    }
+};
+
+void testArrayAllocator()
+{
+    testDiag("==== %s ====", CURRENT_FUNCTION);
+
+    const pvd::StructureConstPtr atype(pvd::getFieldCreate()->createFieldBuilder()
+                                       ->addArray("value", pvd::pvDouble)
+                                       ->createStructure());
+
+    std::tr1::shared_ptr<pvas::StaticProvider> prov(new pvas::StaticProvider("test"));
+    std::tr1::shared_ptr<pvas::SharedPV> pv(pvas::SharedPV::buildReadOnly());
+    prov->add("pv:alloc", pv);
+    pv->open(atype);
+
+    TestServer S(prov);
+
+    std::tr1::shared_ptr<TrackingAllocator> alloc(new TrackingAllocator);
+    pvac::ClientChannel::Options opts;
+    opts.allocator = alloc;
+    pvac::ClientChannel chan(S.cli.connect("pv:alloc", opts));
+
+    pvd::PVStructurePtr inst(pv->build());
+    pvd::PVDoubleArrayPtr value(inst->getSubFieldT<pvd::PVDoubleArray>("value"));
+    pvd::PVDoubleArray::svector data(3u);
+    data[0] = 1.0; data[1] = 2.0; data[2] = 3.0;
+    value->replace(pvd::freeze(data));
+    pv->post(*inst, pvd::BitSet().set(value->getFieldOffset()));
+
+    pvac::MonitorSync mon(chan.monitor());
+
+    bool gotData = testNextUpdate(mon);
+    testOk(gotData, "Received update");
+
+    if(gotData) {
+        pvd::PVDoubleArray::const_svector arr(mon.root->getSubFieldT<pvd::PVDoubleArray>("value")->view());
+        testOk(alloc->owns(arr.data()), "Received into allocator storage");
+        testOk(arr.size()==3u && arr[0]==1.0 && arr[2]==3.0, "Received values");
+    } else {
+        testSkip(2, "No data");
+    }
+    testOk(alloc->count()>0u, "allocate() called %u times", (unsigned)alloc->count());
+}
+
+} // namespace
+
+MAIN(testarrayallocator)
+{
+    testPlan(4);
+    try {
+        testArrayAllocator();
+    }catch(std::exception& e){
+        testAbort("Unexpected exception: %s", e.what());
+    }
+    return testDone();
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+
+#include <vector>
+#include <sstream>
+
+#include <pv/pvUnitTest.h>
+#include <testMain.h>
+
+#include <pva/client.h>
+#include <pva/sharedstate.h>
+#include <pv/current_function.h>
+
+#include "testServerFixture.h"
+
+namespace pvd = epics::pvData;
+namespace pva = epics::pvAccess;
+
+namespace {
+
+const pvd::StructureConstPtr type(pvd::getFieldCreate()->createFieldBuilder()
+                                  ->add("value", pvd::pvInt)
+                                  ->createStructure());
+
+void testCreateChannels(bool multi)
+{
+    testDiag("==== %s multi=%c ====", CURRENT_FUNCTION, multi ? 'Y' : 'N');
+
+    // more than one CMD_CREATE_CHANNEL message worth
+    const size_t npvs = 300u;
+
+    std::tr1::shared_ptr<pvas::StaticProvider> prov(new pvas::StaticProvider("test"));
+    std::vector<std::string> names(npvs);
+    for(size_t i=0; i<npvs; i++) {
+        std::tr1::shared_ptr<pvas::SharedPV> pv(pvas::SharedPV::buildReadOnly());
+        pvd::PVStructurePtr inst(pvd::getPVDataCreate()->createPVStructure(type));
+        inst->getSubFieldT<pvd::PVScalar>("value")->putFrom<pvd::uint32>(i);
+        pv->open(*inst);
+
+        std::ostringstream name;
+        name<<"pv:create"<<i;
+        names[i] = name.str();
+        prov->add(names[i], pv);
+    }
+
+    TestServer S(prov, TestServerConfig()
+                       .add("EPICS_PVAS_MULTI_CREATE", multi ? "YES" : "NO")
+                       .push_map()
+                       .build());
+
+    // begin connecting all channels before waiting for any, so that their creates are sent together
+    std::vector<pvac::ClientChannel> chans(npvs);
+    for(size_t i=0; i<npvs; i++)
+        chans[i] = S.cli.connect(names[i]);
+
+    size_t nok = 0u;
+    for(size_t i=0; i<npvs; i++) {
+        pvd::PVStructure::const_shared_pointer root(chans[i].get());
+        if(root->getSubFieldT<pvd::PVScalar>("value")->getAs<pvd::uint32>()==i)
+            nok++;
+    }
+    testEqual(nok, npvs);
+}
+
+} // namespace
+
+MAIN(testcreatechannels)
+{
+    testPlan(2);
+    try {
+        testCreateChannels(true);
+        testCreateChannels(false);
+    }catch(std::exception& e){
+        testAbort("Unexpected exception: %s", e.what());
+    }
+    return testDone();
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+
+#include <pv/pvUnitTest.h>
+#include <testMain.h>
+
+#include <pva/client.h>
+#include <pva/sharedstate.h>
+#include <pv/current_function.h>
+
+#include "testServerFixture.h"
+
+namespace pvd = epics::pvData;
+namespace pva = epics::pvAccess;
+
+namespace {
+
+const pvd::StructureConstPtr type(pvd::getFieldCreate()->createFieldBuilder()
+                                  ->add("value", pvd::pvInt)
+                                  ->createStructure());
+
+void testLoopback()
+{
+    testDiag("==== %s ====", CURRENT_FUNCTION);
+
+    std::tr1::shared_ptr<pvas::StaticProvider> prov(new pvas::StaticProvider("test"));
+    std::tr1::shared_ptr<pvas::SharedPV> pv(pvas::SharedPV::buildReadOnly());
+    prov->add("pv:name", pv);
+
+    pvd::PVStructurePtr inst(pvd::getPVDataCreate()->createPVStructure(type));
+    inst->getSubFieldT<pvd::PVScalar>("value")->putFrom<pvd::uint32>(43);
+    pv->open(*inst);
+
+    TestServer S(prov, TestServerConfig()
+                       .add("EPICS_PVAS_METRICS_PREFIX", "tst:")
+                       .push_map()
+                       .build());
+
+    // connects in-process, unlike S.cli
+    pvac::ClientProvider cli("pva", pva::ConfigurationBuilder()
+                             .push_config(S.serv->getCurrentConfig())
+                             .add("EPICS_PVA_LOOPBACK", "YES")
+                             .push_map()
+                             .build());
+
+    pvd::PVStructure::const_shared_pointer root(cli.connect("pv:name").get());
+    testEqual(root->getSubFieldT<pvd::PVScalar>("value")->getAs<pvd::uint32>(), 43u);
+
+    pvac::MonitorSync mon(cli.connect("tst:clients").monitor());
+
+    // initial value is empty.  Wait for an update which lists our connection
+    bool loopback = false;
+    while(!loopback && testNextUpdate(mon)) {
+        pvd::PVStringArray::const_svector peers(mon.root->getSubFieldT<pvd::PVStringArray>("value.peer")->view());
+        for(size_t p=0; p<peers.size(); p++)
+            loopback |= peers[p].find("loopback:")==0u;
+    }
+    testOk(loopback, "Connected in-process");
+}
+
+} // namespace
+
+MAIN(testloopback)
+{
+    testPlan(2);
+    try {
+        testLoopback();
+    }catch(std::exception& e){
+        testAbort("Unexpected exception: %s", e.what());
+    }
+    return testDone();
+}
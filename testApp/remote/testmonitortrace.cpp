@@ -0,0 +1,81 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+
+#include <pv/pvUnitTest.h>
+#include <testMain.h>
+
+#include <pva/client.h>
+#include <pva/sharedstate.h>
+#include <pv/current_function.h>
+
+#include "testServerFixture.h"
+
+namespace pvd = epics::pvData;
+namespace pva = epics::pvAccess;
+
+namespace {
+
+const pvd::StructureConstPtr type(pvd::getFieldCreate()->createFieldBuilder()
+                                  ->add("value", pvd::pvInt)
+                                  ->createStructure());
+
+void testTrace()
+{
+    testDiag("==== %s ====", CURRENT_FUNCTION);
+
+    std::tr1::shared_ptr<pvas::StaticProvider> prov(new pvas::StaticProvider("test"));
+    std::tr1::shared_ptr<pvas::SharedPV> pv(pvas::SharedPV::buildReadOnly());
+    prov->add("pv:name", pv);
+
+    pvd::PVStructurePtr inst(pvd::getPVDataCreate()->createPVStructure(type));
+    pv->open(*inst);
+
+    TestServer S(prov);
+
+    pvac::MonitorSync mon(S.cli.connect("pv:name").monitor(pvd::createRequest("record[trace=true]field()")));
+
+    // initial update, sent on connect, is not from post()
+    testOk1(mon.wait(5.0));
+    testOk1(mon.poll());
+    testEqual(mon.trace.id, pvd::uint64(0u));
+    testOk(mon.trace.latency()>=0.0, "initial latency %f", mon.trace.latency());
+
+    {
+        pvd::BitSet changed;
+        pvd::PVScalarPtr value(inst->getSubFieldT<pvd::PVScalar>("value"));
+        value->putFrom<pvd::uint32>(42);
+        changed.set(value->getFieldOffset());
+        pv->post(*inst, changed);
+    }
+
+    pvd::uint64 id = 0u;
+    double latency = -1.0;
+    while(id==0u && testNextUpdate(mon)) {
+        id = mon.trace.id;
+        latency = mon.trace.latency();
+    }
+    testOk(id!=0u, "posted update ID %llu", (unsigned long long)id);
+    testOk(latency>=0.0, "posted latency %f", latency);
+
+    pva::Monitor::Stats stats;
+    mon.stats(stats);
+    size_t total = 0u;
+    for(size_t i=0; i<pva::Monitor::Stats::nlatency; i++)
+        total += stats.latency[i];
+    testOk(total>=2u, "latency histogram counts %u", (unsigned)total);
+}
+
+} // namespace
+
+MAIN(testmonitortrace)
+{
+    testPlan(7);
+    try {
+        testTrace();
+    }catch(std::exception& e){
+        testAbort("Unexpected exception: %s", e.what());
+    }
+    return testDone();
+}
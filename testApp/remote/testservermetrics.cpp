@@ -0,0 +1,57 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+
+#include <pv/pvUnitTest.h>
+#include <testMain.h>
+
+#include <pva/client.h>
+#include <pva/sharedstate.h>
+#include <pv/current_function.h>
+
+#include "testServerFixture.h"
+
+namespace pvd = epics::pvData;
+namespace pva = epics::pvAccess;
+
+namespace {
+
+void testServerMetrics()
+{
+    testDiag("==== %s ====", CURRENT_FUNCTION);
+
+    std::tr1::shared_ptr<pvas::StaticProvider> prov(new pvas::StaticProvider("test"));
+
+    TestServer S(prov, TestServerConfig()
+                       .add("EPICS_PVAS_METRICS_PREFIX", "tst:")
+                       .add("EPICS_PVAS_METRICS_PERIOD", "0.1")
+                       .push_map()
+                       .build());
+
+    testEqual(S.serv->getCurrentConfig()->getPropertyAsString("EPICS_PVAS_PROVIDER_NAMES", ""), "test");
+
+    pvd::PVStructure::const_shared_pointer table(S.cli.connect("tst:clients").get());
+    testEqual(table->getSubFieldT<pvd::PVStringArray>("labels")->view().size(), 8u);
+
+    pvac::MonitorSync mon(S.cli.connect("tst:connections").monitor());
+
+    // initial value is 0.  Wait for an update which counts our connection
+    pvd::uint64 connections = 0u;
+    while(connections==0u && testNextUpdate(mon))
+        connections = mon.root->getSubFieldT<pvd::PVScalar>("value")->getAs<pvd::uint64>();
+    testOk(connections>=1u, "connections %u", (unsigned)connections);
+}
+
+} // namespace
+
+MAIN(testservermetrics)
+{
+    testPlan(3);
+    try {
+        testServerMetrics();
+    }catch(std::exception& e){
+        testAbort("Unexpected exception: %s", e.what());
+    }
+    return testDone();
+}
@@ -0,0 +1,100 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+
+#include <vector>
+#include <algorithm>
+
+#include <pv/pvUnitTest.h>
+#include <testMain.h>
+
+#include <pva/client.h>
+#include <pva/sharedstate.h>
+#include <pv/current_function.h>
+
+namespace pvd = epics::pvData;
+
+namespace {
+
+struct CountReleaser : public pvas::BufferReleaser
+{
+    std::vector<const void*> released;
+    virtual ~CountReleaser() {}
+    virtual void release(const void* buffer) OVERRIDE FINAL
+    {
+        released.push_back(buffer);
+    }
+    bool wasReleased(const void* buffer) const
+    {
+        return std::find(released.begin(), released.end(), buffer)!=released.end();
+    }
+};
+
+void testWrapBuffer()
+{
+    testDiag("==== %s ====", CURRENT_FUNCTION);
+
+    std::tr1::shared_ptr<CountReleaser> releaser(new CountReleaser);
+    static const double A[] = {1.0, 2.0, 3.0},
+                        B[] = {4.0, 5.0};
+
+    {
+        const pvd::StructureConstPtr atype(pvd::getFieldCreate()->createFieldBuilder()
+                                           ->addArray("value", pvd::pvDouble)
+                                           ->createStructure());
+
+        std::tr1::shared_ptr<pvas::StaticProvider> prov(new pvas::StaticProvider("test"));
+        std::tr1::shared_ptr<pvas::SharedPV> pv(pvas::SharedPV::buildReadOnly());
+
+        prov->add("pv:array", pv);
+
+        pv->open(atype);
+
+        pvd::PVStructurePtr inst(pv->build());
+        pvd::PVDoubleArrayPtr value(inst->getSubFieldT<pvd::PVDoubleArray>("value"));
+        pvd::BitSet changed;
+        changed.set(value->getFieldOffset());
+
+        value->replace(pvas::wrapBuffer(A, 3u, releaser));
+        pv->post(*inst, changed);
+
+        pvac::ClientProvider cli(prov->provider());
+        pvac::ClientChannel chan(cli.connect("pv:array"));
+        pvac::MonitorSync mon(chan.monitor());
+
+        testOk1(mon.test());
+        testOk1(mon.poll());
+        {
+            pvd::PVDoubleArray::const_svector arr(mon.root->getSubFieldT<pvd::PVDoubleArray>("value")->view());
+            testOk(arr.data()==A, "Update shares buffer A");
+        }
+
+        value->replace(pvas::wrapBuffer(B, 2u, releaser));
+        pv->post(*inst, changed);
+
+        testOk1(!releaser->wasReleased(A)); // still held by the subscriber
+
+        testOk1(mon.test());
+        testOk1(mon.poll());
+        testOk(releaser->wasReleased(A), "A released once replaced and sent");
+        testOk1(!releaser->wasReleased(B)); // current value
+    }
+
+    // all references to B are gone with the channel and PV
+    testOk(releaser->wasReleased(B), "B released on close");
+    testOk1(!epics::pvAccess::detail::haveWrappedBuffers());
+}
+
+} // namespace
+
+MAIN(testwrapbuffer)
+{
+    testPlan(10);
+    try {
+        testWrapBuffer();
+    }catch(std::exception& e){
+        testAbort("Unexpected exception: %s", e.what());
+    }
+    return testDone();
+}
@@ -0,0 +1,174 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * pvAccessCPP is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <stdexcept>
+#include <stdio.h>
+
+#include <epicsUnitTest.h>
+#include <testMain.h>
+#include <epicsMutex.h>
+#include <epicsGuard.h>
+#include <epicsEvent.h>
+#include <epicsThread.h>
+
+#include <pv/security.h>
+
+namespace pva = epics::pvAccess;
+
+namespace {
+
+typedef epicsGuard<epicsMutex> Guard;
+
+// lookup function which counts calls, and names the single role by the call count
+epicsMutex lookupLock;
+unsigned lookupCalls;
+bool lookupFail;
+double lookupDelay;
+
+void countingLookup(const std::string& account, pva::PeerInfo::roles_t& roles)
+{
+    unsigned n;
+    double delay;
+    {
+        Guard G(lookupLock);
+        if(lookupFail)
+            throw std::runtime_error("lookup failed");
+        n = ++lookupCalls;
+        delay = lookupDelay;
+    }
+    if(delay>0.0)
+        epicsThreadSleep(delay);
+
+    char buf[16];
+    sprintf(buf, "grp%u", n);
+    roles.insert(buf);
+}
+
+void resetLookup()
+{
+    Guard G(lookupLock);
+    lookupCalls = 0u;
+    lookupFail = false;
+    lookupDelay = 0.0;
+}
+
+unsigned calls()
+{
+    Guard G(lookupLock);
+    return lookupCalls;
+}
+
+bool hasRole(pva::RolesCache& C, const char *role)
+{
+    pva::PeerInfo::roles_t roles;
+    C.get("someone", roles);
+    testDiag("roles: %s", roles.empty() ? "<none>" : roles.begin()->c_str());
+    return roles.size()==1u && *roles.begin()==role;
+}
+
+void testDisabled()
+{
+    testDiag("testDisabled");
+    resetLookup();
+
+    pva::RolesCache C(0.0, &countingLookup);
+
+    testOk1(hasRole(C, "grp1"));
+    testOk1(hasRole(C, "grp2"));
+    testOk1(calls()==2u);
+}
+
+struct Getter : public epicsThreadRunable {
+    pva::RolesCache& C;
+    pva::PeerInfo::roles_t roles;
+    epicsThread thread;
+    explicit Getter(pva::RolesCache& C)
+        :C(C)
+        ,thread(*this, "getter", epicsThreadGetStackSize(epicsThreadStackSmall))
+    {}
+    virtual void run() OVERRIDE FINAL
+    {
+        C.get("someone", roles);
+    }
+};
+
+void testCoalesce()
+{
+    testDiag("testCoalesce");
+    resetLookup();
+    {
+        Guard G(lookupLock);
+        lookupDelay = 0.2;
+    }
+
+    pva::RolesCache C(10.0, &countingLookup);
+
+    Getter A(C), B(C), D(C);
+    A.thread.start();
+    B.thread.start();
+    D.thread.start();
+    A.thread.exitWait();
+    B.thread.exitWait();
+    D.thread.exitWait();
+
+    testOk(calls()==1u, "concurrent lookups call once.  calls=%u", calls());
+    testOk1(A.roles==B.roles && B.roles==D.roles && A.roles.size()==1u);
+    testOk1(hasRole(C, "grp1"));
+    testOk1(calls()==1u);
+}
+
+void testExpire()
+{
+    testDiag("testExpire");
+    resetLookup();
+
+    pva::RolesCache C(0.1, &countingLookup);
+
+    testOk1(hasRole(C, "grp1"));
+    epicsThreadSleep(0.2);
+
+    testDiag("Expired, returns previous roles, and refreshes");
+    testOk1(hasRole(C, "grp1"));
+    for(unsigned i=0; i<20u && calls()<2u; i++)
+        epicsThreadSleep(0.05);
+    testOk1(calls()==2u);
+    testOk1(hasRole(C, "grp2"));
+
+    testDiag("Failed refresh forgets the account");
+    {
+        Guard G(lookupLock);
+        lookupFail = true;
+    }
+    epicsThreadSleep(0.2);
+    testOk1(hasRole(C, "grp2"));
+    // give the refresher time to fail
+    epicsThreadSleep(0.2);
+
+    try {
+        pva::PeerInfo::roles_t roles;
+        C.get("someone", roles);
+        testFail("Returned %u stale roles", unsigned(roles.size()));
+    } catch(std::runtime_error& e) {
+        testPass("Lookup not cached: %s", e.what());
+    }
+
+    {
+        Guard G(lookupLock);
+        lookupFail = false;
+    }
+    testOk1(hasRole(C, "grp3"));
+}
+
+} // namespace
+
+MAIN(testRolesCache)
+{
+    testPlan(14);
+    testDisabled();
+    testCoalesce();
+    testExpire();
+    return testDone();
+}